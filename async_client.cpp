@@ -0,0 +1,371 @@
+/*
+ * P2P Micropayment System - Coroutine API (C++20)
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Implementation of the event loop, socket primitives and protocol flows
+ * declared in async_client.h. The wire format is identical to client.cpp.
+ */
+
+#include "async_client.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+using namespace std;
+
+#define BUFFER_SIZE 4096  // Maximum size for network messages
+
+// ============================================================================
+// EventLoop
+// ============================================================================
+
+EventLoop::EventLoop() : poll_fd(-1), active(0) {
+#ifdef __linux__
+    poll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (poll_fd == -1) {
+        perror("epoll_create1");
+    }
+#endif
+}
+
+EventLoop::~EventLoop() {
+    if (poll_fd != -1) {
+        close(poll_fd);
+    }
+}
+
+DetachedTask EventLoop::run_detached(EventLoop* loop, Task<void> task) {
+    co_await task;
+    loop->active--;
+}
+
+void EventLoop::spawn(Task<void> task) {
+    active++;
+    run_detached(this, std::move(task));
+}
+
+/*
+ * Wait FD
+ * Registers a one-shot interest so the coroutine is resumed once the socket
+ * becomes readable (or writable).
+ */
+void EventLoop::wait_fd(int fd, bool write, coroutine_handle<> h) {
+    Waiter waiter = { write, h };
+    waiters[fd] = waiter;
+#ifdef __linux__
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = (write ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+    ev.data.fd = fd;
+    // The fd may be new or may have been registered by an earlier wait
+    if (epoll_ctl(poll_fd, EPOLL_CTL_MOD, fd, &ev) == -1 &&
+        epoll_ctl(poll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        perror("epoll_ctl");
+        waiters.erase(fd);
+        schedule(h);  // Let the operation retry and see the error itself
+    }
+#endif
+}
+
+/*
+ * Dispatch
+ * Waits up to timeout_ms for socket events and resumes their coroutines.
+ */
+void EventLoop::dispatch(int timeout_ms) {
+    vector<coroutine_handle<>> resume;
+#ifdef __linux__
+    struct epoll_event events[256];
+    int n = epoll_wait(poll_fd, events, 256, timeout_ms);
+    for (int i = 0; i < n; i++) {
+        auto it = waiters.find(events[i].data.fd);
+        if (it != waiters.end()) {
+            resume.push_back(it->second.handle);
+            waiters.erase(it);
+        }
+    }
+#else
+    vector<struct pollfd> fds;
+    for (const auto& pair : waiters) {
+        struct pollfd p = { pair.first, (short)(pair.second.write ? POLLOUT : POLLIN), 0 };
+        fds.push_back(p);
+    }
+    int n = poll(fds.data(), fds.size(), timeout_ms);
+    for (int i = 0; n > 0 && i < (int)fds.size(); i++) {
+        if (fds[i].revents != 0) {
+            resume.push_back(waiters[fds[i].fd].handle);
+            waiters.erase(fds[i].fd);
+        }
+    }
+#endif
+    if (n == -1 && errno != EINTR) {
+        perror("event loop wait");
+    }
+    for (coroutine_handle<> h : resume) {
+        h.resume();
+    }
+}
+
+/*
+ * Run
+ * Drives ready coroutines, sockets and timers until every spawned task is done.
+ */
+void EventLoop::run() {
+    while (active > 0) {
+        while (!ready.empty()) {
+            coroutine_handle<> h = ready.front();
+            ready.pop_front();
+            h.resume();
+        }
+        if (active == 0) {
+            break;
+        }
+
+        // Sleep until the next socket event or the earliest timer
+        int timeout_ms = -1;
+        if (!ready.empty()) {
+            timeout_ms = 0;
+        } else if (!timers.empty()) {
+            auto wait = timers.begin()->first - chrono::steady_clock::now();
+            timeout_ms = max(0, (int)chrono::duration_cast<chrono::milliseconds>(wait).count() + 1);
+        }
+        dispatch(timeout_ms);
+
+        auto now = chrono::steady_clock::now();
+        while (!timers.empty() && timers.begin()->first <= now) {
+            coroutine_handle<> h = timers.begin()->second;
+            timers.erase(timers.begin());
+            h.resume();
+        }
+    }
+}
+
+void AsyncMutex::unlock() {
+    if (waiters.empty()) {
+        locked = false;
+        return;
+    }
+    // Ownership passes straight to the next waiter; it runs on the next iteration
+    coroutine_handle<> next = waiters.front();
+    waiters.pop_front();
+    loop.schedule(next);
+}
+
+// ============================================================================
+// Socket primitives
+// ============================================================================
+
+Task<int> async_connect(EventLoop& loop, struct sockaddr_in addr) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == -1) {
+        perror("socket");
+        co_return -1;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        co_return sock;
+    }
+    if (errno != EINPROGRESS) {
+        perror("connect");
+        close(sock);
+        co_return -1;
+    }
+
+    // Connection completes (or fails) when the socket becomes writable
+    co_await loop.writable(sock);
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0) {
+        errno = err;
+        perror("connect");
+        close(sock);
+        co_return -1;
+    }
+    co_return sock;
+}
+
+Task<bool> async_send(EventLoop& loop, int fd, string data) {
+    size_t offset = 0;
+    while (offset < data.length()) {
+        ssize_t sent = send(fd, data.c_str() + offset, data.length() - offset, 0);
+        if (sent > 0) {
+            offset += sent;
+        } else if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            co_await loop.writable(fd);
+        } else if (sent == -1 && errno == EINTR) {
+            continue;
+        } else {
+            perror("send");
+            co_return false;
+        }
+    }
+    co_return true;
+}
+
+Task<string> async_recv(EventLoop& loop, int fd) {
+    char buffer[BUFFER_SIZE];
+    while (true) {
+        ssize_t received = recv(fd, buffer, BUFFER_SIZE - 1, 0);
+        if (received > 0) {
+            co_return string(buffer, received);
+        }
+        if (received == 0) {
+            co_return string();
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await loop.readable(fd);
+        } else if (errno != EINTR) {
+            perror("recv");
+            co_return string();
+        }
+    }
+}
+
+// ============================================================================
+// AsyncSession
+// ============================================================================
+
+AsyncSession::~AsyncSession() {
+    if (fd != -1) {
+        close(fd);
+    }
+}
+
+Task<bool> AsyncSession::connect(string ip, int port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) <= 0) {
+        cout << "Invalid server address: " << ip << endl;
+        co_return false;
+    }
+    fd = co_await async_connect(loop, addr);
+    co_return fd != -1;
+}
+
+Task<string> AsyncSession::request(string message) {
+    // One exchange at a time: the protocol has no request IDs
+    co_await mutex.lock();
+    string response;
+    if (fd != -1) {
+        bool sent = co_await async_send(loop, fd, message);
+        if (sent) {
+            response = co_await async_recv(loop, fd);
+        }
+    }
+    mutex.unlock();
+    co_return response;
+}
+
+Task<bool> AsyncSession::register_user(string username, int amount) {
+    string response = co_await request(make_register_message(username, amount));
+    co_return response.find("100 OK") != string::npos;
+}
+
+Task<ListReply> AsyncSession::login(string username, int listen_port) {
+    string response = co_await request(make_login_message(username, listen_port));
+    co_return parse_list_reply(response);
+}
+
+Task<ListReply> AsyncSession::list() {
+    string response = co_await request(make_list_message());
+    co_return parse_list_reply(response);
+}
+
+Task<bool> AsyncSession::report(string sender, string recipient, int amount) {
+    string response = co_await request(make_transaction_message(sender, recipient, to_string(amount)));
+    co_return !response.empty();
+}
+
+Task<bool> AsyncSession::exit() {
+    string response = co_await request(make_exit_message());
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+    co_return response.find("Bye") != string::npos;
+}
+
+// ============================================================================
+// AsyncClient
+// ============================================================================
+
+void AsyncClient::apply(const ListReply& reply) {
+    balance = reply.balance;
+    online_users.clear();
+    for (const OnlineUser& user : reply.users) {
+        online_users[user.username] = user;
+    }
+}
+
+Task<bool> AsyncClient::login(string server_ip, int server_port, string user, int listen_port) {
+    bool connected = co_await session.connect(server_ip, server_port);
+    if (!connected) {
+        co_return false;
+    }
+    ListReply reply = co_await session.login(user, listen_port);
+    if (!reply.ok) {
+        co_return false;
+    }
+    username = user;
+    apply(reply);
+    co_return true;
+}
+
+Task<bool> AsyncClient::refresh() {
+    ListReply reply = co_await session.list();
+    if (reply.ok) {
+        apply(reply);
+    }
+    co_return reply.ok;
+}
+
+Task<bool> AsyncClient::transfer(string recipient, int amount, bool refresh_after) {
+    auto it = online_users.find(recipient);
+    if (it == online_users.end() || amount <= 0 || amount > balance) {
+        co_return false;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(it->second.port);
+    if (inet_pton(AF_INET, it->second.ip.c_str(), &addr.sin_addr) <= 0) {
+        co_return false;
+    }
+
+    // Deduct locally while the transfer is in flight so concurrent transfers
+    // on this loop cannot spend the same money; the next List corrects it
+    balance -= amount;
+    int peer_sock = co_await async_connect(loop, addr);
+    bool sent = false;
+    if (peer_sock != -1) {
+        sent = co_await async_send(loop, peer_sock, make_transfer_message(username, amount, recipient));
+        close(peer_sock);
+    }
+    if (!sent) {
+        balance += amount;
+        co_return false;
+    }
+
+    if (refresh_after) {
+        // Give the recipient time to report the transaction, without blocking the loop
+        co_await loop.sleep(500);
+        co_await refresh();
+    }
+    co_return true;
+}
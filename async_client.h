@@ -0,0 +1,276 @@
+/*
+ * P2P Micropayment System - Coroutine API (C++20)
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Asynchronous counterpart of the blocking menu flows in client.cpp. Every
+ * socket is non-blocking and every wait is a co_await on an EventLoop, so
+ * thousands of transfers and server requests can be in flight on one thread:
+ *
+ *     Task<void> pay(AsyncClient& client) {
+ *         co_await client.login("127.0.0.1", 12345, "alice", 9000);
+ *         co_await client.transfer("bob", 100);
+ *         ListReply reply = co_await client.session.list();
+ *     }
+ *
+ *     EventLoop loop;
+ *     AsyncClient client(loop);
+ *     loop.spawn(pay(client));
+ *     loop.run();
+ *
+ * Coroutine parameters are taken by value (or by reference to objects that
+ * outlive the task), never as references to temporaries.
+ * Store the result of a co_await in a local before testing it; GCC 12
+ * mis-compiles some co_await expressions used directly as if conditions.
+ *
+ * An EventLoop is single-threaded; to use several cores, run one loop per
+ * thread and give each its own AsyncClient (see async_transfer.cpp).
+ * Build with -std=c++20.
+ */
+
+#ifndef ASYNC_CLIENT_H
+#define ASYNC_CLIENT_H
+
+#include <coroutine>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <netinet/in.h>
+
+#include "protocol.h"
+
+class EventLoop;
+
+/*
+ * Task<T>
+ * Lazily started coroutine. It runs when awaited and resumes the awaiting
+ * coroutine when it finishes.
+ */
+template <typename T> class Task;
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { std::terminate(); }
+};
+
+template <typename T>
+class Task {
+public:
+    struct promise_type : TaskPromiseBase {
+        std::optional<T> value;
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_value(T v) { value = std::move(v); }
+    };
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task(const Task&) = delete;
+    ~Task() { if (handle) handle.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() { return std::move(*handle.promise().value); }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <>
+class Task<void> {
+public:
+    struct promise_type : TaskPromiseBase {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_void() {}
+    };
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task(const Task&) = delete;
+    ~Task() { if (handle) handle.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    void await_resume() {}
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Fire-and-forget coroutine used by EventLoop::spawn()
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return DetachedTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/*
+ * EventLoop
+ * Waits for socket readiness (epoll on Linux, poll elsewhere) and timers,
+ * and resumes the coroutines waiting on them.
+ */
+class EventLoop {
+public:
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+
+    // Start a top-level task; run() returns once all spawned tasks finished
+    void spawn(Task<void> task);
+    void run();
+
+    // Resume a coroutine on the next loop iteration
+    void schedule(std::coroutine_handle<> h) { ready.push_back(h); }
+
+    // co_await loop.readable(fd) / loop.writable(fd) / loop.sleep(ms)
+    struct FdAwaiter {
+        EventLoop* loop;
+        int fd;
+        bool write;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop->wait_fd(fd, write, h); }
+        void await_resume() const noexcept {}
+    };
+    struct SleepAwaiter {
+        EventLoop* loop;
+        std::chrono::milliseconds delay;
+        bool await_ready() const noexcept { return delay.count() <= 0; }
+        void await_suspend(std::coroutine_handle<> h) {
+            loop->timers.insert(std::make_pair(std::chrono::steady_clock::now() + delay, h));
+        }
+        void await_resume() const noexcept {}
+    };
+    FdAwaiter readable(int fd) { return FdAwaiter{this, fd, false}; }
+    FdAwaiter writable(int fd) { return FdAwaiter{this, fd, true}; }
+    SleepAwaiter sleep(int ms) { return SleepAwaiter{this, std::chrono::milliseconds(ms)}; }
+
+private:
+    struct Waiter {
+        bool write;
+        std::coroutine_handle<> handle;
+    };
+
+    void wait_fd(int fd, bool write, std::coroutine_handle<> h);
+    void dispatch(int timeout_ms);
+    static DetachedTask run_detached(EventLoop* loop, Task<void> task);
+
+    int poll_fd;                            // epoll instance (Linux only)
+    std::map<int, Waiter> waiters;          // fd -> coroutine waiting on it
+    std::multimap<std::chrono::steady_clock::time_point, std::coroutine_handle<>> timers;
+    std::deque<std::coroutine_handle<>> ready;
+    int active;                             // spawned tasks still running
+};
+
+/*
+ * AsyncMutex
+ * Serializes coroutines without blocking the thread; used to keep one
+ * request/response exchange at a time on the server session.
+ */
+class AsyncMutex {
+public:
+    explicit AsyncMutex(EventLoop& loop) : loop(loop), locked(false) {}
+
+    struct LockAwaiter {
+        AsyncMutex* mutex;
+        bool await_ready() {
+            if (!mutex->locked) {
+                mutex->locked = true;
+                return true;
+            }
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> h) { mutex->waiters.push_back(h); }
+        void await_resume() const noexcept {}
+    };
+    LockAwaiter lock() { return LockAwaiter{this}; }
+
+    // Hands the lock directly to the next waiter, if any
+    void unlock();
+
+private:
+    EventLoop& loop;
+    bool locked;
+    std::deque<std::coroutine_handle<>> waiters;
+};
+
+// Non-blocking socket primitives
+Task<int> async_connect(EventLoop& loop, struct sockaddr_in addr);  // fd, or -1
+Task<bool> async_send(EventLoop& loop, int fd, std::string data);
+Task<std::string> async_recv(EventLoop& loop, int fd);               // "" on EOF/error
+
+/*
+ * AsyncSession
+ * Persistent connection to the server (coroutine version of session.h). Requests from any number of
+ * coroutines are queued on an AsyncMutex and run one at a time.
+ */
+class AsyncSession {
+public:
+    explicit AsyncSession(EventLoop& loop) : loop(loop), fd(-1), mutex(loop) {}
+    ~AsyncSession();
+
+    Task<bool> connect(std::string ip, int port);
+    Task<std::string> request(std::string message);   // "" if the server did not answer
+    Task<bool> register_user(std::string username, int amount);
+    Task<ListReply> login(std::string username, int listen_port);
+    Task<ListReply> list();
+    Task<bool> report(std::string sender, std::string recipient, int amount);
+    Task<bool> exit();
+
+private:
+    EventLoop& loop;
+    int fd;
+    AsyncMutex mutex;
+};
+
+/*
+ * AsyncClient
+ * Logged-in user state plus the transfer flow of handle_transfer().
+ */
+class AsyncClient {
+public:
+    explicit AsyncClient(EventLoop& loop) : session(loop), username(""), balance(0), loop(loop) {}
+
+    Task<bool> login(std::string server_ip, int server_port, std::string user, int listen_port);
+    Task<bool> refresh();    // List and apply balance / online users
+
+    // Pays a recipient from online_users: connect, send, close, and (as the
+    // menu does) wait 500 ms and refresh from the server if refresh_after.
+    Task<bool> transfer(std::string recipient, int amount, bool refresh_after = true);
+
+    AsyncSession session;
+    std::string username;
+    int balance;
+    std::map<std::string, OnlineUser> online_users;
+
+private:
+    void apply(const ListReply& reply);
+    EventLoop& loop;
+};
+
+#endif
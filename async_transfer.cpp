@@ -0,0 +1,130 @@
+/*
+ * P2P Micropayment System - Concurrent Transfer Tool (C++20 coroutines)
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Logs in once, then runs many transfers to one recipient concurrently using
+ * the coroutine API in async_client.h. Transfers are spread over a few event
+ * loop threads; within a loop, every transfer is a coroutine, so thousands of
+ * them can be in flight without a thread each.
+ *
+ * Usage: ./async_transfer <server_ip> <server_port> <username> <listen_port>
+ *                         <recipient> <count> [--threads N] [--amount A]
+ */
+
+#include "async_client.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+atomic<int> succeeded(0);
+atomic<int> failed(0);
+
+/*
+ * Log In
+ * Connects to the server and logs in on the first event loop.
+ */
+Task<void> log_in(AsyncClient& client, string ip, int port, string user, int listen_port, bool* ok) {
+    *ok = co_await client.login(ip, port, user, listen_port);
+}
+
+/*
+ * Pay
+ * One transfer; the balance refresh is done once at the end instead.
+ */
+Task<void> pay(AsyncClient& client, string recipient, int amount) {
+    bool ok = co_await client.transfer(recipient, amount, false);
+    if (ok) {
+        succeeded++;
+    } else {
+        failed++;
+    }
+}
+
+/*
+ * Finish
+ * Refreshes balance once all transfers are done and logs out.
+ */
+Task<void> finish(EventLoop& loop, AsyncClient& client) {
+    // Same 500 ms grace period the menu uses for the recipient's report
+    co_await loop.sleep(500);
+    co_await client.refresh();
+    cout << "Balance after transfers: $" << client.balance << endl;
+    co_await client.session.exit();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 7) {
+        cout << "Usage: " << argv[0] << " <server_ip> <server_port> <username> <listen_port>"
+             << " <recipient> <count> [--threads N] [--amount A]" << endl;
+        return 1;
+    }
+    string server_ip = argv[1];
+    int server_port = atoi(argv[2]);
+    string user = argv[3];
+    int listen_port = atoi(argv[4]);
+    string recipient = argv[5];
+    int count = atoi(argv[6]);
+    int num_threads = 2;
+    int amount = 1;
+    for (int i = 7; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--threads") {
+            num_threads = max(1, atoi(argv[i + 1]));
+        } else if (arg == "--amount") {
+            amount = atoi(argv[i + 1]);
+        }
+    }
+
+    // Log in on the main loop to get balance and the online user list
+    EventLoop main_loop;
+    AsyncClient main_client(main_loop);
+    bool logged_in = false;
+    main_loop.spawn(log_in(main_client, server_ip, server_port, user, listen_port, &logged_in));
+    main_loop.run();
+    if (!logged_in) {
+        cout << "Login failed." << endl;
+        return 1;
+    }
+    if (main_client.online_users.find(recipient) == main_client.online_users.end()) {
+        cout << "User not found or not online." << endl;
+        return 1;
+    }
+    cout << "Logged in as " << user << ", balance $" << main_client.balance << endl;
+
+    // Each worker loop gets its own copy of the directory and a share of the balance
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < num_threads; t++) {
+        int share = count / num_threads + (t < count % num_threads ? 1 : 0);
+        workers.push_back(thread([&, share]() {
+            EventLoop loop;
+            AsyncClient client(loop);
+            client.username = main_client.username;
+            client.online_users = main_client.online_users;
+            client.balance = main_client.balance / num_threads;
+            for (int i = 0; i < share; i++) {
+                loop.spawn(pay(client, recipient, amount));
+            }
+            loop.run();
+        }));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Transfers:  " << succeeded << " succeeded, " << failed << " failed in " << elapsed << " s" << endl;
+    cout << "Throughput: " << (elapsed > 0 ? succeeded / elapsed : 0) << " transfers/s on "
+         << num_threads << " threads" << endl;
+
+    main_loop.spawn(finish(main_loop, main_client));
+    main_loop.run();
+    return 0;
+}
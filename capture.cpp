@@ -0,0 +1,119 @@
+/*
+ * P2P Micropayment System - Traffic Capture
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "capture.h"
+
+using namespace std;
+
+static void append_varint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += (char)((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+CaptureLog::CaptureLog() : active(false), record_count(0), byte_count(0) {}
+
+bool CaptureLog::open(const string& path, string& error) {
+    lock_guard<mutex> lock(file_mutex);
+    file.open(path.c_str(), ios::out | ios::trunc | ios::binary);
+    if (!file.is_open()) {
+        error = "Cannot create capture log " + path;
+        return false;
+    }
+    file.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC) - 1);
+    last = chrono::steady_clock::now();
+    active = true;
+    return true;
+}
+
+/*
+ * Record
+ * The time is taken under the lock, so the deltas in the log never go
+ * backwards even when threads race for it.
+ */
+void CaptureLog::record(CaptureChannel channel, CaptureDirection direction, const string& message) {
+    if (!active) {
+        return;
+    }
+    lock_guard<mutex> lock(file_mutex);
+    if (!file.is_open()) {
+        return;
+    }
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    buffer.clear();
+    append_varint(buffer, (uint64_t)chrono::duration_cast<chrono::microseconds>(now - last).count());
+    buffer += (char)((channel << 1) | direction);
+    append_varint(buffer, message.size());
+    file.write(buffer.data(), buffer.size());
+    file.write(message.data(), message.size());
+    last = now;
+    record_count++;
+    byte_count += message.size();
+}
+
+void CaptureLog::close() {
+    active = false;
+    lock_guard<mutex> lock(file_mutex);
+    if (file.is_open()) {
+        file.close();
+    }
+}
+
+CaptureReader::CaptureReader() : time_us(0) {}
+
+bool CaptureReader::open(const string& path, string& error) {
+    file.open(path.c_str(), ios::in | ios::binary);
+    if (!file.is_open()) {
+        error = "Cannot open capture log " + path;
+        return false;
+    }
+    char magic[sizeof(CAPTURE_MAGIC) - 1];
+    if (!file.read(magic, sizeof(magic)) || string(magic, sizeof(magic)) != CAPTURE_MAGIC) {
+        error = path + " is not a capture log";
+        return false;
+    }
+    time_us = 0;
+    return true;
+}
+
+bool CaptureReader::read_varint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = file.get();
+        if (byte == EOF) {
+            return false;
+        }
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    uint64_t delta, length;
+    if (file.peek() == EOF) {
+        return false;  // Clean end of the log
+    }
+    int kind;
+    if (!read_varint(delta) || (kind = file.get()) == EOF || (kind >> 1) > CAPTURE_P2P || !read_varint(length) ||
+        length > CAPTURE_MAX_RECORD) {
+        read_error = "Corrupt record";
+        return false;
+    }
+    record.data.resize(length);
+    if (length > 0 && !file.read(&record.data[0], length)) {
+        read_error = "Truncated record";
+        return false;
+    }
+    time_us += delta;
+    record.time_us = time_us;
+    record.channel = (CaptureChannel)(kind >> 1);
+    record.direction = (CaptureDirection)(kind & 1);
+    return true;
+}
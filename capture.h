@@ -0,0 +1,98 @@
+/*
+ * P2P Micropayment System - Traffic Capture
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Records every framed message a client exchanges, on the server session
+ * and on P2P sockets, so the exact mix of a busy run can be replayed later
+ * against a new build (see replay.cpp).
+ *
+ * Log format: the 8-byte magic "P2PCAP1\n", then one record per message:
+ *   varint   microseconds since the previous record (the first: since open())
+ *   byte     channel << 1 | direction
+ *   varint   length
+ *   bytes    the message exactly as sent or received (sealed frames stay sealed)
+ * Varints are little-endian base 128, so a small List request costs a few
+ * bytes of overhead. Records are in the order they were taken, from any
+ * thread.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+#define CAPTURE_MAGIC "P2PCAP1\n"
+#define CAPTURE_MAX_RECORD 1048576  // Longest message a reader accepts
+
+enum CaptureChannel {
+    CAPTURE_SERVER = 0,   // Server session: requests, replies and pushed events
+    CAPTURE_P2P = 1       // Transfer and gossip frames to and from other clients
+};
+
+enum CaptureDirection {
+    CAPTURE_OUT = 0,      // Sent by the capturing client
+    CAPTURE_IN = 1        // Received by it
+};
+
+struct CaptureRecord {
+    uint64_t time_us;     // Since the start of the capture
+    CaptureChannel channel;
+    CaptureDirection direction;
+    std::string data;
+};
+
+class CaptureLog {
+public:
+    CaptureLog();
+
+    // Starts a new log at path (truncated).
+    // Returns: false (and sets error) if the file cannot be created
+    bool open(const std::string& path, std::string& error);
+    bool is_open() const { return active; }
+
+    // Appends one message. Does nothing unless open. Thread-safe.
+    void record(CaptureChannel channel, CaptureDirection direction, const std::string& message);
+
+    // Flushes and closes the file; later records are ignored
+    void close();
+
+    unsigned long records() const { return record_count; }
+    unsigned long long bytes() const { return byte_count; }
+
+private:
+    std::atomic<bool> active;
+    std::mutex file_mutex;
+    std::ofstream file;
+    std::chrono::steady_clock::time_point last;  // Time of the previous record
+    std::string buffer;                          // Record being encoded (reused)
+    std::atomic<unsigned long> record_count;
+    std::atomic<unsigned long long> byte_count;  // Message bytes, without the record headers
+};
+
+class CaptureReader {
+public:
+    CaptureReader();
+
+    // Returns: false (and sets error) if path cannot be read or is not a capture log
+    bool open(const std::string& path, std::string& error);
+
+    // Reads the next record.
+    // Returns: false at the end of the log, or if the rest of it is
+    //          truncated or corrupt (error() then says so)
+    bool next(CaptureRecord& record);
+    const std::string& error() const { return read_error; }
+
+private:
+    bool read_varint(uint64_t& value);
+
+    std::ifstream file;
+    uint64_t time_us;
+    std::string read_error;
+};
+
+#endif
@@ -6,185 +6,515 @@
  * - Server handles user registration, authentication, and account management
  * - Money transfers happen directly between clients (P2P), not through server
  * - Multi-threaded design allows simultaneous operations
+ *
+ * This file is only the interactive menu. The networking, the protocol and
+ * the account state live in libp2ppay.a (see p2ppay.h and payment_client.h).
  */
 
 #include <iostream>
 #include <string>
-#include <cstring>
-#include <algorithm>
 #include <vector>
-#include <map>
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <fstream>
 #include <sstream>
-#include <sys/socket.h>
- #include <netinet/in.h>
- #include <arpa/inet.h>
- #include <unistd.h>
- #include <errno.h>
- 
- using namespace std;
- 
- // Constants
- #define BUFFER_SIZE 4096  // Maximum size for network messages
- #define CRLF "\r\n"       // Carriage Return + Line Feed (protocol requirement)
- 
- // Global variables for network connections
- int server_socket = -1;   // Socket for persistent connection to server
- int listen_socket = -1;   // Socket for listening to P2P connections from other clients
- string username = "";     // Current logged-in username
- string server_ip = "";    // Server's IP address
- int server_port = 0;      // Server's port number
- int my_port = 0;          // Our listening port for P2P connections
- 
- // Global variables for account state
- int account_balance = 10000;        // Current account balance (initialized with default)
- string server_public_key = "";      // Server's public key (for Phase 2)
- bool is_logged_in = false;          // Login status flag
- bool is_running = true;             // Main loop control flag
- 
- // Mutex locks for thread synchronization
- mutex cout_mutex;    // Protects console output from multiple threads
- mutex socket_mutex;  // Protects server_socket from concurrent access
- 
- // Structure to hold online user information
- struct OnlineUser {
-     string username;  // User's account name
-     string ip;        // User's IP address
-     int port;         // User's listening port for P2P connections
- };
- 
- // Map to store all currently online users (username -> OnlineUser)
- map<string, OnlineUser> online_users;
- mutex users_mutex;  // Protects online_users map from concurrent access
- 
- // Function prototypes
- void print_menu();
- void handle_register();
- void handle_login();
- void handle_list();
- void handle_transfer();
- void handle_exit();
- int connect_to_server(const string& ip, int port);
- bool send_message(int sock, const string& message);
- string receive_message(int sock);
- void parse_online_list(const string& response);
- void listener_thread();
- void handle_client_connection(int client_sock);
- void safe_print(const string& message);
- 
- /*
-  * Main Function
-  * Sets up initial configuration, starts P2P listener thread,
-  * and runs the main menu loop for user interaction.
-  */
- int main() {
-     cout << "========================================" << endl;
-     cout << "   P2P Micropayment System - Client    " << endl;
-     cout << "========================================" << endl;
-     cout << endl;
- 
-     // Get server connection information from user
-     cout << "Enter Server IP address: ";
-     getline(cin, server_ip);
-     
-     cout << "Enter Server Port: ";
-     string port_str;
-     getline(cin, port_str);
-     server_port = stoi(port_str);
- 
-   // Get our listening port for accepting P2P connections
-   cout << "Enter your listening port for P2P connections: ";
-   getline(cin, port_str);
-   my_port = stoi(port_str);
-
-   // ============================================================================
-   // IMPORTANT: Establish persistent connection to server at startup
-   // ============================================================================
-   // The TA's server expects a persistent connection model:
-   // 1. Connect to server when program starts
-   // 2. Use this SAME connection for ALL operations (Register, Login, List, etc.)
-   // 3. Keep connection open until Exit
-   //
-   // If we create temporary connections, the server may terminate.
-   //
-   // 重要：在程式啟動時建立持久連線
-   // 助教的 server 期望持久連線模式：
-   // 1. 程式啟動時連接到 server
-   // 2. 所有操作（註冊、登入、查詢等）都使用同一個連線
-   // 3. 保持連線直到離線
-   //
-   // 如果建立臨時連線，server 可能會終止。
-   // ============================================================================
-   cout << "\nConnecting to server..." << endl;
-   server_socket = connect_to_server(server_ip, server_port);
-   if (server_socket == -1) {
-       cout << "Failed to connect to server. Exiting." << endl;
-       return 1;
-   }
-   cout << "Connected to server successfully!" << endl;
-   cout << "You can now Register (if new user) or Login (if existing user)." << endl;
-
-    // Start listener thread for P2P connections in background
-    // This thread will accept incoming transfer requests from other clients
-    thread listener(listener_thread);
-    listener.detach();  // Detach so it runs independently
+#include "p2ppay.h"
+
+using namespace std;
+
+// Command-line options
+int listener_shards = 0;          // Number of SO_REUSEPORT listener shards (0 = single accept thread)
+bool quiet_transfers = false;     // Suppress per-transfer notifications (useful under load)
+string io_backend_name = "auto";  // Socket I/O backend for shards and the server session
+string key_file = "";             // Network key for encrypted transfers ("" = cleartext)
+CipherSuite cipher_suite = CIPHER_AES_256_GCM;
+string signing_key_file = "";     // Our Ed25519 key for signing transfers ("" = unsigned)
+string trusted_keys_dir = "";     // Senders' public keys ("" = signatures not checked)
+int verify_threads = -1;          // Extra signature verification threads (-1 = one per extra core)
+int transfer_retries = TRANSFER_RETRIES;            // Extra attempts of a failed outgoing transfer
+bool transfer_ids = false;                           // Append a transfer ID to outgoing transfer frames
+int send_threads = SEND_THREADS;                    // Threads dialing peers for a batch of transfers
+bool local_transport = true;                         // Unix domain socket for peers on this host
+bool use_datagrams = false;                          // Send and receive transfers over UDP
+bool push_updates = false;                           // Subscribe to online-list changes instead of polling List
+int gossip_interval = 0;                             // Milliseconds between gossip rounds (0 = no gossip)
+int gossip_fanout = GOSSIP_FANOUT;                   // Peers per gossip round
+size_t dedup_capacity = IDEMPOTENCY_CAPACITY;       // Incoming transfer IDs remembered
+int dedup_window = IDEMPOTENCY_WINDOW;              // Seconds an incoming transfer ID is remembered
+int shutdown_timeout = SHUTDOWN_TIMEOUT_MS;         // Time Exit spends draining transfers and reports
+int heartbeat_interval = HEARTBEAT_INTERVAL;       // Seconds of silence before the server is pinged
+int keepalive_timeout = KEEPALIVE_TIMEOUT;         // Seconds until the kernel gives up on a silent server
+string socket_profile_name = DEFAULT_SOCKET_PROFILE; // Socket options for every connection
+int socket_rcvbuf = 0;            // SO_RCVBUF override (0 = the profile's)
+int socket_sndbuf = 0;            // SO_SNDBUF override (0 = the profile's)
+int busy_poll_us = -1;            // SO_BUSY_POLL override (-1 = the profile's)
+bool tcp_fastopen = false;        // Add TCP Fast Open to the profile
+SettlementMode settlement_mode = SETTLE_OFF;       // Report transfers in bulk instead of one by one
+int settle_window = SETTLE_WINDOW_MS;             // Milliseconds between settlements
+long long settle_threshold = 0;   // Settle a counterparty early at this amount (0 = window only)
+string journal_file = "";         // Per-transfer detail of settled transfers ("" = none)
+string capture_file = "";         // Log of every message sent and received ("" = none)
+
+PaymentClient client;   // Session, directory, ledger and P2P listener
+bool is_running = true; // Main loop control flag
+mutex cout_mutex;       // Protects console output from multiple threads
+
+// Function prototypes
+void print_menu();
+void handle_register();
+void handle_login();
+void handle_list();
+void handle_transfer();
+void handle_split();
+void handle_exit();
+const char* transfer_status_text(TransferStatus status);
+void print_list_reply(const ListReply& reply);
+bool show_local_state();
+void safe_print(const string& message);
+void print_usage(const char* prog);
+bool parse_options(int argc, char* argv[]);
+void on_incoming_transfer(const TransferFrame& transfer, int new_balance);
+void on_report(const string& report, const string& response);
+void on_directory_event(const DirectoryEvent& event);
+
+/*
+ * Main Function
+ * Sets up initial configuration, starts P2P listener thread,
+ * and runs the main menu loop for user interaction.
+ */
+int main(int argc, char* argv[]) {
+    // Command-line options only tune the P2P listener; all connection
+    // information is still entered interactively below.
+    if (!parse_options(argc, argv)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    cout << "========================================" << endl;
+    cout << "   P2P Micropayment System - Client    " << endl;
+    cout << "========================================" << endl;
+    cout << endl;
+
+    // Get server connection information from user
+    string server_ip;
+    cout << "Enter Server IP address: ";
+    getline(cin, server_ip);
+
+    cout << "Enter Server Port: ";
+    string port_str;
+    getline(cin, port_str);
+    int server_port = stoi(port_str);
+
+    // Get our listening port for accepting P2P connections
+    cout << "Enter your listening port for P2P connections: ";
+    getline(cin, port_str);
+    int my_port = stoi(port_str);
+
+    if (!capture_file.empty()) {
+        string error;
+        if (!client.enable_capture(capture_file, error)) {
+            cout << "Cannot enable capture: " << error << endl;
+            return 1;
+        }
+        cout << "Capturing all messages in " << capture_file << endl;
+    }
+    if (!key_file.empty()) {
+        string error;
+        if (!client.enable_encryption(key_file, cipher_suite, error)) {
+            cout << "Cannot enable encryption: " << error << endl;
+            return 1;
+        }
+        cout << "P2P transfers are encrypted with " << cipher_suite_name(cipher_suite) << endl;
+    }
+    if (!signing_key_file.empty()) {
+        string error;
+        if (!client.enable_signing(signing_key_file, error)) {
+            cout << "Cannot enable signing: " << error << endl;
+            return 1;
+        }
+        cout << "Outgoing P2P transfers are signed" << endl;
+    }
+    if (!trusted_keys_dir.empty()) {
+        string error;
+        if (!client.require_signatures(trusted_keys_dir, verify_threads, error)) {
+            cout << "Cannot load trusted keys: " << error << endl;
+            return 1;
+        }
+        cout << "Incoming P2P transfers must be signed by a trusted key" << endl;
+    }
+    if (settlement_mode != SETTLE_OFF) {
+        string error;
+        if (!client.enable_settlement(settlement_mode, settle_window, settle_threshold, journal_file, error)) {
+            cout << "Cannot enable settlement: " << error << endl;
+            return 1;
+        }
+        cout << "Transfers are " << (settlement_mode == SETTLE_NET ? "netted" : "aggregated")
+             << " and settled with the server every " << settle_window << " ms" << endl;
+    }
+
+    if (use_datagrams) {
+        string error;
+        if (!client.enable_datagrams(error)) {
+            cout << "Cannot enable datagrams: " << error << endl;
+            return 1;
+        }
+        cout << "P2P transfers are sent as UDP datagrams" << endl;
+    }
+
+    if (gossip_interval > 0) {
+        string error;
+        if (!client.enable_gossip(gossip_interval, gossip_fanout, error)) {
+            cout << "Cannot enable gossip: " << error << endl;
+            return 1;
+        }
+        cout << "The online list is kept current by gossip every " << gossip_interval << " ms" << endl;
+    }
+
+    client.set_transfer_retries(transfer_retries);
+    client.set_transfer_ids(transfer_ids);
+    client.set_send_threads(send_threads);
+    client.set_local_transport(local_transport);
+    client.set_heartbeat(heartbeat_interval);
+    client.set_keepalive(keepalive_timeout);
+    client.configure_duplicate_filter(dedup_capacity, dedup_window);
+    client.on_incoming_transfer = on_incoming_transfer;
+    client.on_report = on_report;
+    client.on_log = safe_print;
+    client.on_directory_event = on_directory_event;
+
+    // ============================================================================
+    // IMPORTANT: Establish persistent connection to server at startup
+    // ============================================================================
+    // The TA's server expects a persistent connection model:
+    // 1. Connect to server when program starts
+    // 2. Use this SAME connection for ALL operations (Register, Login, List, etc.)
+    // 3. Keep connection open until Exit
+    //
+    // If we create temporary connections, the server may terminate.
+    //
+    // 重要：在程式啟動時建立持久連線
+    // 助教的 server 期望持久連線模式：
+    // 1. 程式啟動時連接到 server
+    // 2. 所有操作（註冊、登入、查詢等）都使用同一個連線
+    // 3. 保持連線直到離線
+    //
+    // 如果建立臨時連線，server 可能會終止。
+    // ============================================================================
+    cout << "\nConnecting to server..." << endl;
+    if (!client.connect(server_ip, server_port, io_backend_name)) {
+        cout << "Failed to connect to server. Exiting." << endl;
+        return 1;
+    }
+    cout << "Connected to server successfully!" << endl;
+    cout << "You can now Register (if new user) or Login (if existing user)." << endl;
+
+    // Start listener for P2P connections in background
+    // It will accept incoming transfer requests from other clients
+    if (!client.start_listener(my_port, listener_shards, io_backend_name)) {
+        cout << "Failed to listen for P2P transfers on port " << my_port << ". Exiting." << endl;
+        client.logout();
+        return 1;
+    }
 
     // Give listener thread time to initialize and start listening
     this_thread::sleep_for(chrono::milliseconds(500));
 
     // Main menu loop - continues until user chooses to exit
-     while (is_running) {
-         print_menu();
-         
-         string choice;
-         cout << "\nEnter your choice: ";
-         getline(cin, choice);
- 
-         // Dispatch to appropriate handler based on user choice
-         if (choice == "1") {
-             handle_register();
-         } else if (choice == "2") {
-             handle_login();
-         } else if (choice == "3") {
-             handle_list();
-         } else if (choice == "4") {
-             handle_transfer();
-         } else if (choice == "5") {
-             handle_exit();
-         } else {
-             cout << "Invalid choice. Please try again." << endl;
-         }
-     }
- 
-     // Cleanup: close all sockets before exiting
-     if (server_socket != -1) {
-         close(server_socket);
-     }
-     if (listen_socket != -1) {
-         close(listen_socket);
-     }
- 
-     return 0;
- }
- 
- /*
-  * Print Main Menu
-  * Displays available options to the user
-  */
- void print_menu() {
-     cout << "\n========================================" << endl;
-     cout << "              Main Menu                 " << endl;
-     cout << "========================================" << endl;
-     cout << "1. Register" << endl;
-     cout << "2. Login" << endl;
-     cout << "3. List (Get account balance and online users)" << endl;
-     cout << "4. Transfer money to another user" << endl;
-     cout << "5. Exit" << endl;
-     cout << "========================================" << endl;
- }
- 
+    while (is_running) {
+        print_menu();
+
+        string choice;
+        cout << "\nEnter your choice: ";
+        getline(cin, choice);
+
+        // Dispatch to appropriate handler based on user choice
+        if (choice == "1") {
+            handle_register();
+        } else if (choice == "2") {
+            handle_login();
+        } else if (choice == "3") {
+            handle_list();
+        } else if (choice == "4") {
+            handle_transfer();
+        } else if (choice == "5") {
+            handle_exit();
+        } else if (choice == "6") {
+            handle_split();
+        } else {
+            cout << "Invalid choice. Please try again." << endl;
+        }
+    }
+
+    // Cleanup: stop the listener and the reporter before exiting (already done by Exit)
+    client.shutdown(shutdown_timeout);
+    return 0;
+}
+
+/*
+ * Print Usage
+ * Shows the optional command-line flags.
+ */
+void print_usage(const char* prog) {
+    cout << "Usage: " << prog << " [options]" << endl;
+    cout << "  --listener-shards N  Accept P2P transfers on N SO_REUSEPORT listeners," << endl;
+    cout << "                       each pinned to a core with its own event loop" << endl;
+    cout << "  --io-backend NAME    Socket I/O for shards and the server session:" << endl;
+    cout << "                       uring, epoll, poll or auto (default: auto, epoll on Linux, else poll)" << endl;
+    cout << "  --key-file PATH      Encrypt P2P transfers with the network key in PATH" << endl;
+    cout << "                       (all clients must use the same file) and reject cleartext ones" << endl;
+    cout << "  --cipher NAME        aes-256-gcm (default) or chacha20-poly1305" << endl;
+    cout << "  --signing-key PATH   Sign P2P transfers with the Ed25519 private key in PATH (PEM)" << endl;
+    cout << "  --trusted-keys DIR   Only accept P2P transfers signed by a key in DIR/<username>.pub" << endl;
+    cout << "  --verify-threads N   Extra threads for verifying signatures (default: one per extra core)" << endl;
+    cout << "  --transfer-ids       Send sender#amount#recipient#id so receivers drop retried copies" << endl;
+    cout << "                       (implied by --signing-key and --datagram; peers that only speak" << endl;
+    cout << "                       the course protocol reject it)" << endl;
+    cout << "  --transfer-retries N Retry a failed transfer N times (default: " << TRANSFER_RETRIES << ");" << endl;
+    cout << "                       without transfer IDs only a failed connect is retried" << endl;
+    cout << "  --send-threads N     Threads dialing peers when several transfers go out at once (default: "
+         << SEND_THREADS << ")" << endl;
+    cout << "  --datagram           Send and receive P2P transfers as acknowledged UDP datagrams (TCP fallback)"
+         << endl;
+    cout << "  --no-local-transport Reach peers on this host over TCP instead of a Unix domain socket" << endl;
+    cout << "  --dedup-window S     Drop an incoming transfer whose ID was seen in the last S seconds (default: "
+         << IDEMPOTENCY_WINDOW << ")" << endl;
+    cout << "  --dedup-capacity N   Remember up to N incoming transfer IDs (default: " << IDEMPOTENCY_CAPACITY << ")"
+         << endl;
+    cout << "  --shutdown-timeout MS Time Exit waits for transfers in progress and their reports (default: "
+         << SHUTDOWN_TIMEOUT_MS << ")" << endl;
+    cout << "  --heartbeat S        Ping the server after S idle seconds; reconnect and log in again" << endl;
+    cout << "                       when the connection is lost (default: " << HEARTBEAT_INTERVAL << ", 0 = off)"
+         << endl;
+    cout << "  --keepalive S        Let the kernel declare a silent server dead after about S seconds (default: "
+         << KEEPALIVE_TIMEOUT << ", 0 = off)" << endl;
+    cout << "  --settle-window MS   Report incoming transfers as one TRANSACTION per sender every MS" << endl;
+    cout << "                       milliseconds (default: one TRANSACTION per transfer)" << endl;
+    cout << "  --settle-threshold N Settle a sender early once its total reaches N" << endl;
+    cout << "  --settle-net         Net transfers in both directions per pair of users" << endl;
+    cout << "                       (all clients must use it; implies settlement)" << endl;
+    cout << "  --journal PATH       Append every settled transfer to PATH" << endl;
+    cout << "  --socket-profile NAME Socket options: kernel, low-latency, busy-poll or fastopen (default: "
+         << DEFAULT_SOCKET_PROFILE << ")" << endl;
+    cout << "  --rcvbuf BYTES       Fixed socket receive buffer size" << endl;
+    cout << "  --sndbuf BYTES       Fixed socket send buffer size" << endl;
+    cout << "  --busy-poll US       Busy-poll the device queue for US microseconds before sleeping" << endl;
+    cout << "  --fastopen           Send transfers with TCP Fast Open (needs net.ipv4.tcp_fastopen = 3)" << endl;
+    cout << "  --push-updates       Have the server push users joining and leaving and balance changes" << endl;
+    cout << "                       after login, instead of polling it with List" << endl;
+    cout << "  --gossip             Learn about users joining and leaving from the other clients" << endl;
+    cout << "                       instead of List (all clients should use it; needs --key-file)" << endl;
+    cout << "  --gossip-interval MS Milliseconds between gossip rounds (default: " << GOSSIP_INTERVAL_MS << ")"
+         << endl;
+    cout << "  --gossip-fanout N    Peers per gossip round (default: " << GOSSIP_FANOUT << ")" << endl;
+    cout << "  --capture PATH       Record every server and P2P message in PATH for ./replay" << endl;
+    cout << "  --quiet              Do not print notifications for incoming transfers and users coming" << endl;
+    cout << "                       online or going offline" << endl;
+    cout << "  --help               Show this message" << endl;
+}
+
+/*
+ * Parse Command-Line Options
+ * Returns: false if an option is unknown or malformed
+ */
+bool parse_options(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--listener-shards" && i + 1 < argc) {
+            listener_shards = atoi(argv[++i]);
+            if (listener_shards < 1) {
+                cout << "--listener-shards must be at least 1" << endl;
+                return false;
+            }
+        } else if (arg == "--io-backend" && i + 1 < argc) {
+            io_backend_name = argv[++i];
+            if (io_backend_name != "uring" && io_backend_name != "epoll" && io_backend_name != "poll" &&
+                io_backend_name != "auto") {
+                cout << "Unknown I/O backend: " << io_backend_name << endl;
+                return false;
+            }
+        } else if (arg == "--key-file" && i + 1 < argc) {
+            key_file = argv[++i];
+        } else if (arg == "--cipher" && i + 1 < argc) {
+            if (!parse_cipher_suite(argv[++i], cipher_suite)) {
+                cout << "Unknown cipher: " << argv[i] << endl;
+                return false;
+            }
+        } else if (arg == "--signing-key" && i + 1 < argc) {
+            signing_key_file = argv[++i];
+        } else if (arg == "--trusted-keys" && i + 1 < argc) {
+            trusted_keys_dir = argv[++i];
+        } else if (arg == "--verify-threads" && i + 1 < argc) {
+            verify_threads = atoi(argv[++i]);
+            if (verify_threads < 0) {
+                cout << "--verify-threads must not be negative" << endl;
+                return false;
+            }
+        } else if (arg == "--transfer-retries" && i + 1 < argc) {
+            transfer_retries = atoi(argv[++i]);
+            if (transfer_retries < 0) {
+                cout << "--transfer-retries must not be negative" << endl;
+                return false;
+            }
+        } else if (arg == "--transfer-ids") {
+            transfer_ids = true;
+        } else if (arg == "--send-threads" && i + 1 < argc) {
+            send_threads = atoi(argv[++i]);
+            if (send_threads < 0) {
+                cout << "--send-threads must not be negative" << endl;
+                return false;
+            }
+        } else if (arg == "--datagram") {
+            use_datagrams = true;
+        } else if (arg == "--no-local-transport") {
+            local_transport = false;
+        } else if (arg == "--dedup-window" && i + 1 < argc) {
+            dedup_window = atoi(argv[++i]);
+            if (dedup_window < 1) {
+                cout << "--dedup-window must be at least 1" << endl;
+                return false;
+            }
+        } else if (arg == "--dedup-capacity" && i + 1 < argc) {
+            int capacity = atoi(argv[++i]);
+            if (capacity < 1) {
+                cout << "--dedup-capacity must be at least 1" << endl;
+                return false;
+            }
+            dedup_capacity = capacity;
+        } else if (arg == "--shutdown-timeout" && i + 1 < argc) {
+            shutdown_timeout = atoi(argv[++i]);
+            if (shutdown_timeout < 0) {
+                cout << "--shutdown-timeout must not be negative" << endl;
+                return false;
+            }
+        } else if (arg == "--heartbeat" && i + 1 < argc) {
+            heartbeat_interval = atoi(argv[++i]);
+            if (heartbeat_interval < 0) {
+                cout << "--heartbeat must not be negative" << endl;
+                return false;
+            }
+        } else if (arg == "--keepalive" && i + 1 < argc) {
+            keepalive_timeout = atoi(argv[++i]);
+            if (keepalive_timeout < 0) {
+                cout << "--keepalive must not be negative" << endl;
+                return false;
+            }
+        } else if (arg == "--settle-window" && i + 1 < argc) {
+            settle_window = atoi(argv[++i]);
+            if (settle_window < 1) {
+                cout << "--settle-window must be at least 1" << endl;
+                return false;
+            }
+            if (settlement_mode == SETTLE_OFF) {
+                settlement_mode = SETTLE_AGGREGATE;
+            }
+        } else if (arg == "--settle-threshold" && i + 1 < argc) {
+            settle_threshold = atoll(argv[++i]);
+            if (settle_threshold < 1) {
+                cout << "--settle-threshold must be at least 1" << endl;
+                return false;
+            }
+            if (settlement_mode == SETTLE_OFF) {
+                settlement_mode = SETTLE_AGGREGATE;
+            }
+        } else if (arg == "--settle-net") {
+            settlement_mode = SETTLE_NET;
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journal_file = argv[++i];
+        } else if (arg == "--socket-profile" && i + 1 < argc) {
+            socket_profile_name = argv[++i];
+        } else if ((arg == "--rcvbuf" || arg == "--sndbuf") && i + 1 < argc) {
+            int size = atoi(argv[++i]);
+            if (size < 1) {
+                cout << arg << " must be at least 1" << endl;
+                return false;
+            }
+            (arg == "--rcvbuf" ? socket_rcvbuf : socket_sndbuf) = size;
+        } else if (arg == "--busy-poll" && i + 1 < argc) {
+            busy_poll_us = atoi(argv[++i]);
+            if (busy_poll_us < 0) {
+                cout << "--busy-poll must not be negative" << endl;
+                return false;
+            }
+        } else if (arg == "--fastopen") {
+            tcp_fastopen = true;
+        } else if (arg == "--gossip") {
+            if (gossip_interval == 0) {
+                gossip_interval = GOSSIP_INTERVAL_MS;
+            }
+        } else if (arg == "--gossip-interval" && i + 1 < argc) {
+            gossip_interval = atoi(argv[++i]);
+            if (gossip_interval < 1) {
+                cout << "--gossip-interval must be at least 1" << endl;
+                return false;
+            }
+        } else if (arg == "--gossip-fanout" && i + 1 < argc) {
+            gossip_fanout = atoi(argv[++i]);
+            if (gossip_fanout < 1) {
+                cout << "--gossip-fanout must be at least 1" << endl;
+                return false;
+            }
+        } else if (arg == "--push-updates") {
+            push_updates = true;
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capture_file = argv[++i];
+        } else if (arg == "--quiet") {
+            quiet_transfers = true;
+        } else {
+            return false;
+        }
+    }
+
+    if (!journal_file.empty() && settlement_mode == SETTLE_OFF) {
+        cout << "--journal needs --settle-window, --settle-threshold or --settle-net" << endl;
+        return false;
+    }
+    if (gossip_interval > 0 && key_file.empty()) {
+        cout << "--gossip needs --key-file: only encrypted gossip is accepted" << endl;
+        return false;
+    }
+
+    // The overrides apply on top of the named profile, whatever their order
+    SocketProfile profile;
+    if (!parse_socket_profile(socket_profile_name, profile)) {
+        cout << "Unknown socket profile: " << socket_profile_name << endl;
+        return false;
+    }
+    if (socket_rcvbuf > 0) {
+        profile.rcvbuf = socket_rcvbuf;
+    }
+    if (socket_sndbuf > 0) {
+        profile.sndbuf = socket_sndbuf;
+    }
+    if (busy_poll_us >= 0) {
+        profile.busy_poll_us = busy_poll_us;
+    }
+    if (tcp_fastopen) {
+        profile.fastopen = true;
+    }
+    set_socket_profile(profile);
+    return true;
+}
+
+/*
+ * Print Main Menu
+ * Displays available options to the user
+ */
+void print_menu() {
+    cout << "\n========================================" << endl;
+    cout << "              Main Menu                 " << endl;
+    cout << "========================================" << endl;
+    cout << "1. Register" << endl;
+    cout << "2. Login" << endl;
+    cout << "3. List (Get account balance and online users)" << endl;
+    cout << "4. Transfer money to another user" << endl;
+    cout << "5. Exit" << endl;
+    cout << "6. Split payment to many users" << endl;
+    cout << "========================================" << endl;
+}
+
 /*
  * Handle Registration
  * ==================================================================================
@@ -208,615 +538,512 @@
  */
 void handle_register() {
     cout << "\n--- Register ---" << endl;
-    
+
     // Check if server connection is available
-    if (server_socket == -1) {
-        cout << "Error: Not connected to server." << endl;
+    if (!client.session.connected()) {
+        if (client.session.closed()) {
+            cout << "Error: Not connected to server." << endl;
+        } else {
+            cout << "Error: Connection to server lost, reconnecting. Please try again shortly." << endl;
+        }
         return;
     }
-    
+
     // Check if already logged in (can't register if already logged in)
-    if (is_logged_in) {
+    if (client.logged_in()) {
         cout << "You are already logged in. Please logout first if you want to register a new account." << endl;
         return;
     }
-    
+
     cout << "Enter username: ";
     string user;
     getline(cin, user);
-    
+
     cout << "Enter initial deposit amount: ";
     string amount_str;
     getline(cin, amount_str);
     int amount = stoi(amount_str);
 
-    // Send registration message using persistent connection: REGISTER#username#amount\r\n
+    // Send registration message using persistent connection
     // 使用持久連線發送註冊訊息
-    string message = "REGISTER#" + user + "#" + to_string(amount) + CRLF;
-    
-    if (!send_message(server_socket, message)) {
-        cout << "Failed to send registration request." << endl;
-        return;
-    }
-
-    // Receive response from server
-    string response = receive_message(server_socket);
-
-    if (response.empty()) {
-        cout << "No response from server." << endl;
-        return;
-    }
-
-    // Parse response and inform user of result
-    if (response.find("100 OK") != string::npos) {
+    string response;
+    switch (client.register_user(user, amount, &response)) {
+    case REQUEST_OK:
         cout << "\nRegistration successful!" << endl;
         cout << "You can now login using option 2." << endl;
-    } else if (response.find("210 FAIL") != string::npos) {
+        break;
+    case REQUEST_REJECTED:
         cout << "\nRegistration failed. Username may already exist." << endl;
-    } else {
+        break;
+    case REQUEST_SEND_FAILED:
+        cout << "Failed to send registration request." << endl;
+        break;
+    case REQUEST_NO_RESPONSE:
+        cout << "No response from server." << endl;
+        break;
+    default:
         cout << "\nUnexpected response: " << response << endl;
+        break;
     }
 }
- 
- /*
-  * Handle Login
-  * Logs in to the server using the existing persistent connection.
-  * Uses the same connection established at program startup.
-  * Protocol: <username>#<port>\r\n
-  * Response: Multiple lines containing balance, public key, and online user list
-  */
+
+/*
+ * Handle Login
+ * Logs in to the server using the existing persistent connection.
+ * Uses the same connection established at program startup.
+ * Protocol: <username>#<port>\r\n
+ * Response: Multiple lines containing balance, public key, and online user list
+ */
 void handle_login() {
     cout << "\n--- Login ---" << endl;
-    
+
     // Check if server connection is available
-    if (server_socket == -1) {
-        cout << "Error: Not connected to server." << endl;
+    if (!client.session.connected()) {
+        if (client.session.closed()) {
+            cout << "Error: Not connected to server." << endl;
+        } else {
+            cout << "Error: Connection to server lost, reconnecting. Please try again shortly." << endl;
+        }
         return;
     }
-    
+
     // Check if already logged in
-    if (is_logged_in) {
+    if (client.logged_in()) {
         cout << "You are already logged in. Please logout first (option 5) before logging in again." << endl;
         return;
     }
-    
+
     cout << "Enter username: ";
-    getline(cin, username);
+    string user;
+    getline(cin, user);
 
-    // Send login message using persistent connection: username#port\r\n
-    // Port is where we're listening for P2P connections
-    string message = username + "#" + to_string(my_port) + CRLF;
-    if (!send_message(server_socket, message)) {
+    ListReply reply;
+    switch (client.login(user, &reply)) {
+    case REQUEST_OK:
+        print_list_reply(reply);
+        cout << "\nLogin successful!" << endl;
+        if (push_updates) {
+            if (client.subscribe_updates()) {
+                cout << "The server pushes changes to the online list from now on." << endl;
+            } else {
+                cout << "The server does not push updates; use List to refresh." << endl;
+            }
+        }
+        break;
+    case REQUEST_REJECTED:
+        cout << "\nLogin failed. Please register first." << endl;
+        break;
+    case REQUEST_SEND_FAILED:
         cout << "Failed to send login request." << endl;
-        username = "";
+        break;
+    default:
+        cout << "No response from server." << endl;
+        break;
+    }
+}
+
+/*
+ * Handle List Request
+ * Requests updated account balance and online user list from server.
+ * Protocol: List\r\n
+ * Response: Same format as login response
+ */
+void handle_list() {
+    // Check if user is logged in
+    if (!client.logged_in()) {
+        cout << "Please login first." << endl;
+        return;
+    }
+
+    if (show_local_state()) {
         return;
     }
 
-    // Receive response from server
-    string response = receive_message(server_socket);
+    cout << "\n--- Requesting updated list ---" << endl;
 
-    if (response.empty()) {
+    ListReply reply;
+    RequestStatus status = client.refresh(&reply);
+    if (status == REQUEST_SEND_FAILED) {
+        cout << "Failed to send list request." << endl;
+    } else if (status != REQUEST_OK) {
         cout << "No response from server." << endl;
-        username = "";
+    } else {
+        // Display updated information
+        print_list_reply(reply);
+    }
+}
+
+/*
+ * Handle Money Transfer (P2P)
+ * Transfers money directly to another client without going through server.
+ * This is the core P2P functionality - client connects directly to recipient.
+ * Protocol: <sender>#<amount>#<recipient>\r\n
+ */
+void handle_transfer() {
+    // Check if user is logged in
+    if (!client.logged_in()) {
+        cout << "Please login first." << endl;
         return;
     }
 
-    // Check for authentication failure
-    if (response.find("220 AUTH_FAIL") != string::npos) {
-        cout << "\nLogin failed. Please register first." << endl;
-        username = "";
+    cout << "\n--- Transfer Money ---" << endl;
+
+    // Show list of online users (excluding ourselves)
+    vector<string> user_list = client.directory.usernames_except(client.username());
+    if (user_list.empty()) {
+        cout << "No other users online." << endl;
+        return;
+    }
+
+    cout << "Online users:" << endl;
+    for (size_t i = 0; i < user_list.size(); i++) {
+        cout << (i + 1) << ". " << user_list[i] << endl;
+    }
+
+    // Get recipient username from user
+    cout << "Enter recipient username: ";
+    string recipient;
+    getline(cin, recipient);
+
+    // Check if recipient exists and is online
+    OnlineUser target_user;
+    if (!client.directory.find(recipient, target_user)) {
+        cout << "User not found or not online." << endl;
+        return;
+    }
+
+    // Get transfer amount from user
+    cout << "Enter amount to transfer: ";
+    string amount_str;
+    getline(cin, amount_str);
+    int amount = stoi(amount_str);
+
+    // P2P Connection: Connect directly to recipient's client
+    if (amount > 0 && amount <= client.ledger.available()) {
+        cout << "Connecting to " << recipient << " at " << target_user.ip << ":" << target_user.port << "..." << endl;
+    }
+    TransferStatus transfer_status = client.send_transfer(recipient, amount);
+    if (transfer_status != TRANSFER_OK) {
+        cout << transfer_status_text(transfer_status) << endl;
         return;
     }
+    cout << "Transfer request sent to " << recipient << endl;
+    if (show_local_state()) {
+        return;  // Debited locally; with pushed updates the server's balance follows
+    }
+
+    // Wait for recipient to report transaction to server
+    this_thread::sleep_for(chrono::milliseconds(500));
 
-    // Parse response to extract balance and online users
-    parse_online_list(response);
-    is_logged_in = true;
-    cout << "\nLogin successful!" << endl;
+    // Request updated balance from server to reflect the transfer
+    cout << "\nRequesting updated balance from server..." << endl;
+    ListReply reply;
+    RequestStatus status = client.refresh(&reply);
+    if (status == REQUEST_OK) {
+        print_list_reply(reply);
+        cout << "Balance updated after transfer." << endl;
+    } else if (status == REQUEST_SEND_FAILED) {
+        cout << "Warning: Failed to send list request to server." << endl;
+    } else {
+        cout << "Warning: Could not retrieve updated balance from server." << endl;
+    }
 }
- 
- /*
-  * Handle List Request
-  * Requests updated account balance and online user list from server.
-  * Protocol: List\r\n
-  * Response: Same format as login response
-  */
- void handle_list() {
-     // Check if user is logged in
-     if (!is_logged_in) {
-         cout << "Please login first." << endl;
-         return;
-     }
- 
-     cout << "\n--- Requesting updated list ---" << endl;
- 
-     // Send list request to server
-     string message = "List" + string(CRLF);
-     if (!send_message(server_socket, message)) {
-         cout << "Failed to send list request." << endl;
-         return;
-     }
- 
-    // Receive response from server
-    string response = receive_message(server_socket);
 
-    if (response.empty()) {
-        cout << "No response from server." << endl;
+/*
+ * Transfer Status Text
+ * Console message for the outcome of an outgoing transfer
+ */
+const char* transfer_status_text(TransferStatus status) {
+    switch (status) {
+    case TRANSFER_OK:
+        return "Sent";
+    case TRANSFER_UNKNOWN_RECIPIENT:
+        return "User not found or not online.";
+    case TRANSFER_INVALID_AMOUNT:
+        return "Invalid amount.";
+    case TRANSFER_INSUFFICIENT_BALANCE:
+        return "Insufficient balance.";
+    case TRANSFER_CONNECT_FAILED:
+        return "Failed to connect to recipient.";
+    case TRANSFER_SIGN_FAILED:
+        return "Failed to sign transfer request.";
+    case TRANSFER_ENCRYPT_FAILED:
+        return "Failed to encrypt transfer request.";
+    case TRANSFER_SEND_FAILED:
+        return "Failed to send transfer request.";
+    default:
+        return "Please login first.";
+    }
+}
+
+/*
+ * Read Payees
+ * Splits the payee list on commas, or reads it from a file (@path, one
+ * payee per line).
+ * Returns: false if the file cannot be read
+ */
+bool read_payees(const string& input, vector<string>& entries) {
+    string text = input;
+    if (!input.empty() && input[0] == '@') {
+        ifstream file(input.substr(1).c_str());
+        if (!file) {
+            return false;
+        }
+        stringstream contents;
+        contents << file.rdbuf();
+        text = contents.str();
+    }
+    string entry;
+    for (size_t i = 0; i <= text.size(); i++) {
+        if (i == text.size() || text[i] == ',' || text[i] == '\n' || text[i] == '\r') {
+            size_t begin = entry.find_first_not_of(" \t");
+            if (begin != string::npos) {
+                entries.push_back(entry.substr(begin, entry.find_last_not_of(" \t") - begin + 1));
+            }
+            entry.clear();
+        } else {
+            entry += text[i];
+        }
+    }
+    return true;
+}
+
+/*
+ * Handle Split Payment
+ * Pays many users in one operation: every payee is dialed in parallel (at
+ * most --send-threads at a time) and the balance is refreshed once at the
+ * end instead of after every transfer. Payees are name:amount, or
+ * name*shares to split a total in proportion.
+ */
+void handle_split() {
+    if (!client.logged_in()) {
+        cout << "Please login first." << endl;
         return;
     }
 
-    // DEBUG: Show what we received
-    cout << "\n[DEBUG] Received response:" << endl;
-    cout << "'" << response << "'" << endl;
-    cout << "[DEBUG] Response length: " << response.length() << " bytes" << endl;
+    cout << "\n--- Split Payment ---" << endl;
+    cout << "Enter payees as name:amount or name*shares, separated by commas (or @file, one per line): ";
+    string input;
+    getline(cin, input);
+    vector<string> entries;
+    if (!read_payees(input, entries)) {
+        cout << "Cannot read payee file " << input.substr(1) << endl;
+        return;
+    }
+    if (entries.empty()) {
+        cout << "No payees given." << endl;
+        return;
+    }
+
+    vector<TransferRequest> payees(entries.size());
+    vector<int> shares;
+    for (size_t i = 0; i < entries.size(); i++) {
+        size_t separator = entries[i].find_first_of(":*");
+        if (separator == string::npos || separator == 0) {
+            cout << "Invalid payee: " << entries[i] << endl;
+            return;
+        }
+        bool is_share = entries[i][separator] == '*';
+        if (i > 0 && is_share != !shares.empty()) {
+            cout << "Use either amounts or shares for all payees." << endl;
+            return;
+        }
+        payees[i].recipient = entries[i].substr(0, separator);
+        int value = atoi(entries[i].c_str() + separator + 1);
+        if (is_share) {
+            shares.push_back(value);
+        } else {
+            payees[i].amount = value;
+        }
+    }
+    if (!shares.empty()) {
+        cout << "Enter total amount to split: ";
+        string total_str;
+        getline(cin, total_str);
+        vector<int> amounts;
+        if (!split_by_shares(atoi(total_str.c_str()), shares, amounts)) {
+            cout << "Invalid total or share." << endl;
+            return;
+        }
+        for (size_t i = 0; i < payees.size(); i++) {
+            payees[i].amount = amounts[i];
+        }
+    }
+
+    long long total = 0;
+    for (const TransferRequest& payee : payees) {
+        total += payee.amount;
+    }
+    cout << "Paying " << payees.size() << " users, total " << total << "..." << endl;
+
+    vector<TransferResult> results;
+    auto start = chrono::steady_clock::now();
+    size_t sent = client.send_split(payees, results);
+    long long elapsed_ms =
+        chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+
+    long long paid = 0;
+    for (size_t i = 0; i < payees.size(); i++) {
+        cout << "  " << left << setw(20) << payees[i].recipient << right << setw(8) << payees[i].amount << "  "
+             << transfer_status_text(results[i].status) << endl;
+        if (results[i].status == TRANSFER_OK) {
+            paid += payees[i].amount;
+        }
+    }
+    cout << "Sent " << sent << " of " << payees.size() << " transfers (" << paid << " of " << total << ") in "
+         << elapsed_ms << " ms" << endl;
+    if (sent == 0 || show_local_state()) {
+        return;
+    }
 
-    // Parse and display updated information
-    parse_online_list(response);
+    // One refresh for the whole batch, after the recipients had time to report
+    this_thread::sleep_for(chrono::milliseconds(500));
+    cout << "\nRequesting updated balance from server..." << endl;
+    ListReply reply;
+    if (client.refresh(&reply) == REQUEST_OK) {
+        print_list_reply(reply);
+    } else {
+        cout << "Warning: Could not retrieve updated balance from server." << endl;
+    }
 }
- 
- /*
-  * Handle Money Transfer (P2P)
-  * Transfers money directly to another client without going through server.
-  * This is the core P2P functionality - client connects directly to recipient.
-  * Protocol: <sender>#<amount>#<recipient>\r\n
-  */
- void handle_transfer() {
-     // Check if user is logged in
-     if (!is_logged_in) {
-         cout << "Please login first." << endl;
-         return;
-     }
- 
-     cout << "\n--- Transfer Money ---" << endl;
-     
-     // Show list of online users (excluding ourselves)
-     users_mutex.lock();
-     if (online_users.empty()) {
-         cout << "No other users online." << endl;
-         users_mutex.unlock();
-         return;
-     }
- 
-     cout << "Online users:" << endl;
-     int index = 1;
-     vector<string> user_list;
-     for (const auto& pair : online_users) {
-         // Don't show ourselves in the list
-         if (pair.first != username) {
-             cout << index++ << ". " << pair.first << endl;
-             user_list.push_back(pair.first);
-         }
-     }
-     users_mutex.unlock();
- 
-     if (user_list.empty()) {
-         cout << "No other users online." << endl;
-         return;
-     }
- 
-     // Get recipient username from user
-     cout << "Enter recipient username: ";
-     string recipient;
-     getline(cin, recipient);
- 
-     // Check if recipient exists and is online
-     users_mutex.lock();
-     auto it = online_users.find(recipient);
-     if (it == online_users.end()) {
-         cout << "User not found or not online." << endl;
-         users_mutex.unlock();
-         return;
-     }
-     OnlineUser target_user = it->second;  // Copy recipient's connection info
-     users_mutex.unlock();
- 
-     // Get transfer amount from user
-     cout << "Enter amount to transfer: ";
-     string amount_str;
-     getline(cin, amount_str);
-     int amount = stoi(amount_str);
- 
-     // Validate amount
-     if (amount <= 0) {
-         cout << "Invalid amount." << endl;
-         return;
-     }
- 
-     // Check if we have sufficient balance
-     if (amount > account_balance) {
-         cout << "Insufficient balance." << endl;
-         return;
-     }
- 
-     // P2P Connection: Connect directly to recipient's client
-     cout << "Connecting to " << recipient << " at " << target_user.ip << ":" << target_user.port << "..." << endl;
-     int peer_sock = connect_to_server(target_user.ip, target_user.port);
-     if (peer_sock == -1) {
-         cout << "Failed to connect to recipient." << endl;
-         return;
-     }
- 
-     // Send transfer message directly to recipient: sender#amount#recipient\r\n
-     string transfer_msg = username + "#" + to_string(amount) + "#" + recipient + CRLF;
-     if (!send_message(peer_sock, transfer_msg)) {
-         cout << "Failed to send transfer request." << endl;
-         close(peer_sock);
-         return;
-     }
- 
-     cout << "Transfer request sent to " << recipient << endl;
-     close(peer_sock);  // Close P2P connection after sending
- 
-     // Wait for recipient to report transaction to server
-     this_thread::sleep_for(chrono::milliseconds(500));
-     
-     // Request updated balance from server to reflect the transfer
-     cout << "\nRequesting updated balance from server..." << endl;
-     string list_msg = "List" + string(CRLF);
-     if (send_message(server_socket, list_msg)) {
-         string response = receive_message(server_socket);
-         if (!response.empty()) {
-             parse_online_list(response);
-             cout << "Balance updated after transfer." << endl;
-         } else {
-             cout << "Warning: Could not retrieve updated balance from server." << endl;
-         }
-     } else {
-         cout << "Warning: Failed to send list request to server." << endl;
-     }
- }
- 
- /*
-  * Handle Exit
-  * Logs out from server and exits the program gracefully.
-  * Protocol: Exit\r\n
-  * Response: Bye\r\n
-  */
- void handle_exit() {
+
+/*
+ * Handle Exit
+ * Finishes incoming transfers and their reports, then logs out from server
+ * and exits the program gracefully.
+ * Protocol: Exit\r\n
+ * Response: Bye\r\n
+ */
+void handle_exit() {
     cout << "\n--- Exiting ---" << endl;
-    
+
+    // Stop the listener and send the pending TRANSACTION reports while the
+    // server connection is still open
+    ShutdownReport lost = client.shutdown(shutdown_timeout);
+    if (lost.connections_cut > 0 || lost.reports_dropped > 0) {
+        safe_print("Warning: Shutdown timed out after " + to_string(shutdown_timeout) + " ms: " +
+                   to_string(lost.connections_cut) + " incoming transfer connections cut off, " +
+                   to_string(lost.reports_dropped) + " transaction reports not confirmed by the server");
+    }
+
     // If logged in, send proper logout notification to server
-    if (is_logged_in && server_socket != -1) {
+    if (client.logged_in()) {
         cout << "Logging out..." << endl;
-        
-        // Send exit message to server
-        string message = "Exit" + string(CRLF);
-        if (send_message(server_socket, message)) {
-            // Wait for server's goodbye response
-            string response = receive_message(server_socket);
-            if (response.find("Bye") != string::npos) {
-                cout << "Logged out successfully." << endl;
-            }
-        }
     }
-    
-    // Close persistent server connection
-    if (server_socket != -1) {
-        close(server_socket);
-        server_socket = -1;
+    // Closes the persistent server connection either way
+    if (client.logout()) {
+        cout << "Logged out successfully." << endl;
+    }
+    if (client.capture_enabled()) {
+        client.capture.close();
+        cout << "Captured " << client.capture.records() << " messages (" << client.capture.bytes() << " bytes) in "
+             << capture_file << endl;
     }
-    
-    // Mark logged out and stop the program
-    is_logged_in = false;
+
+    // Stop the program
     is_running = false;
     cout << "Goodbye!" << endl;
 }
- 
- /*
-  * Connect to Server
-  * Creates a TCP socket and connects to the specified IP and port.
-  * Returns: socket file descriptor on success, -1 on failure
-  */
- int connect_to_server(const string& ip, int port) {
-     // Create TCP socket
-     int sock = socket(AF_INET, SOCK_STREAM, 0);
-     if (sock == -1) {
-         perror("socket");
-         return -1;
-     }
- 
-     // Set up server address structure
-     struct sockaddr_in server_addr;
-     memset(&server_addr, 0, sizeof(server_addr));
-     server_addr.sin_family = AF_INET;
-     server_addr.sin_port = htons(port);  // Convert port to network byte order
-     
-     // Convert IP address from string to binary form
-     if (inet_pton(AF_INET, ip.c_str(), &server_addr.sin_addr) <= 0) {
-         perror("inet_pton");
-         close(sock);
-         return -1;
-     }
- 
-     // Connect to server
-     if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) == -1) {
-         perror("connect");
-         close(sock);
-         return -1;
-     }
- 
-     return sock;
- }
- 
- /*
-  * Send Message
-  * Sends a message through the specified socket.
-  * Returns: true on success, false on failure
-  */
-bool send_message(int sock, const string& message) {
-    ssize_t sent = send(sock, message.c_str(), message.length(), 0);
-    if (sent == -1) {
-        perror("send");
+
+/*
+ * Print List Reply
+ * Displays the balance and online user list from a login/List reply.
+ */
+void print_list_reply(const ListReply& reply) {
+    cout << "Account Balance: $" << reply.balance << endl;
+    // Don't print the full key, just indicate we received it
+    if (!reply.public_key.empty()) {
+        cout << "Server Public Key: [Received]" << endl;
+    }
+    cout << "Number of online users: " << reply.users.size() << endl;
+
+    cout << "\nOnline Users:" << endl;
+    cout << "----------------------------------------" << endl;
+    for (const OnlineUser& user : reply.users) {
+        cout << user.username << " @ " << user.ip << ":" << user.port << endl;
+    }
+    cout << "----------------------------------------" << endl;
+}
+
+/*
+ * Show Local State
+ * With a subscribed session or gossip the directory is already current, so
+ * List is answered locally instead of asking the server.
+ * Returns: false if neither is on (the caller sends List)
+ */
+bool show_local_state() {
+    if (!client.updates_pushed() && !client.gossip_enabled()) {
         return false;
     }
-    // cout << "[DEBUG] Actually sent " << sent << " bytes" << endl;
+    ListReply reply;
+    reply.ok = true;
+    reply.balance = client.ledger.balance();
+    reply.public_key = client.server_public_key();
+    for (const string& name : client.directory.usernames_except("")) {
+        OnlineUser user;
+        if (client.directory.find(name, user)) {
+            reply.users.push_back(user);
+        }
+    }
+    cout << "\n--- Online list (kept current by " << (client.updates_pushed() ? "the server" : "gossip") << ") ---"
+         << endl;
+    print_list_reply(reply);
     return true;
 }
- 
- /*
-  * Receive Message
-  * Receives a message from the specified socket.
-  * Returns: received message as string, empty string on error
-  */
-string receive_message(int sock) {
-    char buffer[BUFFER_SIZE];
-    memset(buffer, 0, BUFFER_SIZE);
-    
-    // cout << "[DEBUG] Calling recv() on socket " << sock << "..." << endl;
-    ssize_t received = recv(sock, buffer, BUFFER_SIZE - 1, 0);
-    // cout << "[DEBUG] recv() returned: " << received << endl;
-    
-    if (received == -1) {
-        perror("recv");
-        return "";
-    } else if (received == 0) {
-        // cout << "[DEBUG] Connection closed by peer" << endl;
-        return "";
-    }
-    
-    // cout << "[DEBUG] Received " << received << " bytes" << endl;
-    return string(buffer, received);
+
+/*
+ * On Incoming Transfer
+ * Called from the listener threads after the ledger was credited.
+ */
+void on_incoming_transfer(const TransferFrame& transfer, int new_balance) {
+    // Display transfer notification to user
+    if (quiet_transfers) {
+        return;
+    }
+    safe_print("\n*** Incoming Transfer ***");
+    safe_print("From: " + transfer.sender);
+    safe_print("Amount: $" + to_string(transfer.amount));
+    safe_print("To: " + transfer.recipient);
+    safe_print("************************\n");
+    safe_print("Transfer received. New balance: $" + to_string(new_balance));
+}
+
+/*
+ * On Report
+ * Called from the reporter thread with the server's answer to a TRANSACTION report.
+ */
+void on_report(const string& report, const string& response) {
+    (void)report;
+    if (response.empty()) {
+        safe_print("Warning: No response from server for transaction report");
+    } else if (!quiet_transfers) {
+        // With --quiet, stay silent on success under load; only report failures
+        safe_print("Server response: " + response);
+    }
+}
+
+/*
+ * On Directory Event
+ * Called after a change pushed by the server (session reader thread) or
+ * learned by gossip (listener thread) was applied.
+ */
+void on_directory_event(const DirectoryEvent& event) {
+    if (quiet_transfers || event.user.username == client.username()) {
+        return;
+    }
+    if (event.type == EVENT_JOIN) {
+        safe_print("\n*** " + event.user.username + " is online ***");
+    } else if (event.type == EVENT_LEAVE) {
+        safe_print("\n*** " + event.user.username + " went offline ***");
+    }
+}
+
+/*
+ * Safe Print
+ * Thread-safe printing function that uses mutex to prevent output mixing.
+ * Multiple threads may want to print simultaneously (main thread, listener thread, handler threads).
+ */
+void safe_print(const string& message) {
+    lock_guard<mutex> lock(cout_mutex);
+    cout << message << endl;
 }
- 
- /*
-  * Parse Online List
-  * Parses server response containing balance and online user list.
-  * Response format:
-  *   Line 1: Account balance
-  *   Line 2: Server public key
-  *   Line 3: Number of online users
-  *   Line 4+: username#ip#port for each online user
-  */
- void parse_online_list(const string& response) {
-     istringstream iss(response);
-     string line;
-     
-    // First line: account balance
-    if (getline(iss, line)) {
-        // Remove any CR/LF characters
-        line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
-        line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
-        
-        cout << "[DEBUG] Line 1 (balance): '" << line << "'" << endl;
-        
-        if (!line.empty()) {
-            account_balance = stoi(line);
-            cout << "Account Balance: $" << account_balance << endl;
-        } else {
-            cout << "[ERROR] Empty balance line!" << endl;
-        }
-     }
-     
-    // Second line: server public key
-    if (getline(iss, line)) {
-        line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
-        line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
-        
-        cout << "[DEBUG] Line 2 (public key): '" << line << "'" << endl;
-        
-         server_public_key = line;
-         // Don't print the full key, just indicate we received it
-         if (!server_public_key.empty()) {
-             cout << "Server Public Key: [Received]" << endl;
-         }
-     }
-     
-    // Third line: number of online users
-    int num_users = 0;
-    if (getline(iss, line)) {
-        line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
-        line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
-        
-        cout << "[DEBUG] Line 3 (num_users): '" << line << "'" << endl;
-        
-        if (!line.empty()) {
-            num_users = stoi(line);
-            cout << "Number of online users: " << num_users << endl;
-        } else {
-            cout << "[ERROR] Empty num_users line!" << endl;
-        }
-     }
-     
-     // Clear current online users map before updating
-     users_mutex.lock();
-     online_users.clear();
-     
-     // Parse each online user's information
-     cout << "\nOnline Users:" << endl;
-     cout << "----------------------------------------" << endl;
-    for (int i = 0; i < num_users; i++) {
-        if (getline(iss, line)) {
-            line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
-            line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
-            
-            cout << "[DEBUG] User line " << (i+1) << ": '" << line << "'" << endl;
-             
-             // Parse: username#ip#port
-             size_t pos1 = line.find('#');
-             size_t pos2 = line.find('#', pos1 + 1);
-             
-             if (pos1 != string::npos && pos2 != string::npos) {
-                 OnlineUser user;
-                 user.username = line.substr(0, pos1);
-                 user.ip = line.substr(pos1 + 1, pos2 - pos1 - 1);
-                 user.port = stoi(line.substr(pos2 + 1));
-                 
-                 cout << "[DEBUG] Parsed: username='" << user.username << "', ip='" << user.ip << "', port=" << user.port << endl;
-                 
-                 // Add user to online users map
-                 online_users[user.username] = user;
-                 cout << user.username << " @ " << user.ip << ":" << user.port << endl;
-             } else {
-                 cout << "[ERROR] Failed to parse user line (pos1=" << pos1 << ", pos2=" << pos2 << ")" << endl;
-             }
-         } else {
-             cout << "[ERROR] Could not read user line " << (i+1) << endl;
-         }
-     }
-     cout << "----------------------------------------" << endl;
-     users_mutex.unlock();
- }
- 
- /*
-  * Listener Thread
-  * Background thread that listens for incoming P2P connections from other clients.
-  * When another client wants to transfer money to us, they connect to this listener.
-  * For each incoming connection, spawns a new handler thread.
-  */
- void listener_thread() {
-     // Create listening socket
-     listen_socket = socket(AF_INET, SOCK_STREAM, 0);
-     if (listen_socket == -1) {
-         perror("listener socket");
-         return;
-     }
- 
-     // Set socket option to reuse address (useful for quick restart)
-     int opt = 1;
-     if (setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) {
-         perror("setsockopt");
-         close(listen_socket);
-         return;
-     }
- 
-     // Bind socket to our listening port
-     struct sockaddr_in listen_addr;
-     memset(&listen_addr, 0, sizeof(listen_addr));
-     listen_addr.sin_family = AF_INET;
-     listen_addr.sin_addr.s_addr = INADDR_ANY;  // Listen on all network interfaces
-     listen_addr.sin_port = htons(my_port);     // Convert port to network byte order
- 
-     if (::bind(listen_socket, (struct sockaddr*)&listen_addr, sizeof(listen_addr)) == -1) {
-         perror("bind");
-         close(listen_socket);
-         return;
-     }
- 
-     // Start listening for connections (queue up to 5 pending connections)
-     if (listen(listen_socket, 5) == -1) {
-         perror("listen");
-         close(listen_socket);
-         return;
-     }
- 
-     safe_print("P2P listener started on port " + to_string(my_port));
- 
-     // Accept incoming connections in a loop
-     while (is_running) {
-         struct sockaddr_in client_addr;
-         socklen_t client_len = sizeof(client_addr);
-         
-         // Accept incoming connection (blocking call)
-         int client_sock = accept(listen_socket, (struct sockaddr*)&client_addr, &client_len);
-         if (client_sock == -1) {
-             if (is_running) {
-                 perror("accept");
-             }
-             continue;
-         }
- 
-         // Handle this client connection in a new thread
-         thread handler(handle_client_connection, client_sock);
-         handler.detach();  // Detach so handler runs independently
-     }
- }
- 
- /*
-  * Handle Client Connection
-  * Handles an incoming P2P transfer from another client.
-  * Receives transfer message, updates local balance, and reports to server.
-  * Protocol: <sender>#<amount>#<recipient>\r\n
-  */
- void handle_client_connection(int client_sock) {
-     // Receive transfer message from peer
-     string message = receive_message(client_sock);
-     
-     if (message.empty()) {
-         close(client_sock);
-         return;
-     }
- 
-     // Parse transfer message: sender#amount#recipient
-     size_t pos1 = message.find('#');
-     size_t pos2 = message.find('#', pos1 + 1);
-     
-     if (pos1 != string::npos && pos2 != string::npos) {
-         string sender = message.substr(0, pos1);
-         string amount_str = message.substr(pos1 + 1, pos2 - pos1 - 1);
-        string recipient = message.substr(pos2 + 1);
-        
-        // Remove CRLF from recipient field
-        recipient.erase(std::remove(recipient.begin(), recipient.end(), '\r'), recipient.end());
-        recipient.erase(std::remove(recipient.begin(), recipient.end(), '\n'), recipient.end());
-         
-         int amount = stoi(amount_str);
-         
-         // Display transfer notification to user
-         safe_print("\n*** Incoming Transfer ***");
-         safe_print("From: " + sender);
-         safe_print("Amount: $" + to_string(amount));
-         safe_print("To: " + recipient);
-         safe_print("************************\n");
-         
-         // Update local balance (optimistic update)
-         account_balance += amount;
-         safe_print("Transfer received. New balance: $" + to_string(account_balance));
-         
-         // Report transaction to server so it can update both accounts
-         if (is_logged_in && server_socket != -1) {
-             socket_mutex.lock();  // Lock because main thread may also use server_socket
-             
-             // Send transaction report: TRANSACTION#sender#recipient#amount\r\n
-             string transaction_msg = "TRANSACTION#" + sender + "#" + recipient + "#" + amount_str + CRLF;
-             if (send_message(server_socket, transaction_msg)) {
-                 string response = receive_message(server_socket);
-                 if (!response.empty()) {
-                     safe_print("Server response: " + response);
-                 } else {
-                     safe_print("Warning: No response from server for transaction report");
-                 }
-             } else {
-                 safe_print("Warning: Failed to report transaction to server");
-             }
-             
-             socket_mutex.unlock();
-         } else {
-             safe_print("Warning: Not logged in, transaction not reported to server");
-         }
-     }
-     
-     // Close P2P connection
-     close(client_sock);
- }
- 
- /*
-  * Safe Print
-  * Thread-safe printing function that uses mutex to prevent output mixing.
-  * Multiple threads may want to print simultaneously (main thread, listener thread, handler threads).
-  */
- void safe_print(const string& message) {
-     lock_guard<mutex> lock(cout_mutex);
-     cout << message << endl;
- }
- 
- 
- 
\ No newline at end of file
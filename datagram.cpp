@@ -0,0 +1,502 @@
+/*
+ * P2P Micropayment System - Datagram Transport
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "datagram.h"
+#include "net.h"
+
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+
+using namespace std;
+
+#define ACK_HEADER 12
+
+static void put16(string& out, unsigned value) {
+    out.push_back((char)(value >> 8));
+    out.push_back((char)value);
+}
+
+static void put32(string& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back((char)(value >> shift));
+    }
+}
+
+static void put64(string& out, uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back((char)(value >> shift));
+    }
+}
+
+static uint64_t get_be(const char* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value = (value << 8) | (unsigned char)data[i];
+    }
+    return value;
+}
+
+static bool has_header(const char* data, size_t length, size_t header, DatagramType type) {
+    return length >= header && data[0] == 'P' && data[1] == 'D' && data[2] == (char)type;
+}
+
+int parse_data_datagram(const char* data, size_t length, uint64_t& session, uint32_t& seq, vector<string>& frames,
+                        size_t first) {
+    if (!has_header(data, length, DATAGRAM_HEADER, DATAGRAM_DATA)) {
+        return -1;
+    }
+    int count = (unsigned char)data[3];
+    session = get_be(data + 4, 8);
+    seq = (uint32_t)get_be(data + 12, 4);
+    if (frames.size() < first + count) {
+        frames.resize(first + count);
+    }
+
+    size_t pos = DATAGRAM_HEADER;
+    for (int i = 0; i < count; i++) {
+        if (pos + 2 > length) {
+            return -1;
+        }
+        size_t frame_length = get_be(data + pos, 2);
+        pos += 2;
+        if (pos + frame_length > length) {
+            return -1;
+        }
+        frames[first + i].assign(data + pos, frame_length);
+        pos += frame_length;
+    }
+    return pos == length ? count : -1;
+}
+
+bool add_datagram_ack(string& out, uint64_t session, uint32_t seq) {
+    if (out.empty()) {
+        out.assign("PD");
+        out.push_back((char)DATAGRAM_ACK);
+        out.push_back(0);
+        put64(out, session);
+    } else if ((unsigned char)out[3] == DATAGRAM_MAX_FRAMES) {
+        return false;
+    }
+    put32(out, seq);
+    out[3] = (char)((unsigned char)out[3] + 1);
+    return true;
+}
+
+bool parse_ack_datagram(const char* data, size_t length, uint64_t& session, vector<uint32_t>& seqs) {
+    if (!has_header(data, length, ACK_HEADER, DATAGRAM_ACK)) {
+        return false;
+    }
+    size_t count = (unsigned char)data[3];
+    if (length != ACK_HEADER + 4 * count) {
+        return false;
+    }
+    session = get_be(data + 4, 8);
+    seqs.clear();
+    for (size_t i = 0; i < count; i++) {
+        seqs.push_back((uint32_t)get_be(data + ACK_HEADER + 4 * i, 4));
+    }
+    return true;
+}
+
+DatagramBatch::DatagramBatch()
+    : syscalls(0), buffers(DATAGRAM_BATCH * DATAGRAM_BUFFER), outgoing(DATAGRAM_BATCH), count(0) {}
+
+size_t DatagramBatch::receive(int sock) {
+#ifdef __linux__
+    struct mmsghdr messages[DATAGRAM_BATCH];
+    struct iovec iov[DATAGRAM_BATCH];
+    memset(messages, 0, sizeof(messages));
+    for (size_t i = 0; i < DATAGRAM_BATCH; i++) {
+        iov[i].iov_base = &buffers[i * DATAGRAM_BUFFER];
+        iov[i].iov_len = DATAGRAM_BUFFER;
+        messages[i].msg_hdr.msg_iov = &iov[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &addrs[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    }
+    syscalls++;
+    int received = recvmmsg(sock, messages, DATAGRAM_BATCH, MSG_DONTWAIT, NULL);
+    if (received <= 0) {
+        return 0;
+    }
+    for (int i = 0; i < received; i++) {
+        // A truncated datagram fails to parse
+        lengths[i] = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) ? 0 : messages[i].msg_len;
+    }
+    return received;
+#else
+    size_t received = 0;
+    while (received < DATAGRAM_BATCH) {
+        socklen_t addr_length = sizeof(addrs[received]);
+        syscalls++;
+        ssize_t length = recvfrom(sock, &buffers[received * DATAGRAM_BUFFER], DATAGRAM_BUFFER, MSG_DONTWAIT,
+                                  (struct sockaddr*)&addrs[received], &addr_length);
+        if (length < 0) {
+            break;
+        }
+        lengths[received++] = length;
+    }
+    return received;
+#endif
+}
+
+string& DatagramBatch::add(const struct sockaddr_in& addr) {
+    targets[count] = addr;
+    outgoing[count].clear();
+    return outgoing[count++];
+}
+
+void DatagramBatch::send(int sock) {
+#ifdef __linux__
+    struct mmsghdr messages[DATAGRAM_BATCH];
+    struct iovec iov[DATAGRAM_BATCH];
+    memset(messages, 0, sizeof(messages));
+    for (size_t i = 0; i < count; i++) {
+        iov[i].iov_base = &outgoing[i][0];
+        iov[i].iov_len = outgoing[i].size();
+        messages[i].msg_hdr.msg_iov = &iov[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &targets[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(targets[i]);
+    }
+    size_t sent = 0;
+    while (sent < count) {
+        syscalls++;
+        int n = sendmmsg(sock, messages + sent, count - sent, 0);
+        if (n == -1) {
+            if (errno != EINTR) {
+                sent++;  // The first one failed; drop it and go on with the rest
+            }
+            continue;
+        }
+        sent += n;
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        syscalls++;
+        sendto(sock, outgoing[i].data(), outgoing[i].size(), 0, (const struct sockaddr*)&targets[i],
+               sizeof(targets[i]));
+    }
+#endif
+    count = 0;
+}
+
+DatagramDedup::DatagramDedup() : clock(0), duplicate_count(0), late_count(0) {}
+
+// Moves every bit up by shift positions (bit i becomes bit i + shift)
+static void shift_window(uint64_t* seen, size_t words, uint32_t shift) {
+    size_t word_shift = shift / 64;
+    unsigned bit_shift = shift % 64;
+    for (size_t w = words; w-- > 0;) {
+        uint64_t value = 0;
+        if (w >= word_shift) {
+            value = seen[w - word_shift] << bit_shift;
+            if (bit_shift != 0 && w > word_shift) {
+                value |= seen[w - word_shift - 1] >> (64 - bit_shift);
+            }
+        }
+        seen[w] = value;
+    }
+}
+
+bool DatagramDedup::first_time(uint64_t session, uint32_t seq) {
+    const size_t words = DATAGRAM_WINDOW / 64;
+    clock++;
+    unordered_map<uint64_t, Window>::iterator it = windows.find(session);
+    if (it == windows.end()) {
+        if (windows.size() >= DATAGRAM_SESSIONS) {
+            // Forget the sender heard from least recently
+            unordered_map<uint64_t, Window>::iterator oldest = windows.begin();
+            for (it = windows.begin(); it != windows.end(); ++it) {
+                if (it->second.last_used < oldest->second.last_used) {
+                    oldest = it;
+                }
+            }
+            windows.erase(oldest);
+        }
+        Window& window = windows[session];
+        window.highest = seq;
+        memset(window.seen, 0, sizeof(window.seen));
+        window.seen[0] = 1;
+        window.last_used = clock;
+        return true;
+    }
+
+    Window& window = it->second;
+    window.last_used = clock;
+    int32_t ahead = (int32_t)(seq - window.highest);  // Wraps around with seq
+    if (ahead > 0) {
+        if (ahead >= DATAGRAM_WINDOW) {
+            memset(window.seen, 0, sizeof(window.seen));
+        } else {
+            shift_window(window.seen, words, ahead);
+        }
+        window.seen[0] |= 1;
+        window.highest = seq;
+        return true;
+    }
+    uint32_t age = (uint32_t)-ahead;
+    if (age >= DATAGRAM_WINDOW) {
+        // Cannot be told apart from a new one; acknowledging it unprocessed could lose the transfer
+        late_count++;
+        return true;
+    }
+    if ((window.seen[age / 64] >> (age % 64)) & 1) {
+        duplicate_count++;
+        return false;
+    }
+    window.seen[age / 64] |= (uint64_t)1 << (age % 64);
+    return true;
+}
+
+DatagramSender::DatagramSender()
+    : sock(-1), wakeup_read(-1), wakeup_write(-1), session(0), next_seq(0), running(false), frame_count(0),
+      datagram_count(0), retransmit_count(0), failed_count(0), syscall_count(0) {}
+
+DatagramSender::~DatagramSender() {
+    stop();
+}
+
+bool DatagramSender::start(string& error) {
+    if (running) {
+        return true;
+    }
+    sock = open_datagram_socket(0);
+    if (sock == -1) {
+        error = "Cannot open a UDP socket";
+        return false;
+    }
+    if (!open_wakeup(wakeup_read, wakeup_write)) {
+        close(sock);
+        sock = -1;
+        error = "Cannot create the wakeup descriptor";
+        return false;
+    }
+    random_device device;
+    session = ((uint64_t)device() << 32) ^ device();
+    next_seq = device();
+    running = true;
+    sender = thread(&DatagramSender::run, this);
+    return true;
+}
+
+bool DatagramSender::stop() {
+    {
+        // Under the lock, so send() either queues before the sender thread
+        // fails what is left or sees it stopped
+        lock_guard<mutex> lock(send_mutex);
+        if (!running) {
+            return false;
+        }
+        running = false;
+    }
+    signal_wakeup(wakeup_write);
+    sender.join();
+    close(sock);
+    close_wakeup(wakeup_read, wakeup_write);
+    sock = wakeup_read = wakeup_write = -1;
+    return true;
+}
+
+bool DatagramSender::send(const struct sockaddr_in& addr, const string& frame) {
+    if (DATAGRAM_HEADER + 2 + frame.size() > DATAGRAM_MAX_PAYLOAD) {
+        return false;
+    }
+    Waiter waiter = { &frame, addr, WAITING };
+    unique_lock<mutex> lock(send_mutex);
+    if (!running) {
+        return false;
+    }
+    if (queued.empty()) {
+        signal_wakeup(wakeup_write);  // Otherwise the thread has a wakeup pending already
+    }
+    queued.push_back(&waiter);
+    done_cv.wait(lock, [&waiter] { return waiter.state != WAITING; });
+    return waiter.state == ACKED;
+}
+
+/*
+ * Run
+ * Sender thread: packs the queued frames, sends, then sleeps until an ack,
+ * a new frame or the next retransmission is due.
+ */
+void DatagramSender::run() {
+    DatagramBatch out;
+    DatagramBatch in;
+    vector<Waiter*> waiting;  // Queued, not yet in a datagram (the window was full)
+    while (true) {
+        clear_wakeup(wakeup_read);
+        {
+            lock_guard<mutex> lock(send_mutex);
+            waiting.insert(waiting.end(), queued.begin(), queued.end());
+            queued.clear();
+            if (!running) {
+                break;
+            }
+        }
+        waiting.erase(waiting.begin(), waiting.begin() + pack(waiting, out));
+        int timeout_ms = retransmit(out);
+        if (out.pending() > 0) {
+            out.send(sock);
+        }
+        syscall_count = out.syscalls + in.syscalls;
+
+        struct pollfd fds[2] = { { sock, POLLIN, 0 }, { wakeup_read, POLLIN, 0 } };
+        if (poll(fds, 2, timeout_ms) > 0 && fds[0].revents != 0) {
+            receive_acks(in);
+        }
+    }
+
+    // Stopped: whatever has not been acknowledged yet fails
+    for (auto& entry : in_flight) {
+        waiting.insert(waiting.end(), entry.second.waiters.begin(), entry.second.waiters.end());
+    }
+    in_flight.clear();
+    finish(waiting, FAILED);
+}
+
+/*
+ * Pack
+ * Puts waiting frames into datagrams, one per destination, in the order
+ * they were queued, as long as the window allows.
+ * Returns: number of frames packed (the first ones of waiting)
+ */
+size_t DatagramSender::pack(const vector<Waiter*>& waiting, DatagramBatch& batch) {
+    unordered_map<uint64_t, uint32_t> open;  // Destination -> seq of the datagram being filled
+    vector<uint32_t> order;                  // Open datagrams, oldest first
+    size_t packed = 0;
+    for (; packed < waiting.size(); packed++) {
+        Waiter* waiter = waiting[packed];
+        const string& frame = *waiter->frame;
+        uint64_t destination = ((uint64_t)waiter->addr.sin_addr.s_addr << 16) | waiter->addr.sin_port;
+
+        InFlight* datagram = NULL;
+        unordered_map<uint64_t, uint32_t>::iterator it = open.find(destination);
+        if (it != open.end()) {
+            datagram = &in_flight[it->second];
+            if (datagram->payload.size() + 2 + frame.size() > DATAGRAM_MAX_PAYLOAD ||
+                datagram->waiters.size() == DATAGRAM_MAX_FRAMES) {
+                transmit(*datagram, batch);
+                order.erase(find(order.begin(), order.end(), it->second));
+                open.erase(it);
+                datagram = NULL;
+            }
+        }
+        if (datagram == NULL) {
+            if (in_flight.size() >= DATAGRAM_WINDOW) {
+                break;  // The rest waits for acks
+            }
+            uint32_t seq = next_seq++;
+            datagram = &in_flight[seq];
+            datagram->addr = waiter->addr;
+            datagram->attempts = 0;
+            datagram->payload.assign("PD");
+            datagram->payload.push_back((char)DATAGRAM_DATA);
+            datagram->payload.push_back(0);
+            put64(datagram->payload, session);
+            put32(datagram->payload, seq);
+            open[destination] = seq;
+            order.push_back(seq);
+        }
+        put16(datagram->payload, frame.size());
+        datagram->payload.append(frame);
+        datagram->waiters.push_back(waiter);
+        datagram->payload[3] = (char)datagram->waiters.size();
+    }
+    for (uint32_t seq : order) {
+        transmit(in_flight[seq], batch);
+    }
+    return packed;
+}
+
+void DatagramSender::transmit(InFlight& datagram, DatagramBatch& batch) {
+    if (batch.full()) {
+        batch.send(sock);
+    }
+    batch.add(datagram.addr) = datagram.payload;
+    datagram.deadline = chrono::steady_clock::now() + chrono::milliseconds(DATAGRAM_RTO_MS << datagram.attempts);
+    datagram_count++;
+    if (datagram.attempts == 0) {
+        frame_count += datagram.waiters.size();
+    }
+}
+
+/*
+ * Retransmit
+ * Resends the datagrams whose timeout expired and fails those out of
+ * retransmissions.
+ * Returns: milliseconds until the next timeout (-1 = nothing in flight)
+ */
+int DatagramSender::retransmit(DatagramBatch& batch) {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    chrono::steady_clock::time_point next = chrono::steady_clock::time_point::max();
+    vector<Waiter*> failed;
+    for (unordered_map<uint32_t, InFlight>::iterator it = in_flight.begin(); it != in_flight.end();) {
+        InFlight& datagram = it->second;
+        if (datagram.deadline <= now) {
+            if (datagram.attempts == DATAGRAM_RETRIES) {
+                failed.insert(failed.end(), datagram.waiters.begin(), datagram.waiters.end());
+                it = in_flight.erase(it);
+                continue;
+            }
+            datagram.attempts++;
+            retransmit_count++;
+            transmit(datagram, batch);
+        }
+        next = min(next, datagram.deadline);
+        ++it;
+    }
+    finish(failed, FAILED);
+    if (next == chrono::steady_clock::time_point::max()) {
+        return -1;
+    }
+    // Rounded up, so poll() does not return just before the deadline
+    return (int)chrono::duration_cast<chrono::milliseconds>(next - now + chrono::microseconds(999)).count();
+}
+
+void DatagramSender::receive_acks(DatagramBatch& batch) {
+    vector<Waiter*> acked;
+    vector<uint32_t> seqs;
+    size_t received;
+    do {
+        received = batch.receive(sock);
+        for (size_t i = 0; i < received; i++) {
+            uint64_t ack_session;
+            if (!parse_ack_datagram(batch.data(i), batch.length(i), ack_session, seqs) || ack_session != session) {
+                continue;
+            }
+            for (uint32_t seq : seqs) {
+                unordered_map<uint32_t, InFlight>::iterator it = in_flight.find(seq);
+                if (it != in_flight.end()) {
+                    acked.insert(acked.end(), it->second.waiters.begin(), it->second.waiters.end());
+                    in_flight.erase(it);
+                }
+            }
+        }
+    } while (received == DATAGRAM_BATCH);
+    finish(acked, ACKED);
+}
+
+void DatagramSender::finish(vector<Waiter*>& waiters, WaiterState state) {
+    if (waiters.empty()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(send_mutex);
+        for (Waiter* waiter : waiters) {
+            waiter->state = state;
+        }
+    }
+    if (state == FAILED) {
+        failed_count += waiters.size();
+    }
+    done_cv.notify_all();
+    waiters.clear();
+}
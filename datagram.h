@@ -0,0 +1,215 @@
+/*
+ * P2P Micropayment System - Datagram Transport
+ * Course: Computer Networks (Fall 2025)
+ *
+ * A TCP connection per transfer costs a handshake and a teardown for one
+ * frame of a few dozen bytes. With the datagram transport, transfer frames
+ * go to the recipient's P2P port over UDP instead, several to a datagram
+ * (integers big-endian):
+ *
+ *   DATA  "PD" 0x01 <count:1> <session:8> <seq:4> { <length:2> <frame> } x count
+ *   ACK   "PD" 0x02 <count:1> <session:8> { <seq:4> } x count
+ *
+ * session is a random number per sender and seq numbers its DATA
+ * datagrams. The recipient hands the frames to the frame handler, then
+ * acknowledges the seq; a seq it has seen before is acknowledged again
+ * without handing its frames over twice. Frames always carry a transfer
+ * ID, so a seq too old to be told apart can safely be handed over again. The sender retransmits a datagram
+ * that is not acknowledged after DATAGRAM_RTO_MS, doubling the timeout each
+ * time, and gives up after DATAGRAM_RETRIES retransmissions.
+ *
+ * Frames queued for the same recipient while the sender thread is busy
+ * share a datagram (up to DATAGRAM_MAX_PAYLOAD bytes), so batching grows
+ * with the load without delaying a lone transfer. Both sides move up to
+ * DATAGRAM_BATCH datagrams per system call (sendmmsg/recvmmsg on Linux).
+ *
+ * As with TCP, a transfer whose ack was lost may still have arrived; its
+ * transfer ID makes a retry over another transport safe. IPv4 only, like
+ * the P2P listener.
+ */
+
+#ifndef DATAGRAM_H
+#define DATAGRAM_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#define DATAGRAM_MAX_PAYLOAD 1400  // Bytes per datagram; stays below a typical path MTU
+#define DATAGRAM_BUFFER 2048       // Receive buffer per datagram; longer ones are dropped
+#define DATAGRAM_HEADER 16         // DATA header; an ACK header is 12 bytes
+#define DATAGRAM_MAX_FRAMES 255    // Frames per DATA datagram, seqs per ACK
+#define DATAGRAM_BATCH 64          // Datagrams per sendmmsg()/recvmmsg()
+#define DATAGRAM_RTO_MS 20         // First retransmission timeout
+#define DATAGRAM_RETRIES 4         // Retransmissions before a datagram is given up
+#define DATAGRAM_WINDOW 1024       // Unacknowledged datagrams per sender
+#define DATAGRAM_SESSIONS 4096     // Senders a receiver remembers seqs of
+
+enum DatagramType {
+    DATAGRAM_DATA = 1,
+    DATAGRAM_ACK = 2
+};
+
+// Parses a DATA datagram. Its frames are assigned to frames[first], frames[first + 1], ...
+// (the vector grows as needed, existing strings are reused).
+// Returns: number of frames, or -1 if it is not a well-formed DATA datagram
+int parse_data_datagram(const char* data, size_t length, uint64_t& session, uint32_t& seq,
+                        std::vector<std::string>& frames, size_t first);
+
+// Appends seq to the ACK in out, starting a new ACK if out is empty.
+// Returns: false if out already holds DATAGRAM_MAX_FRAMES seqs
+bool add_datagram_ack(std::string& out, uint64_t session, uint32_t seq);
+
+// Parses an ACK datagram; seqs receives the acknowledged seqs.
+// Returns: false if it is not a well-formed ACK
+bool parse_ack_datagram(const char* data, size_t length, uint64_t& session, std::vector<uint32_t>& seqs);
+
+/*
+ * Datagram Batch
+ * Buffers for moving up to DATAGRAM_BATCH datagrams in one system call
+ * (sendmmsg/recvmmsg on Linux, a loop of sendto/recvfrom elsewhere).
+ */
+class DatagramBatch {
+public:
+    DatagramBatch();
+
+    // Receives the datagrams already waiting on sock, without blocking.
+    // Returns: number received (0 if none)
+    size_t receive(int sock);
+    const char* data(size_t i) const { return &buffers[i * DATAGRAM_BUFFER]; }
+    size_t length(size_t i) const { return lengths[i]; }
+    const struct sockaddr_in& from(size_t i) const { return addrs[i]; }
+
+    // Queues an outgoing datagram to addr; fill in the returned buffer
+    std::string& add(const struct sockaddr_in& addr);
+    size_t pending() const { return count; }
+    bool full() const { return count == DATAGRAM_BATCH; }
+    // Sends the queued datagrams. One that the kernel refuses is dropped,
+    // like a datagram lost on the way.
+    void send(int sock);
+
+    unsigned long syscalls;  // sendmmsg/recvmmsg (or sendto/recvfrom) calls so far
+
+private:
+    std::vector<char> buffers;                   // Receive buffers, DATAGRAM_BUFFER each
+    size_t lengths[DATAGRAM_BATCH];
+    struct sockaddr_in addrs[DATAGRAM_BATCH];    // Senders of the received datagrams
+    std::vector<std::string> outgoing;           // Reused from batch to batch
+    struct sockaddr_in targets[DATAGRAM_BATCH];  // Destinations of outgoing
+    size_t count;                                // Datagrams queued by add()
+};
+
+/*
+ * Datagram Dedup
+ * Remembers the last DATAGRAM_WINDOW seqs of up to DATAGRAM_SESSIONS
+ * senders. A seq older than the window may be a retransmission that fell
+ * behind (the seqs of a sender are shared by all its recipients), so it is
+ * reported as new rather than dropped: the receiver processes it again and
+ * the transfer IDs, which the datagram transport always sends, drop the
+ * frames that were already credited. Only a seq the window proves was seen
+ * is a duplicate, so every datagram acknowledged has been processed.
+ */
+class DatagramDedup {
+public:
+    DatagramDedup();
+
+    // Returns: false only if (session, seq) is known to have been seen
+    bool first_time(uint64_t session, uint32_t seq);
+    unsigned long duplicates() const { return duplicate_count; }
+    unsigned long late() const { return late_count; }  // Seqs older than the window
+
+private:
+    struct Window {
+        uint32_t highest;                          // Highest seq seen
+        uint64_t seen[DATAGRAM_WINDOW / 64];       // Bit (highest - seq) set = seen
+        unsigned long last_used;
+    };
+
+    std::unordered_map<uint64_t, Window> windows;  // Session -> seqs seen
+    unsigned long clock;                           // Advances on every lookup, for evicting
+    unsigned long duplicate_count;
+    unsigned long late_count;
+};
+
+/*
+ * Datagram Sender
+ * Sends frames over UDP from one socket and one background thread, which
+ * packs what the callers queued into datagrams, retransmits and matches the
+ * acks. send() blocks its caller until its frame is acknowledged.
+ */
+class DatagramSender {
+public:
+    DatagramSender();
+    ~DatagramSender();
+
+    // Opens the socket and starts the sender thread.
+    // Returns: false (and sets error) if the socket cannot be opened
+    bool start(std::string& error);
+    // Fails the frames still waiting and joins the thread.
+    // Returns: false if it was not running
+    bool stop();
+    bool started() const { return running; }
+
+    // Sends frame to addr along with the other frames queued for it.
+    // Returns: true once acknowledged; false if not acknowledged after every
+    // retransmission, too long for a datagram, or the sender is not running
+    bool send(const struct sockaddr_in& addr, const std::string& frame);
+
+    unsigned long frames_sent() const { return frame_count; }
+    unsigned long datagrams_sent() const { return datagram_count; }
+    unsigned long retransmits() const { return retransmit_count; }
+    unsigned long frames_failed() const { return failed_count; }
+    unsigned long syscalls() const { return syscall_count; }
+
+private:
+    enum WaiterState { WAITING, ACKED, FAILED };
+
+    // A send() in progress; lives on the caller's stack
+    struct Waiter {
+        const std::string* frame;
+        struct sockaddr_in addr;
+        WaiterState state;
+    };
+
+    struct InFlight {
+        struct sockaddr_in addr;
+        std::string payload;
+        std::vector<Waiter*> waiters;
+        std::chrono::steady_clock::time_point deadline;
+        int attempts;  // Retransmissions so far
+    };
+
+    void run();
+    size_t pack(const std::vector<Waiter*>& waiting, DatagramBatch& batch);
+    void transmit(InFlight& datagram, DatagramBatch& batch);
+    int retransmit(DatagramBatch& batch);
+    void receive_acks(DatagramBatch& batch);
+    void finish(std::vector<Waiter*>& waiters, WaiterState state);
+
+    int sock;
+    int wakeup_read;
+    int wakeup_write;
+    uint64_t session;
+    uint32_t next_seq;
+    std::unordered_map<uint32_t, InFlight> in_flight;  // Seq -> datagram; sender thread only
+    std::vector<Waiter*> queued;                        // Handed over by send()
+    std::mutex send_mutex;                              // Protects queued and the waiters' state
+    std::condition_variable done_cv;
+    std::atomic<bool> running;
+    std::thread sender;
+
+    std::atomic<unsigned long> frame_count;
+    std::atomic<unsigned long> datagram_count;
+    std::atomic<unsigned long> retransmit_count;
+    std::atomic<unsigned long> failed_count;
+    std::atomic<unsigned long> syscall_count;
+};
+
+#endif
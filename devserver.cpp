@@ -0,0 +1,273 @@
+/*
+ * P2P Micropayment System - Development Server
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Local stand-in for the TA's server, for trying the client without it. It
+ * speaks the same protocol (REGISTER, login, List, TRANSACTION, Exit) with
+ * the same replies, keeps balances in memory and applies every TRANSACTION
+ * report to them.
+ *
+ * It also implements the subscription extension the TA's server lacks: a
+ * connection that sends SUBSCRIBE gets a List reply as its snapshot and from
+ * then on the changes, pushed as they happen (see protocol.h):
+ *   EVENT#JOIN#<user>#<ip>#<port>   a user logged in
+ *   EVENT#LEAVE#<user>              a user logged out or disconnected
+ *   EVENT#BALANCE#<balance>         a TRANSACTION changed the subscriber's balance
+ * so clients started with --push-updates never have to poll with List.
+ *
+ * One thread serves every connection with poll(); replies and events are
+ * sent with blocking send()s, which is plenty for a handful of clients.
+ *
+ * Usage: ./devserver <port> [--balance B]
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cstdio>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+
+#include "protocol.h"
+#include "net.h"
+
+using namespace std;
+
+#define DEVSERVER_BACKLOG 128
+#define DEVSERVER_PUBLIC_KEY "DEVSERVER-PUBLIC-KEY"
+
+// One client connection
+struct Connection {
+    int fd;
+    string ip;          // Peer address, listed as the user's IP after login
+    string buffer;      // Received bytes not yet split into lines
+    string user;        // Logged-in user ("" before login)
+    bool subscribed;    // Gets EVENT# lines
+    bool closing;       // Said Bye; closed after this batch
+};
+
+map<string, int> balances;       // Registered users
+map<string, OnlineUser> online;  // Logged-in users, sorted like a List reply
+vector<Connection> connections;
+int default_balance = 10000;     // Balance of REGISTER without an amount
+
+/*
+ * List Reply
+ * Same format as the TA's server: balance, public key, count, users
+ */
+string make_list_reply(const string& user) {
+    string reply = to_string(balances[user]) + CRLF + DEVSERVER_PUBLIC_KEY + CRLF + to_string(online.size()) + CRLF;
+    for (const auto& entry : online) {
+        reply += entry.second.username + "#" + entry.second.ip + "#" + to_string(entry.second.port) + CRLF;
+    }
+    return reply;
+}
+
+// Sends an event to every subscriber except skip (-1 = all)
+void broadcast(const string& event, int skip) {
+    for (Connection& connection : connections) {
+        if (connection.subscribed && connection.fd != skip) {
+            send_message(connection.fd, event);
+        }
+    }
+}
+
+// Sends user's new balance to their subscribed connection, if any
+void push_balance(const string& user) {
+    for (Connection& connection : connections) {
+        if (connection.subscribed && connection.user == user) {
+            send_message(connection.fd, make_balance_event(balances[user]));
+        }
+    }
+}
+
+// Takes connection's user offline and tells the subscribers
+void log_out(Connection& connection) {
+    if (connection.user.empty()) {
+        return;
+    }
+    online.erase(connection.user);
+    broadcast(make_leave_event(connection.user), connection.fd);
+    cout << connection.user << " logged out (" << online.size() << " online)" << endl;
+    connection.user.clear();
+}
+
+// Splits line at '#'
+vector<string> split_fields(const string& line) {
+    vector<string> fields;
+    size_t start = 0, pos;
+    while ((pos = line.find('#', start)) != string::npos) {
+        fields.push_back(line.substr(start, pos - start));
+        start = pos + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+}
+
+/*
+ * Handle Line
+ * Answers one request line from connection
+ */
+void handle_line(Connection& connection, const string& line) {
+    vector<string> fields = split_fields(line);
+
+    if (fields[0] == "REGISTER" && fields.size() >= 2 && !fields[1].empty()) {
+        if (balances.count(fields[1]) > 0) {
+            send_message(connection.fd, "210 FAIL" CRLF);
+            return;
+        }
+        balances[fields[1]] = fields.size() >= 3 ? atoi(fields[2].c_str()) : default_balance;
+        send_message(connection.fd, "100 OK" CRLF);
+    } else if (line == "List") {
+        if (connection.user.empty()) {
+            send_message(connection.fd, "220 AUTH_FAIL" CRLF);
+            return;
+        }
+        send_message(connection.fd, make_list_reply(connection.user));
+    } else if (line == "SUBSCRIBE") {
+        if (connection.user.empty()) {
+            send_message(connection.fd, "220 AUTH_FAIL" CRLF);
+            return;
+        }
+        // The snapshot goes out before the first event, on the same stream
+        send_message(connection.fd, make_list_reply(connection.user));
+        connection.subscribed = true;
+    } else if (fields[0] == "TRANSACTION" && fields.size() == 4) {
+        int amount = atoi(fields[3].c_str());
+        if (balances.count(fields[1]) == 0 || balances.count(fields[2]) == 0 || amount <= 0) {
+            send_message(connection.fd, "Transfer FAIL!" CRLF);
+            return;
+        }
+        balances[fields[1]] -= amount;
+        balances[fields[2]] += amount;
+        send_message(connection.fd, "Transfer OK!" CRLF);
+        push_balance(fields[1]);
+        push_balance(fields[2]);
+    } else if (line == "Exit") {
+        log_out(connection);
+        connection.subscribed = false;
+        send_message(connection.fd, "Bye" CRLF);
+        connection.closing = true;
+    } else if (fields.size() == 2 && !fields[0].empty()) {
+        // Login: <username>#<port>
+        int port = atoi(fields[1].c_str());
+        if (balances.count(fields[0]) == 0 || online.count(fields[0]) > 0 || port <= 0 ||
+            !connection.user.empty()) {
+            send_message(connection.fd, "220 AUTH_FAIL" CRLF);
+            return;
+        }
+        OnlineUser user;
+        user.username = fields[0];
+        user.ip = connection.ip;
+        user.port = port;
+        online[user.username] = user;
+        connection.user = user.username;
+        send_message(connection.fd, make_list_reply(user.username));
+        broadcast(make_join_event(user), connection.fd);
+        cout << user.username << " logged in from " << user.ip << ":" << user.port << " (" << online.size()
+             << " online)" << endl;
+    } else {
+        send_message(connection.fd, "230 Input format error" CRLF);
+    }
+}
+
+/*
+ * Receive
+ * Reads what arrived on connection and answers every complete line.
+ * Returns: false if the connection is finished
+ */
+bool receive(Connection& connection) {
+    char buffer[BUFFER_SIZE];
+    ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+    if (received == -1 && errno == EINTR) {
+        return true;
+    }
+    if (received <= 0) {
+        return false;
+    }
+    connection.buffer.append(buffer, received);
+
+    size_t newline;
+    while (!connection.closing && (newline = connection.buffer.find('\n')) != string::npos) {
+        string line = connection.buffer.substr(0, newline);
+        connection.buffer.erase(0, newline + 1);
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+        if (!line.empty()) {
+            handle_line(connection, line);
+        }
+    }
+    return !connection.closing;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <port> [--balance B]" << endl;
+        return 1;
+    }
+    int port = atoi(argv[1]);
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--balance" && i + 1 < argc) {
+            default_balance = atoi(argv[++i]);
+        } else {
+            cout << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = open_listen_socket(port, false, DEVSERVER_BACKLOG);
+    if (listen_fd == -1) {
+        return 1;
+    }
+    cout << "Development server listening on port " << port << endl;
+
+    vector<struct pollfd> fds;
+    while (true) {
+        fds.clear();
+        struct pollfd listen_poll = { listen_fd, POLLIN, 0 };
+        fds.push_back(listen_poll);
+        for (const Connection& connection : connections) {
+            struct pollfd entry = { connection.fd, POLLIN, 0 };
+            fds.push_back(entry);
+        }
+        if (poll(fds.data(), fds.size(), -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            return 1;
+        }
+
+        // Connections first: fds[i + 1] belongs to connections[i] until one is removed
+        for (size_t i = connections.size(); i-- > 0;) {
+            if (fds[i + 1].revents == 0 || receive(connections[i])) {
+                continue;
+            }
+            log_out(connections[i]);
+            close(connections[i].fd);
+            connections.erase(connections.begin() + i);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            struct sockaddr_in addr;
+            socklen_t length = sizeof(addr);
+            int fd = accept(listen_fd, (struct sockaddr*)&addr, &length);
+            if (fd != -1) {
+                char ip[INET_ADDRSTRLEN];
+                inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+                Connection connection = { fd, ip, "", "", false, false };
+                connections.push_back(connection);
+            }
+        }
+    }
+}
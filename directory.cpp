@@ -0,0 +1,126 @@
+/*
+ * P2P Micropayment System - Online User Directory
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "directory.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void Directory::replace(const vector<OnlineUser>& list) {
+    // Intern and parse outside the lock; the intern table has its own
+    vector<UserId> ids;
+    vector<PeerEndpoint> endpoints;
+    ids.reserve(list.size());
+    endpoints.reserve(list.size());
+    for (const OnlineUser& user : list) {
+        PeerEndpoint endpoint;
+        if (!pack_endpoint(user.ip, user.port, endpoint)) {
+            // Not a numeric address: resolve it before anyone dials it
+            resolver.prefetch(user.ip);
+        }
+        ids.push_back(user_names().intern(user.username));
+        endpoints.push_back(endpoint);
+    }
+
+    lock_guard<mutex> lock(users_mutex);
+    users.clear();
+    users.reserve(ids.size());
+    hostnames.clear();
+    for (size_t i = 0; i < ids.size(); i++) {
+        users[ids[i]] = endpoints[i];
+        if (!endpoint_resolved(endpoints[i])) {
+            hostnames[ids[i]] = list[i].ip;
+        }
+    }
+}
+
+void Directory::add(const OnlineUser& user) {
+    PeerEndpoint endpoint;
+    if (!pack_endpoint(user.ip, user.port, endpoint)) {
+        resolver.prefetch(user.ip);
+    }
+    UserId id = user_names().intern(user.username);
+
+    lock_guard<mutex> lock(users_mutex);
+    users[id] = endpoint;
+    if (endpoint_resolved(endpoint)) {
+        hostnames.erase(id);
+    } else {
+        hostnames[id] = user.ip;
+    }
+}
+
+bool Directory::remove(const string& username) {
+    UserId id = user_names().find(username);
+    if (id == NO_USER) {
+        return false;
+    }
+    lock_guard<mutex> lock(users_mutex);
+    hostnames.erase(id);
+    return users.erase(id);
+}
+
+bool Directory::find(UserId id, PeerEndpoint& endpoint) {
+    string host;
+    {
+        lock_guard<mutex> lock(users_mutex);
+        const PeerEndpoint* found = users.find(id);
+        if (found == NULL) {
+            return false;
+        }
+        endpoint = *found;  // Copy so the caller can use it without holding the lock
+        if (endpoint_resolved(endpoint)) {
+            return true;
+        }
+        host = hostnames[id];
+    }
+    return resolver.resolve(host, endpoint_port(endpoint), endpoint);
+}
+
+bool Directory::find(UserId id, OnlineUser& user) const {
+    lock_guard<mutex> lock(users_mutex);
+    const PeerEndpoint* found = users.find(id);
+    if (found == NULL) {
+        return false;
+    }
+    user.username = user_names().name(id);
+    if (endpoint_resolved(*found)) {
+        user.ip = endpoint_ip(*found);
+    } else {
+        user.ip = hostnames.find(id)->second;
+    }
+    user.port = endpoint_port(*found);
+    return true;
+}
+
+bool Directory::find(const string& username, OnlineUser& user) const {
+    UserId id = user_names().find(username);
+    return id != NO_USER && find(id, user);
+}
+
+vector<string> Directory::usernames_except(const string& self) const {
+    vector<UserId> ids;
+    {
+        lock_guard<mutex> lock(users_mutex);
+        ids.reserve(users.size());
+        users.for_each([&ids](UserId id, const PeerEndpoint&) { ids.push_back(id); });
+    }
+
+    UserId self_id = user_names().find(self);
+    vector<string> names;
+    for (UserId id : ids) {
+        if (id != self_id) {
+            names.push_back(user_names().name(id));
+        }
+    }
+    sort(names.begin(), names.end());
+    return names;
+}
+
+size_t Directory::size() const {
+    lock_guard<mutex> lock(users_mutex);
+    return users.size();
+}
@@ -0,0 +1,61 @@
+/*
+ * P2P Micropayment System - Online User Directory
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Thread-safe table of the online users from the last login/List reply.
+ * The main thread replaces it after every List and looks recipients up in it;
+ * handler threads may read it at the same time. With a subscribed session,
+ * the session's reader thread keeps it current with add() and remove(). Users are keyed by their
+ * interned UserId (see intern.h) in a flat hash table (see flat_map.h);
+ * each entry is the peer's ready-to-connect address (see endpoint.h).
+ *
+ * Numeric addresses are packed when the List reply is applied. Hostnames are
+ * handed to the resolver in the background and looked up in its cache when
+ * the user is dialed.
+ */
+
+#ifndef DIRECTORY_H
+#define DIRECTORY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+#include "protocol.h"
+#include "intern.h"
+#include "flat_map.h"
+#include "endpoint.h"
+#include "resolver.h"
+
+class Directory {
+public:
+    // Replaces the whole table with the users of a List reply
+    void replace(const std::vector<OnlineUser>& users);
+
+    // Adds or updates one user (a pushed join event)
+    void add(const OnlineUser& user);
+    // Returns: false if the user was not listed (a pushed leave event)
+    bool remove(const std::string& username);
+
+    // Returns: true and fills user if the user is online
+    bool find(UserId id, OnlineUser& user) const;
+    bool find(const std::string& username, OnlineUser& user) const;
+
+    // Returns: true and fills endpoint if the user is online and their
+    // address resolves (may wait for DNS the first time a hostname is dialed)
+    bool find(UserId id, PeerEndpoint& endpoint);
+
+    // All online usernames except self, in sorted order
+    std::vector<std::string> usernames_except(const std::string& self) const;
+
+    size_t size() const;
+
+private:
+    mutable std::mutex users_mutex;       // Protects users and hostnames
+    FlatHashMap<PeerEndpoint> users;      // UserId -> address (AF_UNSPEC if a hostname)
+    std::unordered_map<UserId, std::string> hostnames;  // Users listed with a hostname
+    Resolver resolver;                    // Cached, background hostname lookups
+};
+
+#endif
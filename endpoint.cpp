@@ -0,0 +1,111 @@
+/*
+ * P2P Micropayment System - Peer Endpoints
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "endpoint.h"
+
+#include <cstring>
+#include <vector>
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+
+using namespace std;
+
+bool pack_endpoint(const string& ip, int port, PeerEndpoint& endpoint) {
+    memset(&endpoint, 0, sizeof(endpoint));
+    if (inet_pton(AF_INET, ip.c_str(), &endpoint.addr.v4.sin_addr) == 1) {
+        endpoint.addr.v4.sin_family = AF_INET;
+    } else if (inet_pton(AF_INET6, ip.c_str(), &endpoint.addr.v6.sin6_addr) == 1) {
+        endpoint.addr.v6.sin6_family = AF_INET6;
+    } else {
+        endpoint.addr.sa.sa_family = AF_UNSPEC;
+    }
+    set_endpoint_port(endpoint, port);
+    return endpoint_resolved(endpoint);
+}
+
+void set_endpoint_port(PeerEndpoint& endpoint, int port) {
+    // sin_port and sin6_port are at the same offset
+    endpoint.addr.v4.sin_port = htons((uint16_t)port);
+}
+
+int endpoint_port(const PeerEndpoint& endpoint) {
+    return ntohs(endpoint.addr.v4.sin_port);
+}
+
+string endpoint_ip(const PeerEndpoint& endpoint) {
+    char text[INET6_ADDRSTRLEN];
+    const void* src;
+    if (endpoint.addr.sa.sa_family == AF_INET) {
+        src = &endpoint.addr.v4.sin_addr;
+    } else if (endpoint.addr.sa.sa_family == AF_INET6) {
+        src = &endpoint.addr.v6.sin6_addr;
+    } else {
+        return "";
+    }
+    if (inet_ntop(endpoint.addr.sa.sa_family, src, text, sizeof(text)) == NULL) {
+        return "";
+    }
+    return text;
+}
+
+socklen_t endpoint_length(const PeerEndpoint& endpoint) {
+    return endpoint.addr.sa.sa_family == AF_INET6 ? sizeof(endpoint.addr.v6) : sizeof(endpoint.addr.v4);
+}
+
+/*
+ * Host Addresses
+ * This host's IPv4 and IPv6 interface addresses, as endpoints with port 0.
+ */
+static vector<PeerEndpoint> host_addresses() {
+    vector<PeerEndpoint> addresses;
+    struct ifaddrs* interfaces;
+    if (getifaddrs(&interfaces) == -1) {
+        return addresses;
+    }
+    for (struct ifaddrs* it = interfaces; it != NULL; it = it->ifa_next) {
+        if (it->ifa_addr == NULL) {
+            continue;
+        }
+        PeerEndpoint endpoint;
+        memset(&endpoint, 0, sizeof(endpoint));
+        if (it->ifa_addr->sa_family == AF_INET) {
+            memcpy(&endpoint.addr.v4, it->ifa_addr, sizeof(endpoint.addr.v4));
+        } else if (it->ifa_addr->sa_family == AF_INET6) {
+            memcpy(&endpoint.addr.v6, it->ifa_addr, sizeof(endpoint.addr.v6));
+        } else {
+            continue;
+        }
+        addresses.push_back(endpoint);
+    }
+    freeifaddrs(interfaces);
+    return addresses;
+}
+
+bool endpoint_is_local(const PeerEndpoint& endpoint) {
+    if (endpoint.addr.sa.sa_family == AF_INET) {
+        if ((ntohl(endpoint.addr.v4.sin_addr.s_addr) >> 24) == 127) {
+            return true;
+        }
+    } else if (endpoint.addr.sa.sa_family == AF_INET6) {
+        if (IN6_IS_ADDR_LOOPBACK(&endpoint.addr.v6.sin6_addr)) {
+            return true;
+        }
+    } else {
+        return false;
+    }
+
+    static const vector<PeerEndpoint> local = host_addresses();
+    for (const PeerEndpoint& address : local) {
+        if (address.addr.sa.sa_family != endpoint.addr.sa.sa_family) {
+            continue;
+        }
+        if (endpoint.addr.sa.sa_family == AF_INET
+                ? address.addr.v4.sin_addr.s_addr == endpoint.addr.v4.sin_addr.s_addr
+                : memcmp(&address.addr.v6.sin6_addr, &endpoint.addr.v6.sin6_addr, sizeof(struct in6_addr)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+/*
+ * P2P Micropayment System - Peer Endpoints
+ * Course: Computer Networks (Fall 2025)
+ *
+ * A peer's address in the form connect() takes, built once when the List
+ * reply is parsed (or when a hostname is resolved) and reused for every dial.
+ * It is a sockaddr_in / sockaddr_in6 union (28 bytes) rather than a full
+ * sockaddr_storage (128 bytes) so the directory's flat table stays compact.
+ */
+
+#ifndef ENDPOINT_H
+#define ENDPOINT_H
+
+#include <string>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+struct PeerEndpoint {
+    union {
+        struct sockaddr sa;        // sa.sa_family: AF_INET, AF_INET6, or AF_UNSPEC if unresolved
+        struct sockaddr_in v4;
+        struct sockaddr_in6 v6;
+    } addr;                        // Port in network byte order
+};
+
+// Parses a numeric IPv4 or IPv6 address (no DNS).
+// Returns: false if ip is neither; endpoint is then AF_UNSPEC with the port set
+bool pack_endpoint(const std::string& ip, int port, PeerEndpoint& endpoint);
+
+// Sets the port of an endpoint (host byte order)
+void set_endpoint_port(PeerEndpoint& endpoint, int port);
+
+// Returns: the port in host byte order
+int endpoint_port(const PeerEndpoint& endpoint);
+
+// Returns: the address as a string (inverse of pack_endpoint), "" if unresolved
+std::string endpoint_ip(const PeerEndpoint& endpoint);
+
+// Address and length to pass to connect()
+inline const struct sockaddr* endpoint_sockaddr(const PeerEndpoint& endpoint) { return &endpoint.addr.sa; }
+socklen_t endpoint_length(const PeerEndpoint& endpoint);
+
+inline bool endpoint_resolved(const PeerEndpoint& endpoint) { return endpoint.addr.sa.sa_family != AF_UNSPEC; }
+
+// Returns: true if the address is a loopback address or one of this host's
+// interface addresses (read once), i.e. the peer runs on this machine
+bool endpoint_is_local(const PeerEndpoint& endpoint);
+
+#endif
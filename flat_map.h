@@ -0,0 +1,153 @@
+/*
+ * P2P Micropayment System - Flat Hash Map
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Open-addressing hash table keyed by UserId, with linear probing over one
+ * contiguous array of slots. A lookup touches one or two cache lines instead
+ * of chasing the node pointers of std::map / std::unordered_map, and building
+ * the table makes a single allocation.
+ *
+ * Made for tables that are mostly rebuilt as a whole (like the directory
+ * after a List); erase() is for the occasional single change (a pushed
+ * join/leave event) and needs no tombstones. The load factor is kept at or
+ * below 1/2. NO_USER is reserved as the empty-slot marker. Not thread-safe.
+ */
+
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include <cstddef>
+#include <vector>
+
+#include "intern.h"
+
+template <class Value>
+class FlatHashMap {
+public:
+    struct Slot {
+        UserId key;   // NO_USER if the slot is empty
+        Value value;
+    };
+
+    FlatHashMap() : count(0), mask(0) {}
+
+    // Removes every entry; keeps the slot array for the next rebuild
+    void clear() {
+        for (Slot& slot : slots) {
+            slot.key = NO_USER;
+        }
+        count = 0;
+    }
+
+    // Makes room for n entries without rehashing
+    void reserve(size_t n) {
+        size_t wanted = 16;
+        while (wanted < n * 2) {
+            wanted *= 2;
+        }
+        if (wanted > slots.size()) {
+            rehash(wanted);
+        }
+    }
+
+    // Returns: the value for key, inserting a default-constructed one if absent
+    Value& operator[](UserId key) {
+        if ((count + 1) * 2 > slots.size()) {
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        }
+        size_t i = probe(key);
+        if (slots[i].key == NO_USER) {
+            slots[i].key = key;
+            slots[i].value = Value();
+            count++;
+        }
+        return slots[i].value;
+    }
+
+    // Returns: the value for key, or NULL if absent
+    const Value* find(UserId key) const {
+        if (count == 0) {
+            return NULL;
+        }
+        size_t i = probe(key);
+        return slots[i].key == NO_USER ? NULL : &slots[i].value;
+    }
+
+    // Removes key by shifting later entries of its probe run back, so
+    // lookups never have to step over deleted slots.
+    // Returns: false if key was absent
+    bool erase(UserId key) {
+        if (count == 0) {
+            return false;
+        }
+        size_t i = probe(key);
+        if (slots[i].key == NO_USER) {
+            return false;
+        }
+        for (size_t j = (i + 1) & mask; slots[j].key != NO_USER; j = (j + 1) & mask) {
+            // The entry in j may move into the hole at i unless its home lies
+            // cyclically in (i, j], where the hole does not interrupt its probe
+            size_t h = home(slots[j].key);
+            bool stays = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+            if (!stays) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i].key = NO_USER;
+        count--;
+        return true;
+    }
+
+    size_t size() const { return count; }
+
+    // Visits every entry as f(key, value), in slot order
+    template <class F>
+    void for_each(F f) const {
+        for (const Slot& slot : slots) {
+            if (slot.key != NO_USER) {
+                f(slot.key, slot.value);
+            }
+        }
+    }
+
+private:
+    // Multiplying by an odd constant is a bijection on the low bits, so dense
+    // UserIds never collide with each other below the table size
+    size_t home(UserId key) const {
+        return (size_t)((key * 2654435769u) & mask);
+    }
+
+    // Slot holding key, or the empty slot where it would go
+    size_t probe(UserId key) const {
+        size_t i = home(key);
+        while (slots[i].key != NO_USER && slots[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(capacity);
+        for (Slot& slot : slots) {
+            slot.key = NO_USER;
+        }
+        mask = capacity - 1;
+        count = 0;
+        for (const Slot& slot : old) {
+            if (slot.key != NO_USER) {
+                size_t i = probe(slot.key);
+                slots[i] = slot;
+                count++;
+            }
+        }
+    }
+
+    std::vector<Slot> slots;
+    size_t count;  // Entries in use
+    size_t mask;   // slots.size() - 1 (the size is a power of two)
+};
+
+#endif
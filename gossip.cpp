@@ -0,0 +1,350 @@
+/*
+ * P2P Micropayment System - Directory Gossip
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "gossip.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+bool is_gossip_message(const string& message) {
+    return message.compare(0, sizeof(GOSSIP_PREFIX) - 1, GOSSIP_PREFIX) == 0;
+}
+
+// Parses <user>#<ip>#<port>#<version>#<1|0>.
+// Returns: false if a field is missing
+static bool parse_gossip_entry(const string& text, GossipEntry& entry) {
+    size_t pos[4];
+    size_t start = 0;
+    for (int i = 0; i < 4; i++) {
+        pos[i] = text.find('#', start);
+        if (pos[i] == string::npos) {
+            return false;
+        }
+        start = pos[i] + 1;
+    }
+    entry.user.username = text.substr(0, pos[0]);
+    entry.user.ip = text.substr(pos[0] + 1, pos[1] - pos[0] - 1);
+    entry.user.port = atoi(text.c_str() + pos[1] + 1);
+    entry.version = strtoull(text.c_str() + pos[2] + 1, NULL, 10);
+    entry.online = text.compare(pos[3] + 1, string::npos, "1") == 0;
+    return !entry.user.username.empty() && !entry.user.ip.empty();
+}
+
+GossipTable::GossipTable() : online_count(0), cluster_hint(0), round(0), messages(0) {}
+
+// Returns: how many messages a change goes into
+size_t GossipTable::retransmits() const {
+    size_t n = max(online_count, cluster_hint);
+    return max((size_t)1, (size_t)ceil(GOSSIP_RETRANSMIT_MULT * log10((double)n + 1)));
+}
+
+void GossipTable::seed(const OnlineUser& user) {
+    if (index.count(user.username) > 0) {
+        return;
+    }
+    Slot slot;
+    slot.entry.user = user;
+    slot.entry.version = 0;
+    slot.entry.online = true;
+    slot.sends_left = 0;
+    slot.departed = 0;
+    index[user.username] = slots.size();
+    slots.push_back(slot);
+    online_count++;
+}
+
+bool GossipTable::update(const GossipEntry& entry) {
+    unordered_map<string, size_t>::iterator found = index.find(entry.user.username);
+    Slot* slot;
+    if (found == index.end()) {
+        // Unknown departures are kept too, to outvote older copies still going around
+        index[entry.user.username] = slots.size();
+        slots.push_back(Slot());
+        slot = &slots.back();
+        slot->sends_left = 0;
+        online_count += entry.online ? 1 : 0;
+    } else {
+        slot = &slots[found->second];
+        if (entry.version <= slot->entry.version) {
+            return false;
+        }
+        if (slot->entry.online != entry.online) {
+            online_count += entry.online ? 1 : -1;
+        }
+    }
+    slot->entry = entry;
+    slot->departed = entry.online ? 0 : round;
+    if (slot->sends_left == 0) {
+        rumors.push_back(entry.user.username);
+    }
+    slot->sends_left = (int)retransmits();
+    return true;
+}
+
+/*
+ * Build Message
+ * Changes go first, newest first, since an old change has already reached
+ * most of the users; settled entries only fill the room that is left.
+ */
+bool GossipTable::build_message(string& message, mt19937& random) {
+    messages++;
+    size_t start = message.size();
+    message += GOSSIP_PREFIX;
+    size_t header = message.size();
+
+    // Appends one entry unless the message would grow past GOSSIP_MAX_BYTES
+    auto append = [&](const GossipEntry& entry) {
+        string text = entry.user.username + "#" + entry.user.ip + "#" + to_string(entry.user.port) + "#" +
+                      to_string(entry.version) + (entry.online ? "#1" : "#0");
+        size_t separator = message.size() > header ? 1 : 0;
+        if (message.size() - start + separator + text.size() + 2 > GOSSIP_MAX_BYTES) {
+            return false;
+        }
+        if (separator > 0) {
+            message += '|';
+        }
+        message += text;
+        return true;
+    };
+
+    bool spread = false;
+    for (size_t i = rumors.size(); i-- > 0;) {
+        Slot& slot = slots[index[rumors[i]]];
+        if (!append(slot.entry)) {
+            break;
+        }
+        slot.sends_left--;
+        spread = true;
+    }
+    if (spread) {
+        rumors.erase(remove_if(rumors.begin(), rumors.end(),
+                               [this](const string& name) { return slots[index[name]].sends_left == 0; }),
+                     rumors.end());
+    }
+
+    // Anti-entropy: a few random settled entries, which repairs users that
+    // missed a change because a message was lost
+    if (messages % GOSSIP_SYNC_ROUNDS == 0 && !slots.empty()) {
+        uniform_int_distribution<size_t> pick(0, slots.size() - 1);
+        for (size_t tries = min(slots.size(), (size_t)64); tries > 0; tries--) {
+            const Slot& slot = slots[pick(random)];
+            if (slot.sends_left == 0 && slot.entry.version > 0 && !append(slot.entry)) {
+                break;
+            }
+        }
+    }
+
+    if (message.size() == header) {
+        message.resize(start);
+        return false;
+    }
+    message += CRLF;
+    return true;
+}
+
+bool GossipTable::merge_message(const string& message, vector<GossipEntry>& changed, size_t max_new,
+                                size_t* skipped) {
+    if (!is_gossip_message(message)) {
+        return false;
+    }
+    size_t end = message.find_first_of(CRLF);
+    if (end == string::npos) {
+        end = message.size();
+    }
+    bool well_formed = true;
+    size_t start = sizeof(GOSSIP_PREFIX) - 1;
+    while (start < end) {
+        size_t next = message.find('|', start);
+        if (next == string::npos || next > end) {
+            next = end;
+        }
+        GossipEntry entry;
+        if (!parse_gossip_entry(message.substr(start, next - start), entry)) {
+            well_formed = false;
+        } else if (index.count(entry.user.username) > 0 || max_new > 0) {
+            if (index.count(entry.user.username) == 0) {
+                max_new--;
+            }
+            if (update(entry)) {
+                changed.push_back(entry);
+            }
+        } else if (skipped != NULL) {
+            (*skipped)++;
+        }
+        start = next + 1;
+    }
+    return well_formed;
+}
+
+void GossipTable::random_peers(size_t count, const string& self, mt19937& random, vector<string>& peers) const {
+    peers.clear();
+    if (slots.empty()) {
+        return;
+    }
+    uniform_int_distribution<size_t> pick(0, slots.size() - 1);
+    // Random probes rather than a shuffle: the table may be large and count is small
+    for (size_t tries = count * 4; tries > 0 && peers.size() < count; tries--) {
+        const GossipEntry& entry = slots[pick(random)].entry;
+        if (entry.online && entry.user.username != self &&
+            std::find(peers.begin(), peers.end(), entry.user.username) == peers.end()) {
+            peers.push_back(entry.user.username);
+        }
+    }
+}
+
+void GossipTable::tick() {
+    round++;
+    for (size_t i = 0; i < slots.size();) {
+        const Slot& slot = slots[i];
+        if (slot.entry.online || slot.sends_left > 0 || round - slot.departed <= GOSSIP_TOMBSTONE_ROUNDS) {
+            i++;
+            continue;
+        }
+        // Swap with the last slot to keep the array dense
+        index.erase(slot.entry.user.username);
+        if (i + 1 < slots.size()) {
+            slots[i] = slots.back();
+            index[slots[i].entry.user.username] = i;
+        }
+        slots.pop_back();
+    }
+}
+
+bool GossipTable::find(const string& username, GossipEntry& entry) const {
+    unordered_map<string, size_t>::const_iterator found = index.find(username);
+    if (found == index.end()) {
+        return false;
+    }
+    entry = slots[found->second].entry;
+    return true;
+}
+
+GossipAgent::GossipAgent()
+    : random(random_device()()), self_version(0), interval_ms(GOSSIP_INTERVAL_MS), fanout(GOSSIP_FANOUT),
+      active(false), round_count(0), sent_count(0), received_count(0), sent_bytes(0), skipped_count(0),
+      override_count(0) {}
+
+GossipAgent::~GossipAgent() {
+    stop();
+}
+
+void GossipAgent::start(const OnlineUser& user, uint64_t version, const vector<OnlineUser>& bootstrap,
+                        int interval, int peers, SendCallback send_callback, ChangeCallback change_callback) {
+    {
+        lock_guard<mutex> lock(table_mutex);
+        for (const OnlineUser& listed : bootstrap) {
+            table.seed(listed);
+        }
+        self = user;
+        self_version = version;
+        GossipEntry entry = { user, version, true };
+        table.update(entry);
+    }
+    interval_ms = interval;
+    fanout = peers;
+    send = send_callback;
+    on_change = change_callback;
+    active = true;
+    worker = thread(&GossipAgent::run, this);
+}
+
+/*
+ * Stop
+ * Our departure is a change like any other, but we only get to send it
+ * once, so it goes on to further peers until fanout of them took it.
+ */
+bool GossipAgent::stop() {
+    if (!active.exchange(false)) {
+        return false;
+    }
+    { lock_guard<mutex> lock(wait_mutex); }
+    wait_cv.notify_all();
+    worker.join();
+
+    string message;
+    vector<string> peers;
+    {
+        lock_guard<mutex> lock(table_mutex);
+        GossipEntry entry = { self, self_version + 1, false };
+        table.update(entry);
+        table.build_message(message, random);
+        table.random_peers(fanout * GOSSIP_FAREWELL_TRIES, self.username, random, peers);
+    }
+    int delivered = 0;
+    for (size_t i = 0; i < peers.size() && delivered < fanout; i++) {
+        if (send(peers[i], message)) {
+            delivered++;
+            sent_count++;
+            sent_bytes += message.size();
+        }
+    }
+    return true;
+}
+
+void GossipAgent::handle_message(const string& message) {
+    if (!active) {
+        return;
+    }
+    received_count++;
+    vector<GossipEntry> changed;
+    {
+        lock_guard<mutex> lock(table_mutex);
+        size_t skipped = 0;
+        table.merge_message(message, changed, GOSSIP_MAX_NEW_USERS, &skipped);
+        skipped_count += skipped;
+        for (const GossipEntry& entry : changed) {
+            if (entry.user.username == self.username) {
+                // Only we speak for our entry: outvote the remote one and spread ours again
+                self_version = max(self_version, entry.version) + 1;
+                GossipEntry own = { self, self_version, true };
+                table.update(own);
+                override_count++;
+            }
+        }
+    }
+    for (const GossipEntry& entry : changed) {
+        if (entry.user.username != self.username) {
+            on_change(entry);
+        }
+    }
+}
+
+void GossipAgent::run() {
+    unique_lock<mutex> lock(wait_mutex);
+    while (active) {
+        wait_cv.wait_for(lock, chrono::milliseconds(interval_ms), [this] { return !active; });
+        if (!active) {
+            return;
+        }
+        lock.unlock();
+        gossip_round();
+        lock.lock();
+    }
+}
+
+// One round: build a message, pick the peers, then deliver outside the lock
+void GossipAgent::gossip_round() {
+    string message;
+    vector<string> peers;
+    {
+        lock_guard<mutex> lock(table_mutex);
+        bool news = table.build_message(message, random);
+        if (news) {
+            table.random_peers(fanout, self.username, random, peers);
+        }
+        table.tick();
+    }
+    round_count++;
+    for (const string& peer : peers) {
+        if (send(peer, message)) {
+            sent_count++;
+            sent_bytes += message.size();
+        }
+    }
+}
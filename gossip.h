@@ -0,0 +1,203 @@
+/*
+ * P2P Micropayment System - Directory Gossip
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Without gossip every client learns about other users only from the
+ * server's List reply, which grows with the number of users and is asked
+ * for again and again. With gossip the login reply is the only full list a
+ * client needs: afterwards the clients tell each other about users joining
+ * and leaving, over the P2P port they already listen on.
+ *
+ * Every user owns a versioned entry (username#ip#port#version#state). The
+ * version is the user's login time in milliseconds, one higher when they
+ * log out (state 0), so a newer entry always wins; entries from the server's
+ * List reply have version 0 and lose to anything gossiped. One message is
+ * one line:
+ *
+ *   GOSSIP|<user>#<ip>#<port>#<version>#<1|0>|<user>#...\r\n
+ *
+ * Every round a client sends one message to GOSSIP_FANOUT random online
+ * users. A message carries the changes the client is still spreading
+ * (each one GOSSIP_RETRANSMIT_MULT * log10(n + 1) times, rounded up, newest
+ * first) and, every GOSSIP_SYNC_ROUNDS rounds, random settled entries that
+ * repair what a lost message missed, never more than GOSSIP_MAX_BYTES. A
+ * change reaches everybody in O(log n) rounds while each client sends at
+ * most fanout messages of bounded size per round, whatever the number of
+ * users. Departed users are remembered for GOSSIP_TOMBSTONE_ROUNDS rounds
+ * so that late copies of their old entry cannot bring them back.
+ *
+ * Gossip needs no failure detector: a client that crashes without Exit
+ * stays listed until it logs in again (or a List brings the server's view).
+ *
+ * Messages are only as trustworthy as the peers that send them, so a client
+ * gossips only with the network key (see PaymentClient::enable_gossip()).
+ * Even then a received entry for ourselves is never taken: we answer it by
+ * announcing our own entry again with a higher version. A message adds at
+ * most GOSSIP_MAX_NEW_USERS users the client did not know, since each one
+ * costs a directory entry (and a hostname lookup); anti-entropy brings the
+ * rest in later rounds.
+ */
+
+#ifndef GOSSIP_H
+#define GOSSIP_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <stdint.h>
+
+#include "protocol.h"
+
+#define GOSSIP_PREFIX "GOSSIP|"
+#define GOSSIP_INTERVAL_MS 1000        // Default time between rounds
+#define GOSSIP_FANOUT 3                // Default peers per round
+#define GOSSIP_MAX_BYTES 1400          // Longest message (fits a datagram and a listener recv)
+#define GOSSIP_RETRANSMIT_MULT 4       // Sends of a change = MULT * log10(n + 1), rounded up
+#define GOSSIP_SYNC_ROUNDS 10          // Rounds between messages carrying random settled entries
+#define GOSSIP_TOMBSTONE_ROUNDS 60     // Rounds a departed user's entry is kept
+#define GOSSIP_FAREWELL_TRIES 4        // Peers tried per fanout slot for the departure message
+#define GOSSIP_CONNECT_TIMEOUT_MS 500  // connect() timeout when delivering a message
+#define GOSSIP_MAX_NEW_USERS 16        // Unknown users one received message may add
+
+// One user as gossiped
+struct GossipEntry {
+    OnlineUser user;
+    uint64_t version;  // Owner's login time in ms (+1 after logout); 0 = from the server
+    bool online;
+};
+
+// Returns: true if message is a gossip message (with or without CRLF)
+bool is_gossip_message(const std::string& message);
+
+/*
+ * Gossip Table
+ * One client's view of the directory plus the bookkeeping of which changes
+ * it is still spreading. Everything but the peer transport, so the same code
+ * runs in the client and in the simulation (gossipsim). Not thread-safe.
+ */
+class GossipTable {
+public:
+    GossipTable();
+
+    // Seeds an entry from the server's List reply; never spread
+    void seed(const OnlineUser& user);
+
+    // Applies entry if it is newer than the known one and spreads it.
+    // Returns: true if the table changed
+    bool update(const GossipEntry& entry);
+
+    // Builds the next message to send, appending to message.
+    // Returns: false if there is nothing to say this round
+    bool build_message(std::string& message, std::mt19937& random);
+
+    // Applies every entry of a received message; changed receives the
+    // entries that were news (appended). Entries for users not in the table
+    // beyond the first max_new are skipped and counted in skipped.
+    // Returns: false if the message is malformed
+    bool merge_message(const std::string& message, std::vector<GossipEntry>& changed,
+                       size_t max_new = (size_t)-1, size_t* skipped = NULL);
+
+    // Picks up to count distinct random online users other than self
+    void random_peers(size_t count, const std::string& self, std::mt19937& random,
+                      std::vector<std::string>& peers) const;
+
+    // Ends a round: forgets tombstones older than GOSSIP_TOMBSTONE_ROUNDS
+    void tick();
+
+    // Sizes the spreading of changes for n users when the table itself holds
+    // fewer (the simulation keeps only the changes, not the whole directory)
+    void set_cluster_hint(size_t n) { cluster_hint = n; }
+
+    // Returns: true and fills entry if username is known (online or not)
+    bool find(const std::string& username, GossipEntry& entry) const;
+
+    size_t size() const { return slots.size(); }
+    size_t online() const { return online_count; }
+    size_t spreading() const { return rumors.size(); }
+
+private:
+    struct Slot {
+        GossipEntry entry;
+        int sends_left;              // Messages it still goes into as a change
+        unsigned long departed;      // Round it went offline (tombstones only)
+    };
+
+    size_t retransmits() const;
+
+    std::vector<Slot> slots;                         // Dense, for picking random entries
+    std::unordered_map<std::string, size_t> index;   // Username -> slot
+    std::vector<std::string> rumors;                 // Usernames with sends_left > 0, oldest first
+    size_t online_count;
+    size_t cluster_hint;
+    unsigned long round;
+    unsigned long messages;                          // build_message() calls so far
+};
+
+/*
+ * Gossip Agent
+ * Runs the rounds of one client on a background thread. Messages are
+ * delivered by the owner's send callback (PaymentClient dials the peer's
+ * P2P port), received ones are passed in with handle_message(), and every
+ * change to the directory is reported through on_change.
+ */
+class GossipAgent {
+public:
+    // Delivers message to username's P2P port. Returns: false if it could not be sent
+    typedef std::function<bool(const std::string& username, const std::string& message)> SendCallback;
+    // An entry that was news: a user joined, moved or left
+    typedef std::function<void(const GossipEntry& entry)> ChangeCallback;
+
+    GossipAgent();
+    ~GossipAgent();
+
+    // Seeds the table with the login reply's users and starts spreading our own entry
+    void start(const OnlineUser& self, uint64_t version, const std::vector<OnlineUser>& bootstrap,
+               int interval_ms, int fanout, SendCallback send, ChangeCallback on_change);
+    // Joins the thread, then sends our departure until fanout peers took it.
+    // Returns: false if it was not running
+    bool stop();
+    bool running() const { return active; }
+
+    // Merges a message received on the P2P port (any thread)
+    void handle_message(const std::string& message);
+
+    unsigned long rounds() const { return round_count; }
+    unsigned long messages_sent() const { return sent_count; }
+    unsigned long messages_received() const { return received_count; }
+    unsigned long bytes_sent() const { return sent_bytes; }
+    unsigned long users_skipped() const { return skipped_count; }   // Past GOSSIP_MAX_NEW_USERS
+    unsigned long self_overrides() const { return override_count; } // Entries for us we answered
+
+private:
+    void run();
+    void gossip_round();
+
+    GossipTable table;
+    std::mutex table_mutex;          // Protects table, random and self
+    std::mt19937 random;
+    OnlineUser self;
+    uint64_t self_version;
+    int interval_ms;
+    int fanout;
+    SendCallback send;
+    ChangeCallback on_change;
+    std::atomic<bool> active;
+    std::mutex wait_mutex;
+    std::condition_variable wait_cv;  // Cuts the sleep between rounds short on stop()
+    std::thread worker;
+
+    std::atomic<unsigned long> round_count;
+    std::atomic<unsigned long> sent_count;
+    std::atomic<unsigned long> received_count;
+    std::atomic<unsigned long> sent_bytes;
+    std::atomic<unsigned long> skipped_count;
+    std::atomic<unsigned long> override_count;
+};
+
+#endif
@@ -0,0 +1,303 @@
+/*
+ * P2P Micropayment System - Gossip Simulation
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Runs the directory gossip of gossip.h (the same GossipTable code the
+ * client uses, same message format) for thousands of simulated clients in
+ * one process, in synchronous rounds of GOSSIP_INTERVAL_MS simulated time.
+ *
+ * --nodes clients are online and agree on the directory. In round 0,
+ * --leaves of them log out and --joins new ones log in; each newcomer
+ * bootstraps from one server List reply. The simulation then counts the
+ * rounds until every online client has the right view of every change
+ * (the time by which half of the views and 99% of them were right is also
+ * shown), with --loss of the messages dropped at random. The run ends
+ * after at most GOSSIP_TOMBSTONE_ROUNDS rounds.
+ *
+ * To fit 10k clients in memory, a table holds only the changes; the
+ * directory all of them agreed on before round 0 is implied, and gossip
+ * partners are drawn from the online clients directly (what
+ * GossipTable::random_peers() does with a full table).
+ *
+ * For the server, the run is compared with clients that poll List every
+ * --poll-interval seconds instead: List replies, and bytes, the server
+ * sends while the change spreads.
+ *
+ * Usage: ./gossipsim [--nodes N] [--joins J] [--leaves L] [--fanout F] [--loss P]
+ *                    [--poll-interval S] [--seed S] [--max-rounds R]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include "gossip.h"
+
+using namespace std;
+
+// Simulation parameters
+int num_nodes = 10000;
+int num_joins = 50;
+int num_leaves = 50;
+int fanout = GOSSIP_FANOUT;
+double loss = 0.0;
+double poll_interval = 10.0;   // Seconds between List requests of a polling client
+unsigned int seed = 1;
+int max_rounds = GOSSIP_TOMBSTONE_ROUNDS;
+
+// One simulated client
+struct Node {
+    OnlineUser user;
+    GossipTable table;
+    bool online;
+    bool joined;   // Logged in during the run (bootstrapped from the server)
+};
+
+// A message on its way, delivered at the end of the round
+struct InFlight {
+    int to;
+    int message;   // Index into the round's messages
+};
+
+OnlineUser make_user(int i) {
+    OnlineUser user;
+    user.username = "user" + to_string(i);
+    user.ip = "10." + to_string(i / 65536 % 256) + "." + to_string(i / 256 % 256) + "." + to_string(i % 256);
+    user.port = 9000 + i % 1000;
+    return user;
+}
+
+// Returns: bytes of a List reply listing users (what the server sends per List)
+size_t list_reply_bytes(const vector<Node>& nodes) {
+    size_t bytes = string("10000\r\nSERVER_PUBLIC_KEY\r\n").size() + to_string(nodes.size()).size() + 2;
+    for (const Node& node : nodes) {
+        if (node.online) {
+            bytes += node.user.username.size() + node.user.ip.size() + to_string(node.user.port).size() + 4;
+        }
+    }
+    return bytes;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--nodes") {
+            num_nodes = atoi(argv[i + 1]);
+        } else if (arg == "--joins") {
+            num_joins = atoi(argv[i + 1]);
+        } else if (arg == "--leaves") {
+            num_leaves = atoi(argv[i + 1]);
+        } else if (arg == "--fanout") {
+            fanout = atoi(argv[i + 1]);
+        } else if (arg == "--loss") {
+            loss = atof(argv[i + 1]);
+        } else if (arg == "--poll-interval") {
+            poll_interval = atof(argv[i + 1]);
+        } else if (arg == "--seed") {
+            seed = (unsigned int)strtoul(argv[i + 1], NULL, 10);
+        } else if (arg == "--max-rounds") {
+            max_rounds = atoi(argv[i + 1]);
+        } else {
+            cout << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+    if (num_nodes < 2 || num_joins < 0 || num_leaves < 0 || num_leaves >= num_nodes || fanout < 1 ||
+        poll_interval <= 0 || max_rounds < 1) {
+        cout << "Usage: " << argv[0] << " [--nodes N] [--joins J] [--leaves L] [--fanout F] [--loss P]"
+             << " [--poll-interval S] [--seed S] [--max-rounds R]" << endl;
+        return 1;
+    }
+    // Past that the departed users are forgotten again, and a client that
+    // never heard of them can no longer be told from one that did
+    max_rounds = min(max_rounds, GOSSIP_TOMBSTONE_ROUNDS);
+    chrono::steady_clock::time_point started = chrono::steady_clock::now();
+    mt19937 random(seed);
+
+    vector<Node> nodes(num_nodes + num_joins);
+    for (int i = 0; i < (int)nodes.size(); i++) {
+        nodes[i].user = make_user(i);
+        nodes[i].online = i < num_nodes;
+        nodes[i].joined = i >= num_nodes;
+        nodes[i].table.set_cluster_hint(num_nodes);
+    }
+
+    // Round 0: departures, then arrivals bootstrapping from the server
+    vector<int> left;
+    vector<int> everyone(num_nodes);
+    for (int i = 0; i < num_nodes; i++) {
+        everyone[i] = i;
+    }
+    shuffle(everyone.begin(), everyone.end(), random);
+    left.assign(everyone.begin(), everyone.begin() + num_leaves);
+    const uint64_t version = 1000;  // Login time of the clients that were there before
+    for (int i : left) {
+        GossipEntry entry = { nodes[i].user, version + 1, false };
+        nodes[i].table.update(entry);
+    }
+    unsigned long bootstrap_replies = 0;
+    size_t bootstrap_bytes = 0;
+    for (int i = num_nodes; i < (int)nodes.size(); i++) {
+        for (int j : left) {
+            nodes[j].online = false;
+        }
+        nodes[i].online = true;
+        // The server's List: the earlier newcomers are in it, the users that left are not
+        for (int j = num_nodes; j < i; j++) {
+            nodes[i].table.seed(nodes[j].user);
+        }
+        GossipEntry entry = { nodes[i].user, version + 2, true };
+        nodes[i].table.update(entry);
+        bootstrap_replies++;
+        bootstrap_bytes += list_reply_bytes(nodes);
+    }
+
+    // A client's view of one change is right if it knows the new state; a
+    // newcomer never saw the departed users, which is right as well
+    auto view_correct = [&](const Node& node, int changed) {
+        GossipEntry entry;
+        if (!node.table.find(nodes[changed].user.username, entry)) {
+            return !nodes[changed].online && node.joined;
+        }
+        return entry.online == nodes[changed].online;
+    };
+    vector<int> changes(left);
+    for (int i = num_nodes; i < (int)nodes.size(); i++) {
+        changes.push_back(i);
+    }
+
+    vector<int> online;
+    for (int i = 0; i < (int)nodes.size(); i++) {
+        if (nodes[i].online) {
+            online.push_back(i);
+        }
+    }
+    // The departed clients still send their farewell in round 0
+    vector<int> senders(online);
+    senders.insert(senders.end(), left.begin(), left.end());
+
+    // Views only ever become right (versions grow), so a client whose views
+    // are all right is not checked again
+    vector<int> pending(online);
+    unsigned long long views = (unsigned long long)online.size() * changes.size();
+    unsigned long long settled = 0;   // Right views of the clients no longer checked
+    int half_round = -1, most_round = -1, converged_round = -1;
+    unsigned long long messages_sent = 0, messages_lost = 0, bytes_sent = 0;
+    size_t largest_message = 0;
+    vector<string> messages;
+    vector<InFlight> in_flight;
+    vector<GossipEntry> changed;
+    uniform_int_distribution<size_t> pick_peer(0, online.size() - 1);
+    bernoulli_distribution lost(loss);
+
+    cout << "Simulating " << num_nodes << " clients, " << num_joins << " joining and " << num_leaves
+         << " leaving, fanout " << fanout << ", " << loss * 100 << "% loss" << endl;
+    cout << setw(7) << "Round" << setw(14) << "Views right" << setw(12) << "Messages" << setw(14) << "Bytes"
+         << endl;
+
+    int round;
+    for (round = 0; round < max_rounds && converged_round < 0; round++) {
+        messages.clear();
+        in_flight.clear();
+        for (int i : (round == 0 ? senders : online)) {
+            Node& node = nodes[i];
+            string message;
+            bool news = node.table.build_message(message, random);
+            node.table.tick();
+            if (!news) {
+                continue;
+            }
+            largest_message = max(largest_message, message.size());
+            // A departing client sees its sends fail and tries further peers (GossipAgent::stop())
+            int tries = nodes[i].online ? fanout : fanout * GOSSIP_FAREWELL_TRIES;
+            for (int sent = 0, delivered = 0; sent < tries && delivered < fanout; sent++) {
+                int to = online[pick_peer(random)];
+                if (to == i) {
+                    continue;
+                }
+                messages_sent++;
+                bytes_sent += message.size();
+                if (lost(random)) {
+                    messages_lost++;
+                    continue;
+                }
+                delivered += nodes[i].online ? 0 : 1;
+                InFlight delivery = { to, (int)messages.size() };
+                in_flight.push_back(delivery);
+            }
+            messages.push_back(message);
+        }
+        for (const InFlight& delivery : in_flight) {
+            changed.clear();
+            nodes[delivery.to].table.merge_message(messages[delivery.message], changed);
+        }
+
+        unsigned long long right = settled;
+        for (size_t p = 0; p < pending.size();) {
+            unsigned long long node_right = 0;
+            for (int c : changes) {
+                node_right += view_correct(nodes[pending[p]], c) ? 1 : 0;
+            }
+            right += node_right;
+            if (node_right < changes.size()) {
+                p++;
+                continue;
+            }
+            settled += node_right;
+            pending[p] = pending.back();
+            pending.pop_back();
+        }
+        if (half_round < 0 && right * 2 >= views) {
+            half_round = round + 1;
+        }
+        if (most_round < 0 && right * 100 >= views * 99) {
+            most_round = round + 1;
+        }
+        if (right == views) {
+            converged_round = round + 1;
+        }
+        cout << setw(7) << round + 1 << setw(13) << fixed << setprecision(2) << 100.0 * right / views << "%"
+             << setw(12) << messages_sent << setw(14) << bytes_sent << endl;
+    }
+
+    double interval_s = GOSSIP_INTERVAL_MS / 1000.0;
+    cout << endl;
+    if (converged_round < 0) {
+        cout << "Did not converge within " << max_rounds << " rounds" << endl;
+    } else {
+        cout << "Converged in " << converged_round << " rounds (" << converged_round * interval_s << " s); 50% after "
+             << half_round << ", 99% after " << most_round << endl;
+    }
+    size_t backlog = 0;
+    for (int i : online) {
+        backlog = max(backlog, nodes[i].table.spreading());
+    }
+    cout << "Gossip: " << messages_sent << " messages (" << messages_lost << " lost), " << bytes_sent
+         << " bytes, largest " << largest_message << " bytes; " << fixed << setprecision(1)
+         << (double)bytes_sent / online.size() / round << " bytes per client per round; up to " << backlog
+         << " changes still being repeated" << endl;
+
+    // The same period with every client polling List instead
+    double seconds = round * interval_s;
+    size_t reply_bytes = list_reply_bytes(nodes);
+    double poll_replies = online.size() / poll_interval * seconds;
+    cout << "Server, gossip: " << bootstrap_replies << " List replies (" << bootstrap_bytes
+         << " bytes) for the newcomers' bootstrap" << endl;
+    cout << "Server, polling every " << poll_interval << " s: " << (unsigned long long)poll_replies
+         << " List replies (" << (unsigned long long)(poll_replies * reply_bytes) << " bytes of " << reply_bytes
+         << " each) in the same " << seconds << " s, and a change takes " << poll_interval / 2
+         << " s on average to be seen" << endl;
+    if (bootstrap_bytes > 0 && poll_replies > 0) {
+        cout << "Server load with gossip: " << setprecision(2) << 100.0 * bootstrap_bytes / (poll_replies * reply_bytes)
+             << "% of polling" << endl;
+    }
+    cout << "Simulated in "
+         << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started).count() << " ms"
+         << endl;
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * P2P Micropayment System - Hex Encoding
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "hex.h"
+
+using namespace std;
+
+void append_hex(string& out, const unsigned char* data, size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < length; i++) {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 0x0F];
+    }
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool decode_hex(const char* text, size_t length, unsigned char* out) {
+    if (length % 2 != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i += 2) {
+        int high = hex_value(text[i]);
+        int low = hex_value(text[i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out[i / 2] = (unsigned char)(high << 4 | low);
+    }
+    return true;
+}
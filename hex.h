@@ -0,0 +1,22 @@
+/*
+ * P2P Micropayment System - Hex Encoding
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Binary fields (salts, ciphertexts, signatures) travel as lowercase hex so
+ * frames stay printable ASCII lines.
+ */
+
+#ifndef HEX_H
+#define HEX_H
+
+#include <string>
+#include <cstddef>
+
+// Appends 2 * length lowercase hex digits
+void append_hex(std::string& out, const unsigned char* data, size_t length);
+
+// Decodes length hex digits (either case) into length / 2 bytes.
+// Returns: false if length is odd or text is not valid hex
+bool decode_hex(const char* text, size_t length, unsigned char* out);
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ * P2P Micropayment System - Duplicate Transfer Detection
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "idempotency.h"
+#include "hex.h"
+
+#include <atomic>
+#include <chrono>
+#include <random>
+
+using namespace std;
+
+// Finalizer of SplitMix64: a bijection with good avalanche
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t random_seed() {
+    random_device device;
+    return ((uint64_t)device() << 32) ^ device();
+}
+
+// Seconds on the wall clock, which peers share (unlike the monotonic one)
+static uint32_t unix_seconds() {
+    return (uint32_t)chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+string new_transfer_id() {
+    // Mixing a per-process random start with a counter never repeats within
+    // the process (mix64 is a bijection) and looks random from outside
+    static const uint64_t base = random_seed();
+    static atomic<uint64_t> counter(0);
+    uint64_t id = mix64(base + counter.fetch_add(1));
+    uint32_t sent = unix_seconds();
+    unsigned char bytes[12];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (unsigned char)(sent >> (24 - 8 * i));
+    }
+    for (int i = 0; i < 8; i++) {
+        bytes[4 + i] = (unsigned char)(id >> (56 - 8 * i));
+    }
+    string text;
+    append_hex(text, bytes, sizeof(bytes));
+    return text;
+}
+
+bool transfer_id_time(const string& transfer_id, uint32_t& seconds) {
+    unsigned char bytes[4];
+    if (transfer_id.size() != 24 || !decode_hex(transfer_id.data(), 8, bytes)) {
+        return false;
+    }
+    seconds = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+    return true;
+}
+
+// Seconds on a monotonic clock
+static uint32_t now_seconds() {
+    return (uint32_t)chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+IdempotencyFilter::IdempotencyFilter(size_t capacity, int window) : seed(random_seed()), expired_count(0) {
+    reset(capacity, window);
+}
+
+void IdempotencyFilter::reset(size_t capacity, int window) {
+    stripe_capacity = 1;
+    while (stripe_capacity * IDEMPOTENCY_STRIPES < capacity) {
+        stripe_capacity *= 2;
+    }
+    window_seconds = window;
+    expired_count = 0;
+    for (Stripe& stripe : stripes) {
+        // Allocated on first use, so an idle filter costs nothing
+        vector<uint64_t>().swap(stripe.slots);
+        vector<uint64_t>().swap(stripe.ring);
+        vector<uint32_t>().swap(stripe.times);
+        stripe.head = 0;
+        stripe.count = 0;
+        stripe.duplicates = 0;
+        stripe.evicted_early = 0;
+    }
+}
+
+uint64_t IdempotencyFilter::fingerprint(const string& sender, const string& transfer_id) const {
+    // FNV-1a over sender '#' transfer_id, keyed by the seed and finalized
+    uint64_t hash = 14695981039346656037ULL ^ seed;
+    for (char c : sender) {
+        hash = (hash ^ (unsigned char)c) * 1099511628211ULL;
+    }
+    hash = (hash ^ '#') * 1099511628211ULL;
+    for (char c : transfer_id) {
+        hash = (hash ^ (unsigned char)c) * 1099511628211ULL;
+    }
+    hash = mix64(hash);
+    return hash == 0 ? 1 : hash;  // 0 marks an empty slot
+}
+
+// Slot holding fp, or the empty slot where it would go
+size_t IdempotencyFilter::find_slot(const Stripe& stripe, uint64_t fp) {
+    size_t mask = stripe.slots.size() - 1;
+    size_t i = (size_t)fp & mask;
+    while (stripe.slots[i] != 0 && stripe.slots[i] != fp) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/*
+ * Erase
+ * Removes fp from the set with backward-shift deletion: later entries of the
+ * same probe run move up, so lookups never need tombstones.
+ */
+void IdempotencyFilter::erase(Stripe& stripe, uint64_t fp) {
+    size_t mask = stripe.slots.size() - 1;
+    size_t hole = find_slot(stripe, fp);
+    if (stripe.slots[hole] == 0) {
+        return;
+    }
+    size_t i = hole;
+    while (true) {
+        i = (i + 1) & mask;
+        uint64_t entry = stripe.slots[i];
+        if (entry == 0) {
+            break;
+        }
+        // entry may fill the hole unless its home lies cyclically in (hole, i]
+        size_t home = (size_t)entry & mask;
+        bool stays = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (!stays) {
+            stripe.slots[hole] = entry;
+            hole = i;
+        }
+    }
+    stripe.slots[hole] = 0;
+}
+
+void IdempotencyFilter::forget_oldest(Stripe& stripe) {
+    erase(stripe, stripe.ring[stripe.head]);
+    stripe.head = (stripe.head + 1) & (stripe_capacity - 1);
+    stripe.count--;
+}
+
+bool IdempotencyFilter::insert(const string& sender, const string& transfer_id) {
+    uint64_t fp = fingerprint(sender, transfer_id);
+    Stripe& stripe = stripes[fp >> 60];  // Top 4 bits pick one of 16 stripes
+    uint32_t now = now_seconds();
+
+    lock_guard<mutex> lock(stripe.stripe_mutex);
+    if (stripe.ring.empty()) {
+        stripe.slots.assign(stripe_capacity * 2, 0);
+        stripe.ring.resize(stripe_capacity);
+        stripe.times.resize(stripe_capacity);
+    }
+
+    // Forget what has aged out of the window
+    while (stripe.count > 0 && now - stripe.times[stripe.head] >= (uint32_t)window_seconds) {
+        forget_oldest(stripe);
+    }
+
+    size_t slot = find_slot(stripe, fp);
+    if (stripe.slots[slot] == fp) {
+        stripe.duplicates++;
+        return false;
+    }
+
+    if (stripe.count == stripe_capacity) {
+        forget_oldest(stripe);
+        stripe.evicted_early++;
+        slot = find_slot(stripe, fp);  // The deletion may have shifted entries
+    }
+    stripe.slots[slot] = fp;
+    size_t tail = (stripe.head + stripe.count) & (stripe_capacity - 1);
+    stripe.ring[tail] = fp;
+    stripe.times[tail] = now;
+    stripe.count++;
+    return true;
+}
+
+bool IdempotencyFilter::fresh(const string& transfer_id) const {
+    uint32_t sent;
+    if (transfer_id_time(transfer_id, sent)) {
+        long long age = (long long)unix_seconds() - sent;
+        long long skew = window_seconds / 4;
+        if (age >= -skew && age < window_seconds - skew) {
+            return true;
+        }
+    }
+    expired_count++;
+    return false;
+}
+
+size_t IdempotencyFilter::size() const {
+    size_t total = 0;
+    for (const Stripe& stripe : stripes) {
+        lock_guard<mutex> lock(stripe.stripe_mutex);
+        total += stripe.count;
+    }
+    return total;
+}
+
+size_t IdempotencyFilter::bytes() const {
+    size_t total = 0;
+    for (const Stripe& stripe : stripes) {
+        lock_guard<mutex> lock(stripe.stripe_mutex);
+        total += stripe.slots.size() * sizeof(uint64_t) + stripe.ring.size() * sizeof(uint64_t) +
+                 stripe.times.size() * sizeof(uint32_t);
+    }
+    return total;
+}
+
+unsigned long IdempotencyFilter::duplicates() const {
+    unsigned long total = 0;
+    for (const Stripe& stripe : stripes) {
+        lock_guard<mutex> lock(stripe.stripe_mutex);
+        total += stripe.duplicates;
+    }
+    return total;
+}
+
+unsigned long IdempotencyFilter::evicted_early() const {
+    unsigned long total = 0;
+    for (const Stripe& stripe : stripes) {
+        lock_guard<mutex> lock(stripe.stripe_mutex);
+        total += stripe.evicted_early;
+    }
+    return total;
+}
@@ -0,0 +1,107 @@
+/*
+ * P2P Micropayment System - Duplicate Transfer Detection
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Every transfer frame carries an ID chosen by the sender
+ * (sender#amount#recipient#<id>), and a sender that retries resends the
+ * same ID. The receiver remembers the (sender, ID) pairs it credited
+ * recently in an IdempotencyFilter and drops repeats, so a retry after a
+ * timeout, or a replayed frame, is credited and reported only once.
+ *
+ * The ID starts with the sender's clock in Unix seconds, so a signature or
+ * seal over the frame covers the send time too. A receiver drops frames whose
+ * send time is further in the past than it remembers IDs (see fresh()), so
+ * a frame captured and replayed after the window cannot be credited again.
+ *
+ * The filter has a fixed size. It is split into IDEMPOTENCY_STRIPES
+ * stripes with their own lock, so listener shards rarely wait on each other.
+ * Each stripe holds:
+ * - an open-addressing set of 64-bit fingerprints
+ * - a ring buffer of the same fingerprints in arrival order
+ *
+ * An entry is forgotten when it is older than the window, or when its
+ * stripe is full and a new entry needs the room. Size the filter for peak
+ * transfers/s * window; evicted_early() counts the second case.
+ *
+ * Checking and inserting are O(1) and never allocate after a stripe's first
+ * use. The fingerprint is a keyed 64-bit hash, so two different transfers
+ * are mistaken for each other with probability about size() / 2^64.
+ */
+
+#ifndef IDEMPOTENCY_H
+#define IDEMPOTENCY_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#define IDEMPOTENCY_STRIPES 16
+#define IDEMPOTENCY_CAPACITY 65536  // Default number of transfers remembered
+#define IDEMPOTENCY_WINDOW 120      // Default seconds a transfer is remembered
+
+// Returns: a new transfer ID (24 hex digits): the current Unix time in
+// seconds, then 16 digits unique within this process and random across
+// processes
+std::string new_transfer_id();
+
+// Reads the send time at the start of a transfer ID.
+// Returns: false if transfer_id does not carry one
+bool transfer_id_time(const std::string& transfer_id, uint32_t& seconds);
+
+class IdempotencyFilter {
+public:
+    explicit IdempotencyFilter(size_t capacity = IDEMPOTENCY_CAPACITY, int window_seconds = IDEMPOTENCY_WINDOW);
+
+    // Forgets everything and changes the size and window (not thread-safe;
+    // call before transfers arrive)
+    void reset(size_t capacity, int window_seconds);
+
+    // Remembers (sender, transfer_id).
+    // Returns: false if the pair was already seen within the window
+    bool insert(const std::string& sender, const std::string& transfer_id);
+
+    // Accepts send times from a quarter of the window ahead of our clock (skew)
+    // to three quarters behind it, so a frame is always remembered for as long
+    // as its send time is accepted and a replay is caught either way.
+    // Returns: false if transfer_id has no send time or it is out of that range
+    bool fresh(const std::string& transfer_id) const;
+
+    size_t capacity() const { return stripe_capacity * IDEMPOTENCY_STRIPES; }
+    int window() const { return window_seconds; }
+    size_t size() const;                 // Transfers remembered right now
+    size_t bytes() const;                // Memory of the stripes in use
+    unsigned long duplicates() const;    // Duplicates dropped so far
+    unsigned long evicted_early() const; // Entries forgotten before the window passed
+    unsigned long expired() const { return expired_count.load(); } // IDs rejected by fresh()
+
+private:
+    IdempotencyFilter(const IdempotencyFilter&);
+    IdempotencyFilter& operator=(const IdempotencyFilter&);
+
+    struct Stripe {
+        mutable std::mutex stripe_mutex;
+        std::vector<uint64_t> slots;     // Fingerprint set (0 = empty), 2x ring size
+        std::vector<uint64_t> ring;      // Fingerprints, oldest at head
+        std::vector<uint32_t> times;     // Arrival second of each ring entry
+        size_t head;
+        size_t count;
+        unsigned long duplicates;
+        unsigned long evicted_early;
+    };
+
+    uint64_t fingerprint(const std::string& sender, const std::string& transfer_id) const;
+    static size_t find_slot(const Stripe& stripe, uint64_t fp);
+    static void erase(Stripe& stripe, uint64_t fp);
+    void forget_oldest(Stripe& stripe);
+
+    Stripe stripes[IDEMPOTENCY_STRIPES];
+    size_t stripe_capacity;  // Ring size of each stripe (a power of two)
+    int window_seconds;
+    uint64_t seed;           // Hash key, random per process
+    mutable std::atomic<unsigned long> expired_count;
+};
+
+#endif
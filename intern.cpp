@@ -0,0 +1,65 @@
+/*
+ * P2P Micropayment System - Username Intern Table
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "intern.h"
+
+#include <cstring>
+
+using namespace std;
+
+bool InternTable::NameRef::operator==(const NameRef& other) const {
+    return length == other.length && memcmp(data, other.data, length) == 0;
+}
+
+/*
+ * Name Hash
+ * FNV-1a over the name bytes
+ */
+size_t InternTable::NameRefHash::operator()(const NameRef& ref) const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < ref.length; i++) {
+        hash ^= (unsigned char)ref.data[i];
+        hash *= 1099511628211ULL;
+    }
+    return (size_t)hash;
+}
+
+UserId InternTable::intern(const string& name) {
+    lock_guard<mutex> lock(table_mutex);
+    NameRef key = {name.data(), name.size()};
+    auto it = ids.find(key);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    UserId id = (UserId)names.size();
+    names.push_back(name);
+    // The key must point at the stored copy, not at the caller's string
+    NameRef stored = {names.back().data(), names.back().size()};
+    ids[stored] = id;
+    return id;
+}
+
+UserId InternTable::find(const string& name) const {
+    lock_guard<mutex> lock(table_mutex);
+    NameRef key = {name.data(), name.size()};
+    auto it = ids.find(key);
+    return it == ids.end() ? NO_USER : it->second;
+}
+
+const string& InternTable::name(UserId id) const {
+    lock_guard<mutex> lock(table_mutex);
+    return names[id];
+}
+
+size_t InternTable::size() const {
+    lock_guard<mutex> lock(table_mutex);
+    return names.size();
+}
+
+InternTable& user_names() {
+    static InternTable table;
+    return table;
+}
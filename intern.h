@@ -0,0 +1,60 @@
+/*
+ * P2P Micropayment System - Username Intern Table
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Maps every username seen in a login/List reply to a dense 32-bit UserId.
+ * Each name is stored once; the directory and the transfer path work on
+ * UserIds and only turn them back into names for display or the wire.
+ *
+ * IDs are never reused and names are never removed, so a UserId and the
+ * reference returned by name() stay valid for the life of the program.
+ * Only names from the server are interned; names received from peers are
+ * looked up with find() so a peer cannot grow the table.
+ */
+
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+typedef uint32_t UserId;
+
+#define NO_USER ((UserId)0xFFFFFFFF)  // find() result for unknown names
+
+class InternTable {
+public:
+    // Returns: the ID of name, adding it if it is new
+    UserId intern(const std::string& name);
+
+    // Returns: the ID of name, or NO_USER if it was never interned
+    UserId find(const std::string& name) const;
+
+    // Name of an interned ID (id must come from this table)
+    const std::string& name(UserId id) const;
+
+    size_t size() const;
+
+private:
+    // Key that points into names, so lookups by std::string do not allocate
+    struct NameRef {
+        const char* data;
+        size_t length;
+        bool operator==(const NameRef& other) const;
+    };
+    struct NameRefHash {
+        size_t operator()(const NameRef& ref) const;
+    };
+
+    mutable std::mutex table_mutex;               // Protects names and ids
+    std::deque<std::string> names;                // UserId -> name (stable references)
+    std::unordered_map<NameRef, UserId, NameRefHash> ids;  // name -> UserId
+};
+
+// The program-wide table shared by the directory and the payment client
+InternTable& user_names();
+
+#endif
@@ -0,0 +1,724 @@
+/*
+ * P2P Micropayment System - Socket I/O Backends
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Implementations of IoBackend (see io_backend.h). All three backends hand
+ * out the same completion-style events, so the listener shards do not need
+ * to know whether the kernel reported readiness (poll/epoll) or completed
+ * the operation for them (io_uring).
+ */
+
+#include "io_backend.h"
+#include "net.h"
+
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+// io_uring needs multishot accept and provided buffers from the kernel headers
+#if defined(__linux__) && defined(IORING_ACCEPT_MULTISHOT) && defined(__NR_io_uring_setup)
+#define HAVE_IO_URING 1
+#endif
+
+using namespace std;
+
+#define IO_BUFFER_SIZE 4096  // Same as BUFFER_SIZE in client.cpp
+#define IO_MAX_EVENTS 64     // Receives handed out per wait() by poll/epoll
+
+/*
+ * Default Round Trip
+ * One blocking send() followed by one recv(), exactly what the client did
+ * before the backends existed.
+ */
+bool IoBackend::round_trip(int fd, const string& request, string& response) {
+    response.clear();
+    syscalls++;
+    if (send(fd, request.c_str(), request.length(), SEND_FLAGS) == -1) {
+        perror("send");
+        return false;
+    }
+
+    char buffer[IO_BUFFER_SIZE];
+    syscalls++;
+    ssize_t received = recv(fd, buffer, IO_BUFFER_SIZE - 1, 0);
+    if (received == -1) {
+        perror("recv");
+    } else if (received > 0) {
+        response.assign(buffer, received);
+    }
+    return true;
+}
+
+/*
+ * Poll Backend
+ * Portable readiness loop: one poll() over every socket, then accept() and
+ * recv() on whatever is ready. Sockets stay level-triggered, so connections
+ * that did not fit into this batch are picked up by the next wait().
+ */
+class PollBackend : public IoBackend {
+public:
+    PollBackend() : scratch(IO_MAX_EVENTS * IO_BUFFER_SIZE) {}
+
+    const char* name() const { return "poll"; }
+
+    bool watch_listener(int fd) {
+        listeners.push_back(fd);
+        return true;
+    }
+
+    void unwatch_listener(int fd) {
+        listeners.erase(remove(listeners.begin(), listeners.end(), fd), listeners.end());
+    }
+
+    bool watch_wakeup(int fd) {
+        wakeups.push_back(fd);
+        return true;
+    }
+
+    bool watch_connection(int fd) {
+        connections.push_back(fd);
+        return true;
+    }
+
+    int wait(vector<IoEvent>& events, int timeout_ms) {
+        events.clear();
+        fds.clear();
+        for (int fd : wakeups) {
+            struct pollfd p = { fd, POLLIN, 0 };
+            fds.push_back(p);
+        }
+        for (int fd : listeners) {
+            struct pollfd p = { fd, POLLIN, 0 };
+            fds.push_back(p);
+        }
+        for (int fd : connections) {
+            struct pollfd p = { fd, POLLIN, 0 };
+            fds.push_back(p);
+        }
+
+        syscalls++;
+        if (poll(fds.data(), fds.size(), timeout_ms) == -1) {
+            if (errno == EINTR) {
+                return 0;
+            }
+            perror("poll");
+            return -1;
+        }
+
+        size_t used = 0;
+        for (const struct pollfd& p : fds) {
+            if (p.revents == 0) {
+                continue;
+            }
+            if (find(wakeups.begin(), wakeups.end(), p.fd) != wakeups.end()) {
+                IoEvent ev = { IO_WAKEUP, p.fd, 0, NULL };
+                events.push_back(ev);
+                wakeups.erase(find(wakeups.begin(), wakeups.end(), p.fd));  // Reported once
+            } else if (find(listeners.begin(), listeners.end(), p.fd) != listeners.end()) {
+                accept_all(p.fd, events);
+            } else if (used < IO_MAX_EVENTS) {
+                receive(p.fd, &scratch[used * IO_BUFFER_SIZE], events);
+                used++;
+            }
+        }
+        return events.size();
+    }
+
+private:
+    // Accept until the (non-blocking) listening socket's queue is empty
+    void accept_all(int listen_fd, vector<IoEvent>& events) {
+        while (true) {
+            syscalls++;
+            int client = accept(listen_fd, NULL, NULL);
+            if (client == -1) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    IoEvent ev = { IO_ACCEPT, listen_fd, -errno, NULL };
+                    events.push_back(ev);
+                }
+                return;
+            }
+            IoEvent ev = { IO_ACCEPT, listen_fd, client, NULL };
+            events.push_back(ev);
+        }
+    }
+
+    void receive(int fd, char* buffer, vector<IoEvent>& events) {
+        syscalls++;
+        ssize_t received = recv(fd, buffer, IO_BUFFER_SIZE, MSG_DONTWAIT);
+        if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
+        }
+        IoEvent ev = { IO_RECV, fd, received == -1 ? -errno : (int)received, buffer };
+        events.push_back(ev);
+        if (received <= 0) {
+            // The owner closes the socket after this event
+            connections.erase(find(connections.begin(), connections.end(), fd));
+        }
+    }
+
+    vector<int> listeners;
+    vector<int> wakeups;
+    vector<int> connections;
+    vector<struct pollfd> fds;
+    vector<char> scratch;
+};
+
+#ifdef __linux__
+/*
+ * Epoll Backend
+ * Same model as poll, but the interest set lives in the kernel, so each
+ * wait() costs one epoll_wait() instead of rebuilding the pollfd array.
+ */
+class EpollBackend : public IoBackend {
+public:
+    EpollBackend() : scratch(IO_MAX_EVENTS * IO_BUFFER_SIZE) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd == -1) {
+            perror("epoll_create1");
+        }
+    }
+
+    ~EpollBackend() {
+        if (epoll_fd != -1) {
+            close(epoll_fd);
+        }
+    }
+
+    const char* name() const { return "epoll"; }
+
+    bool watch_listener(int fd) {
+        listeners.push_back(fd);
+        return add(fd);
+    }
+
+    void unwatch_listener(int fd) {
+        listeners.erase(remove(listeners.begin(), listeners.end(), fd), listeners.end());
+        remove_fd(fd);
+    }
+
+    bool watch_wakeup(int fd) {
+        wakeups.push_back(fd);
+        return add(fd);
+    }
+
+    bool watch_connection(int fd) {
+        return add(fd);
+    }
+
+    int wait(vector<IoEvent>& events, int timeout_ms) {
+        events.clear();
+        struct epoll_event ready[IO_MAX_EVENTS];
+        syscalls++;
+        int n = epoll_wait(epoll_fd, ready, IO_MAX_EVENTS, timeout_ms);
+        if (n == -1) {
+            if (errno == EINTR) {
+                return 0;
+            }
+            perror("epoll_wait");
+            return -1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = ready[i].data.fd;
+            if (find(wakeups.begin(), wakeups.end(), fd) != wakeups.end()) {
+                IoEvent ev = { IO_WAKEUP, fd, 0, NULL };
+                events.push_back(ev);
+                wakeups.erase(find(wakeups.begin(), wakeups.end(), fd));  // Reported once
+                remove_fd(fd);
+                continue;
+            }
+            if (find(listeners.begin(), listeners.end(), fd) != listeners.end()) {
+                accept_all(fd, events);
+                continue;
+            }
+            char* buffer = &scratch[i * IO_BUFFER_SIZE];
+            syscalls++;
+            ssize_t received = recv(fd, buffer, IO_BUFFER_SIZE, MSG_DONTWAIT);
+            if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                continue;
+            }
+            // Closing the socket removes it from the epoll set, no EPOLL_CTL_DEL needed
+            IoEvent ev = { IO_RECV, fd, received == -1 ? -errno : (int)received, buffer };
+            events.push_back(ev);
+        }
+        return events.size();
+    }
+
+private:
+    bool add(int fd) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        syscalls++;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            perror("epoll_ctl");
+            return false;
+        }
+        return true;
+    }
+
+    void remove_fd(int fd) {
+        syscalls++;
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    }
+
+    void accept_all(int listen_fd, vector<IoEvent>& events) {
+        while (true) {
+            syscalls++;
+            int client = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+            if (client == -1) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    IoEvent ev = { IO_ACCEPT, listen_fd, -errno, NULL };
+                    events.push_back(ev);
+                }
+                return;
+            }
+            IoEvent ev = { IO_ACCEPT, listen_fd, client, NULL };
+            events.push_back(ev);
+        }
+    }
+
+    int epoll_fd;
+    vector<int> listeners;
+    vector<int> wakeups;
+    vector<char> scratch;
+};
+#endif
+
+#ifdef HAVE_IO_URING
+/*
+ * io_uring Backend
+ * Talks to the kernel through the raw io_uring_setup/io_uring_enter syscalls
+ * (no liburing dependency). Work is queued as SQEs and submitted together
+ * with the wait, so one io_uring_enter() covers:
+ * - a multishot accept per listener that keeps producing connections,
+ * - receives that pick a buffer from a kernel-owned pool (provided buffers)
+ *   instead of needing one buffer per idle connection,
+ * - re-providing the buffers consumed by the previous batch.
+ * A server round trip is one linked send+recv pair, i.e. one syscall.
+ */
+class UringBackend : public IoBackend {
+public:
+    UringBackend() : ring_fd(-1), sq_ptr(MAP_FAILED), cq_ptr(MAP_FAILED), sqes(NULL),
+                     timeout_armed(false), timeout_generation(0), multishot_accept(true),
+                     pool(POOL_BUFFERS * IO_BUFFER_SIZE), session_buffer(IO_BUFFER_SIZE) {}
+
+    ~UringBackend() {
+        if (sqes != NULL) {
+            munmap(sqes, sqes_len);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_len);
+        }
+        if (sq_ptr != MAP_FAILED) {
+            munmap(sq_ptr, sq_len);
+        }
+        if (ring_fd != -1) {
+            close(ring_fd);  // Cancels everything still in flight
+        }
+    }
+
+    /*
+     * Set up the ring and hand the receive buffer pool to the kernel.
+     * Returns: false if io_uring is not available (old kernel, seccomp, ...)
+     */
+    bool init() {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+        if (ring_fd < 0) {
+            ring_fd = -1;
+            return false;
+        }
+
+        sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_len = cq_len = max(sq_len, cq_len);
+        }
+        sq_ptr = mmap(NULL, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            return false;
+        }
+        cq_ptr = single_mmap ? sq_ptr : mmap(NULL, cq_len, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) {
+            return false;
+        }
+        sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+        void* sqe_mem = mmap(NULL, sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring_fd, IORING_OFF_SQES);
+        if (sqe_mem == MAP_FAILED) {
+            return false;
+        }
+        sqes = (struct io_uring_sqe*)sqe_mem;
+
+        char* sq = (char*)sq_ptr;
+        char* cq = (char*)cq_ptr;
+        sq_head = (unsigned*)(sq + params.sq_off.head);
+        sq_tail = (unsigned*)(sq + params.sq_off.tail);
+        sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+        sq_entries = params.sq_entries;
+        sq_array = (unsigned*)(sq + params.sq_off.array);
+        cq_head = (unsigned*)(cq + params.cq_off.head);
+        cq_tail = (unsigned*)(cq + params.cq_off.tail);
+        cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+        cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+        sq_local_tail = *sq_tail;
+
+        // Give the whole receive pool to the kernel in one request
+        struct io_uring_sqe* sqe = get_sqe();
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = POOL_BUFFERS;
+        sqe->addr = (unsigned long)pool.data();
+        sqe->len = IO_BUFFER_SIZE;
+        sqe->off = 0;
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->user_data = tag(OP_PROVIDE, 0);
+        return true;
+    }
+
+    const char* name() const { return "uring"; }
+
+    bool watch_listener(int fd) {
+        // io_uring waits for the connection itself; a non-blocking listener
+        // would make older kernels report -EAGAIN instead
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+        listeners.push_back(fd);
+        prep_accept(fd);
+        return true;
+    }
+
+    void unwatch_listener(int fd) {
+        listeners.erase(remove(listeners.begin(), listeners.end(), fd), listeners.end());
+        struct io_uring_sqe* sqe = get_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = tag(OP_ACCEPT, fd);
+        sqe->user_data = tag(OP_CANCEL, 0);
+    }
+
+    bool watch_wakeup(int fd) {
+        // One-shot poll: completes once, when fd becomes readable
+        struct io_uring_sqe* sqe = get_sqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = POLLIN;
+        sqe->user_data = tag(OP_WAKEUP, fd);
+        return true;
+    }
+
+    bool watch_connection(int fd) {
+        prep_recv(fd);
+        return true;
+    }
+
+    int wait(vector<IoEvent>& events, int timeout_ms) {
+        events.clear();
+
+        // Buffers handed out by the previous wait() are free again now
+        for (unsigned short bid : consumed) {
+            struct io_uring_sqe* sqe = get_sqe();
+            sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+            sqe->fd = 1;
+            sqe->addr = (unsigned long)&pool[bid * IO_BUFFER_SIZE];
+            sqe->len = IO_BUFFER_SIZE;
+            sqe->off = bid;
+            sqe->buf_group = BUFFER_GROUP;
+            sqe->user_data = tag(OP_PROVIDE, 0);
+        }
+        consumed.clear();
+        for (int fd : rearm) {
+            prep_recv(fd);
+        }
+        rearm.clear();
+
+        // One timeout is in flight at a time. It outlives a wait() that ends
+        // early, so a later wait() asking for less replaces it.
+        chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+        if (timeout_armed && deadline < timeout_deadline) {
+            struct io_uring_sqe* sqe = get_sqe();
+            sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+            sqe->addr = tag(OP_TIMEOUT, timeout_generation);
+            sqe->user_data = tag(OP_CANCEL, 0);
+            timeout_armed = false;
+        }
+        if (!timeout_armed) {
+            timeout_generation++;
+            timeout.tv_sec = timeout_ms / 1000;
+            timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+            struct io_uring_sqe* sqe = get_sqe();
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->addr = (unsigned long)&timeout;
+            sqe->len = 1;
+            sqe->user_data = tag(OP_TIMEOUT, timeout_generation);
+            timeout_deadline = deadline;
+            timeout_armed = true;
+        }
+
+        // Submit everything queued above and wait for at least one completion
+        if (enter(1) < 0 && errno != EINTR && errno != ETIME && errno != EBUSY) {
+            perror("io_uring_enter");
+            return -1;
+        }
+
+        struct io_uring_cqe cqe;
+        while (pop_cqe(cqe)) {
+            int op = (int)(cqe.user_data >> 32);
+            int fd = (int)(cqe.user_data & 0xffffffff);
+            if (op == OP_TIMEOUT) {
+                // A replaced timeout still completes (cancelled); only the current one counts
+                if (fd == timeout_generation) {
+                    timeout_armed = false;
+                }
+            } else if (op == OP_WAKEUP) {
+                IoEvent ev = { IO_WAKEUP, fd, 0, NULL };
+                events.push_back(ev);
+            } else if (op == OP_ACCEPT) {
+                bool watched = find(listeners.begin(), listeners.end(), fd) != listeners.end();
+                if (!watched && cqe.res == -ECANCELED) {
+                    continue;  // Cancelled by unwatch_listener()
+                }
+                if (watched && cqe.res == -EINVAL && multishot_accept) {
+                    // Kernel older than 5.19: fall back to one accept per SQE
+                    multishot_accept = false;
+                    prep_accept(fd);
+                    continue;
+                }
+                IoEvent ev = { IO_ACCEPT, fd, cqe.res, NULL };
+                events.push_back(ev);
+                if (watched && !(cqe.flags & IORING_CQE_F_MORE)) {
+                    prep_accept(fd);  // Multishot ended (or single-shot mode): re-arm
+                }
+            } else if (op == OP_RECV) {
+                if (cqe.res == -ENOBUFS) {
+                    rearm.push_back(fd);  // Pool exhausted, retry after buffers come back
+                    continue;
+                }
+                const char* data = NULL;
+                if (cqe.flags & IORING_CQE_F_BUFFER) {
+                    unsigned short bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+                    data = &pool[bid * IO_BUFFER_SIZE];
+                    consumed.push_back(bid);
+                }
+                if (cqe.res > 0) {
+                    rearm.push_back(fd);
+                }
+                IoEvent ev = { IO_RECV, fd, cqe.res, data };
+                events.push_back(ev);
+            }
+        }
+        return events.size();
+    }
+
+    /*
+     * Round Trip
+     * The SQEs point at session_request/session_buffer, which belong to the
+     * backend: if io_uring_enter() fails while the pair is in flight, both
+     * operations are cancelled and reaped before returning, and even if that
+     * fails too the kernel never writes into a stack frame that is gone.
+     */
+    bool round_trip(int fd, const string& request, string& response) {
+        response.clear();
+        session_request = request;
+
+        // Linked pair: the recv only starts once the send has completed
+        struct io_uring_sqe* sqe = get_sqe();
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = fd;
+        sqe->addr = (unsigned long)session_request.data();
+        sqe->len = session_request.length();
+        sqe->msg_flags = SEND_FLAGS;
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = tag(OP_SEND, fd);
+        sqe = get_sqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->addr = (unsigned long)&session_buffer[0];
+        sqe->len = IO_BUFFER_SIZE - 1;
+        sqe->user_data = tag(OP_SESSION_RECV, fd);
+
+        int sent = 0, received = 0;
+        int done = 0;
+        bool failed = false;
+        int retries = 0;
+        while (done < 2) {
+            if (enter(1) < 0 && errno != EINTR && errno != EBUSY) {
+                if (!failed) {
+                    perror("io_uring_enter");
+                    failed = true;
+                    cancel_session(fd);
+                } else if (++retries >= CANCEL_RETRIES) {
+                    return false;  // Ring unusable; the buffers stay valid until the destructor
+                }
+            }
+            struct io_uring_cqe cqe;
+            while (pop_cqe(cqe)) {
+                int op = (int)(cqe.user_data >> 32);
+                if (op == OP_SEND) {
+                    sent = cqe.res;
+                    done++;
+                } else if (op == OP_SESSION_RECV) {
+                    received = cqe.res;
+                    done++;
+                }
+            }
+        }
+        if (failed) {
+            return false;
+        }
+
+        if (sent < 0) {
+            errno = -sent;
+            perror("send");
+            return false;
+        }
+        if (sent < (int)request.length()) {
+            // Short send severed the link: finish the exchange the blocking way
+            return IoBackend::round_trip(fd, request.substr(sent), response);
+        }
+        if (received < 0) {
+            errno = -received;
+            perror("recv");
+        } else {
+            response.assign(&session_buffer[0], received);
+        }
+        return true;
+    }
+
+private:
+    enum { RING_ENTRIES = 256, POOL_BUFFERS = 256, BUFFER_GROUP = 1, CANCEL_RETRIES = 3 };
+    enum { OP_ACCEPT = 1, OP_RECV, OP_PROVIDE, OP_TIMEOUT, OP_SEND, OP_SESSION_RECV, OP_WAKEUP, OP_CANCEL };
+
+    static unsigned long long tag(int op, int fd) {
+        return ((unsigned long long)op << 32) | (unsigned int)fd;
+    }
+
+    // Next free SQE; submits what is queued if the ring is full
+    struct io_uring_sqe* get_sqe() {
+        if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+            enter(0);
+        }
+        unsigned index = sq_local_tail & sq_mask;
+        struct io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        sq_local_tail++;
+        return sqe;
+    }
+
+    // Publish queued SQEs and call io_uring_enter once
+    int enter(unsigned min_complete) {
+        __atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+        unsigned to_submit = sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        syscalls++;
+        return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+    }
+
+    bool pop_cqe(struct io_uring_cqe& out) {
+        unsigned head = *cq_head;
+        if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        out = cqes[head & cq_mask];
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    void prep_accept(int listen_fd) {
+        struct io_uring_sqe* sqe = get_sqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listen_fd;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        if (multishot_accept) {
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        }
+        sqe->user_data = tag(OP_ACCEPT, listen_fd);
+    }
+
+    // Queue cancellation of a round trip's send and recv; each still posts its CQE
+    void cancel_session(int fd) {
+        struct io_uring_sqe* sqe = get_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = tag(OP_SEND, fd);
+        sqe->user_data = tag(OP_CANCEL, 0);
+        sqe = get_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = tag(OP_SESSION_RECV, fd);
+        sqe->user_data = tag(OP_CANCEL, 0);
+    }
+
+    void prep_recv(int fd) {
+        struct io_uring_sqe* sqe = get_sqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->len = IO_BUFFER_SIZE;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->user_data = tag(OP_RECV, fd);
+    }
+
+    int ring_fd;
+    void* sq_ptr;
+    void* cq_ptr;
+    size_t sq_len, cq_len, sqes_len;
+    struct io_uring_sqe* sqes;
+    unsigned *sq_head, *sq_tail, *sq_array;
+    unsigned sq_mask, sq_entries, sq_local_tail;
+    unsigned *cq_head, *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+
+    struct __kernel_timespec timeout;
+    bool timeout_armed;
+    int timeout_generation;             // Tags the timeout in flight
+    chrono::steady_clock::time_point timeout_deadline;  // When it fires
+    bool multishot_accept;
+    vector<int> listeners;              // Listening sockets whose accept is re-armed
+    vector<char> pool;                  // POOL_BUFFERS receive buffers of IO_BUFFER_SIZE
+    vector<unsigned short> consumed;    // Buffer IDs to give back on the next wait()
+    vector<int> rearm;                  // Connections that need a new receive
+    string session_request;             // Request being sent by round_trip()
+    vector<char> session_buffer;        // Its reply; outlives a failed round trip
+};
+#endif
+
+IoBackend* create_io_backend(const string& preferred, const IoLogCallback& log) {
+#ifdef HAVE_IO_URING
+    if (preferred == "uring") {
+        UringBackend* uring = new UringBackend();
+        if (uring->init()) {
+            return uring;
+        }
+        delete uring;
+        if (log) {
+            log("io_uring is not available, falling back to epoll");
+        }
+    }
+#endif
+#ifdef __linux__
+    if (preferred != "poll") {
+        return new EpollBackend();
+    }
+#else
+    if ((preferred == "uring" || preferred == "epoll") && log) {
+        log(preferred + " is not available on this platform, falling back to poll");
+    }
+#endif
+    return new PollBackend();
+}
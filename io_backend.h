@@ -0,0 +1,80 @@
+/*
+ * P2P Micropayment System - Socket I/O Backends
+ * Course: Computer Networks (Fall 2025)
+ *
+ * The listener shards and the server session do their socket I/O through an
+ * IoBackend so the syscall strategy can be chosen at startup:
+ * - uring: io_uring with multishot accept, provided-buffer receives and
+ *          linked send+recv submissions (Linux 5.19+)
+ * - epoll: readiness notification plus accept4()/recv() (Linux)
+ * - poll:  portable fallback, used on macOS
+ * Requesting a backend that is unavailable falls back to the next one.
+ */
+
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+// Kinds of completion reported by IoBackend::wait()
+enum IoEventType {
+    IO_ACCEPT,  // result: accepted socket, or -errno
+    IO_RECV,    // result: bytes received, 0 on EOF, or -errno
+    IO_WAKEUP   // the wakeup descriptor became readable
+};
+
+// One completed operation
+struct IoEvent {
+    IoEventType type;
+    int fd;             // listening socket (IO_ACCEPT) or connection (IO_RECV)
+    int result;
+    const char* data;   // received bytes, valid until the next wait()
+};
+
+class IoBackend {
+public:
+    IoBackend() : syscalls(0) {}
+    virtual ~IoBackend() {}
+
+    // Backend name as accepted by create_io_backend()
+    virtual const char* name() const = 0;
+
+    // Start accepting connections on a listening socket
+    virtual bool watch_listener(int fd) = 0;
+
+    // Stop accepting on a listening socket; the owner may close it afterwards.
+    // An accept already completed by the kernel may still be reported.
+    virtual void unwatch_listener(int fd) = 0;
+
+    // Report IO_WAKEUP once when fd (an eventfd or the read end of a pipe)
+    // becomes readable, so another thread can interrupt wait(). The backend
+    // never reads from fd.
+    virtual bool watch_wakeup(int fd) = 0;
+
+    // Start receiving on an accepted connection. The owner closes the socket
+    // only after an IO_RECV event with result <= 0.
+    virtual bool watch_connection(int fd) = 0;
+
+    // Submit pending work and collect completions, waiting at most timeout_ms.
+    // Returns: number of events, or -1 on a fatal error
+    virtual int wait(std::vector<IoEvent>& events, int timeout_ms) = 0;
+
+    // Send a request on a blocking socket and receive one reply.
+    // Returns: false if the request could not be sent; response is empty
+    // when the peer closed the connection or recv() failed.
+    virtual bool round_trip(int fd, const std::string& request, std::string& response);
+
+    // Number of system calls issued by this backend so far
+    unsigned long syscalls;
+};
+
+// Receives the notice that the requested backend is not available
+typedef std::function<void(const std::string& text)> IoLogCallback;
+
+// Creates the requested backend ("uring", "epoll", "poll" or "auto"),
+// falling back to the best available one and telling log. Never returns NULL.
+IoBackend* create_io_backend(const std::string& preferred, const IoLogCallback& log = IoLogCallback());
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * P2P Micropayment System - Balance Ledger
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Local view of our account balance. The server's List reply is the source of
+ * truth; incoming transfers are credited optimistically until the next List.
+ * The balance is the only state shared by every handler thread and listener
+ * shard, so it is kept in atomics instead of being guarded by a mutex. The
+ * balance and the number of server updates share one word, so commit() can
+ * check that no update arrived and debit in a single compare-and-swap.
+ *
+ * Outgoing transfers sent in parallel each reserve their amount first, so
+ * together they cannot spend more than the balance: a reservation succeeds
+ * only while balance - reserved covers it, and is either released (the
+ * transfer failed) or committed (debited locally until the next List).
+ * A server balance that arrives while a transfer is in flight may already
+ * include it, so such a transfer is not debited again (see commit()).
+ */
+
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <atomic>
+#include <cstdint>
+
+class Ledger {
+public:
+    explicit Ledger(int initial_balance = 10000) : state(pack(0, initial_balance)), held(0) {}
+
+    int balance() const { return balance_of(state.load()); }
+
+    // Balance not held by transfers in flight
+    int available() const { return balance() - held.load(); }
+
+    // Balance as reported by the server
+    void set_balance(int balance) {
+        uint64_t current = state.load();
+        while (!state.compare_exchange_weak(current, pack(version_of(current) + 1, balance))) {
+        }
+    }
+
+    // Changes with every set_balance(); read it right before the transfer is sent
+    unsigned long version() const { return version_of(state.load()); }
+
+    // Optimistic credit for an incoming transfer.
+    // Returns: the new balance
+    int credit(int amount) {
+        uint64_t current = state.load();
+        int updated;
+        do {
+            updated = balance_of(current) + amount;
+        } while (!state.compare_exchange_weak(current, pack(version_of(current), updated)));
+        return updated;
+    }
+
+    // Holds amount for an outgoing transfer.
+    // Returns: false if the available balance does not cover it
+    bool reserve(int amount) {
+        int current = held.load();
+        do {
+            if (amount > balance() - current) {
+                return false;
+            }
+        } while (!held.compare_exchange_weak(current, current + amount));
+        return true;
+    }
+
+    // The transfer failed: the amount is available again
+    void release(int amount) { held.fetch_sub(amount); }
+
+    // The transfer was sent: debits the amount until the server's balance
+    // replaces it. since is version() from before the send; if the server's
+    // balance arrived in between (with pushed updates the recipient's report
+    // often beats the sender), it may already include the transfer and is
+    // left as it is. The check and the debit are one atomic step.
+    void commit(int amount, unsigned long since) {
+        uint64_t current = state.load();
+        while (version_of(current) == since &&
+               !state.compare_exchange_weak(current, pack(since, balance_of(current) - amount))) {
+        }
+        held.fetch_sub(amount);
+    }
+
+private:
+    static uint64_t pack(unsigned long version, int balance) {
+        return ((uint64_t)(uint32_t)version << 32) | (uint32_t)balance;
+    }
+    static unsigned long version_of(uint64_t word) { return (unsigned long)(word >> 32); }
+    static int balance_of(uint64_t word) { return (int)(uint32_t)word; }
+
+    std::atomic<uint64_t> state;  // set_balance() calls << 32 | balance
+    std::atomic<int> held;        // Reserved by transfers in flight
+};
+
+#endif
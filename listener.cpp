@@ -0,0 +1,713 @@
+/*
+ * P2P Micropayment System - P2P Listener
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "listener.h"
+#include "net.h"
+#include "io_backend.h"
+#include "slab_pool.h"
+#include "datagram.h"
+
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace std;
+
+#define CONNECTION_BUFFER_SIZE 64  // Inline receive buffer per connection; fits a typical transfer frame
+#define MAX_FRAME_BATCH 64         // Frames a shard hands to on_frame at once
+#define MAX_PARTIAL_FRAME (BUFFER_SIZE - 1)  // Bytes without a line ending a connection may buffer
+#define CONNECTION_IDLE_MS 10000   // A connection that sends nothing for this long is dropped
+#define IDLE_SWEEP_MS 1000         // How often a shard looks for idle connections
+
+// Per-connection state of a shard: the bytes received so far, in a small
+// fixed buffer that is reused for the next connection. A shard may hold
+// thousands of accepted connections at once, so the buffer is kept small and
+// the rare longer frame spills into a string, up to MAX_PARTIAL_FRAME.
+struct Connection {
+    int fd;
+    size_t length;                      // bytes buffered in data
+    char data[CONNECTION_BUFFER_SIZE];  // partial frames
+    string spill;                       // used instead of data once a frame does not fit
+    bool dropped;                       // Shut down by the shard; the rest of its data is ignored
+    chrono::steady_clock::time_point last_active;  // Accepted, or last received data
+};
+
+// Per-shard state: each shard owns its listening socket and the connections
+// it accepted. Connections come from the shard's own slab pool and are found
+// by file descriptor, so the accept/recv/close cycle does not touch malloc.
+struct ListenerShard {
+    int id;
+    int listen_fd;
+    int local_fd;                     // Unix domain socket for peers on this host (-1 = none)
+    SlabPool<Connection> pool;        // Connection objects, recycled per shard
+    vector<Connection*> connections;  // client socket -> Connection (NULL if none)
+    vector<string> batch;             // frames received in this loop iteration (strings are reused)
+    size_t batch_size;                // frames in use in batch
+    size_t open;                      // connections currently open
+    unsigned long accepted;           // connections accepted by this shard
+    unsigned long accepted_local;     // ... of which on local_fd
+    unsigned long transfers;          // transfer frames processed by this shard
+    unsigned long dropped_oversized;  // connections dropped for a frame over MAX_PARTIAL_FRAME
+    unsigned long dropped_idle;       // connections dropped after CONNECTION_IDLE_MS of silence
+};
+
+/*
+ * Open Connection
+ * Takes a Connection from the pool and registers it under its socket.
+ */
+static Connection* open_connection(ListenerShard& shard, int fd) {
+    if ((size_t)fd >= shard.connections.size()) {
+        shard.connections.resize(fd + 1, NULL);
+    }
+    Connection* conn = shard.pool.acquire();
+    conn->fd = fd;
+    conn->length = 0;
+    conn->spill.clear();
+    conn->dropped = false;
+    conn->last_active = chrono::steady_clock::now();
+    shard.connections[fd] = conn;
+    shard.open++;
+    return conn;
+}
+
+/*
+ * Close Connection
+ * Closes the socket and returns the Connection to the pool.
+ */
+static void close_connection(ListenerShard& shard, Connection* conn) {
+    close(conn->fd);
+    shard.connections[conn->fd] = NULL;
+    shard.pool.release(conn);
+    shard.open--;
+}
+
+/*
+ * Drop Connection
+ * Discards what the connection buffered and shuts the socket down. The
+ * backend then reports the end of the stream like any other, and the
+ * socket is closed there: io_uring may still have a receive in flight.
+ */
+static void drop_connection(Connection* conn) {
+    conn->dropped = true;
+    conn->length = 0;
+    string().swap(conn->spill);
+    shutdown(conn->fd, SHUT_RDWR);
+}
+
+/*
+ * Drop Idle Connections
+ * A peer that connects and then sends nothing (or never finishes its frame)
+ * would otherwise hold its connection slot forever.
+ */
+static void drop_idle_connections(ListenerShard& shard) {
+    chrono::steady_clock::time_point cutoff =
+        chrono::steady_clock::now() - chrono::milliseconds(CONNECTION_IDLE_MS);
+    for (Connection* conn : shard.connections) {
+        if (conn != NULL && !conn->dropped && conn->last_active < cutoff) {
+            drop_connection(conn);
+            shard.dropped_idle++;
+        }
+    }
+}
+
+/*
+ * Accept Backlog
+ * Accepts the connections still queued on a listening socket that is about
+ * to be closed, so transfers already on their way are drained instead of
+ * being reset with the socket.
+ */
+static void accept_backlog(ListenerShard& shard, IoBackend* io, int listen_fd) {
+    // io_uring switched the socket to blocking mode
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+    int client;
+    while ((client = accept(listen_fd, NULL, NULL)) != -1) {
+        if (io->watch_connection(client)) {
+            open_connection(shard, client);
+            shard.accepted++;
+        } else {
+            close(client);
+        }
+    }
+}
+
+/*
+ * Flush Batch
+ * Hands the frames collected so far to on_frame in one call, so the handler
+ * can check a burst of transfers together (e.g. verify their signatures in
+ * parallel).
+ */
+static void flush_batch(const Listener::FrameHandler& on_frame, ListenerShard& shard) {
+    if (shard.batch_size > 0) {
+        shard.transfers += on_frame(&shard.batch[0], shard.batch_size);
+        shard.batch_size = 0;
+    }
+}
+
+// Returns: the next slot of the batch (a reused string for the caller to overwrite),
+// flushing the batch first if it is full
+static string& next_batch_frame(const Listener::FrameHandler& on_frame, ListenerShard& shard) {
+    if (shard.batch_size == MAX_FRAME_BATCH) {
+        flush_batch(on_frame, shard);
+    }
+    if (shard.batch_size == shard.batch.size()) {
+        shard.batch.push_back(string());
+    }
+    return shard.batch[shard.batch_size++];
+}
+
+/*
+ * Queue Frames
+ * Adds every complete CRLF-terminated frame in data[0, length) to the batch.
+ * Returns: number of bytes consumed
+ */
+static size_t queue_frames(const Listener::FrameHandler& on_frame, ListenerShard& shard,
+                           const char* data, size_t length) {
+    size_t start = 0;
+    const char* end;
+    while ((end = (const char*)memchr(data + start, '\n', length - start)) != NULL) {
+        size_t frame_end = end - data + 1;
+        next_batch_frame(on_frame, shard).assign(data + start, frame_end - start);
+        start = frame_end;
+    }
+    return start;
+}
+
+/*
+ * Peak RSS
+ * Returns: the process's maximum resident set size in KB
+ */
+static long peak_rss_kb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == -1) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// Returns: milliseconds left until deadline, 0 once it has passed
+static long long milliseconds_until(chrono::steady_clock::time_point deadline) {
+    long long left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+    return left > 0 ? left : 0;
+}
+
+Listener::Listener()
+    : port(0), local_transport(false), datagrams(false), running(false), wakeup_read(-1), wakeup_write(-1), connections_cut(0) {}
+
+Listener::~Listener() {
+    stop(0);
+}
+
+bool Listener::start(int listen_port, int shards, const string& backend, FrameHandler handler, LogCallback log_callback) {
+    if (shards < 0 || !threads.empty()) {
+        return false;
+    }
+
+    // Bind here rather than in the threads, so a port already in use is
+    // reported to the caller instead of leaving a listener that never accepts
+    vector<int> listen_fds;
+    for (int i = 0; i < max(shards, 1); i++) {
+        int sock = shards > 0 ? open_listen_socket(listen_port, true, SOMAXCONN)
+                              : open_listen_socket(listen_port, false, 5);  // Queue up to 5 pending connections
+        if (sock == -1) {
+            break;
+        }
+        listen_fds.push_back(sock);
+    }
+    if ((int)listen_fds.size() < max(shards, 1) || !open_wakeup(wakeup_read, wakeup_write)) {
+        for (int fd : listen_fds) {
+            close(fd);
+        }
+        return false;
+    }
+    port = listen_port;
+    io_backend = backend;
+    on_frame = handler;
+    on_log = log_callback;
+    connections_cut = 0;
+    running = true;
+
+    if (shards > 0) {
+        // Sharded mode: N listeners bound to the same port with SO_REUSEPORT,
+        // the kernel spreads incoming connections across them
+        for (int i = 0; i < shards; i++) {
+            threads.push_back(thread(&Listener::shard_loop, this, i, listen_fds[i]));
+        }
+    } else {
+        threads.push_back(thread(&Listener::accept_loop, this, listen_fds[0]));
+    }
+    if (datagrams) {
+        threads.push_back(thread(&Listener::datagram_loop, this));
+    }
+    return true;
+}
+
+/*
+ * Stop
+ * Wakes the listener threads, which drain their open connections until
+ * stop_deadline, and joins them. Handler threads of single-thread mode are
+ * detached, so stop() waits for their sockets to be released instead.
+ */
+size_t Listener::stop(int timeout_ms) {
+    if (threads.empty()) {
+        return 0;  // Not started, or already stopped
+    }
+    stop_deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    running = false;
+    signal_wakeup(wakeup_write);
+    for (thread& t : threads) {
+        t.join();
+    }
+    threads.clear();
+
+    {
+        unique_lock<mutex> lock(handler_mutex);
+        if (!handler_done.wait_until(lock, stop_deadline, [this] { return handler_sockets.empty(); })) {
+            // Wake the handlers still blocked in recv(); they close their sockets and exit
+            connections_cut += handler_sockets.size();
+            for (int fd : handler_sockets) {
+                shutdown(fd, SHUT_RDWR);
+            }
+            handler_done.wait(lock, [this] { return handler_sockets.empty(); });
+        }
+    }
+
+    close_wakeup(wakeup_read, wakeup_write);
+    wakeup_read = wakeup_write = -1;
+    return connections_cut.exchange(0);
+}
+
+void Listener::log(const string& text) {
+    if (on_log) {
+        on_log(text);
+    }
+}
+
+/*
+ * Accept Loop
+ * Background thread that listens for incoming P2P connections from other clients.
+ * When another client wants to transfer money to us, they connect to this listener.
+ * For each incoming connection, spawns a new handler thread. Owns sock, the
+ * listening socket opened by start().
+ */
+void Listener::accept_loop(int sock) {
+    int local_sock = open_local();
+    // Non-blocking, so a connection reset between poll() and accept() cannot block the loop
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    if (local_sock != -1) {
+        fcntl(local_sock, F_SETFL, fcntl(local_sock, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    log("P2P listener started on port " + to_string(port) + (local_sock != -1 ? " (and local socket)" : ""));
+
+    // Wait for a connection or for stop(); poll() skips a local_sock of -1
+    struct pollfd fds[3] = { { sock, POLLIN, 0 }, { local_sock, POLLIN, 0 }, { wakeup_read, POLLIN, 0 } };
+    while (running) {
+        if (poll(fds, 3, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+        if (fds[2].revents != 0) {
+            break;
+        }
+
+        for (int i = 0; i < 2; i++) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            int client_sock = accept(fds[i].fd, NULL, NULL);
+            if (client_sock == -1) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    perror("accept");
+                }
+                continue;
+            }
+
+            // Handle this client connection in a new thread
+            start_handler(client_sock);
+        }
+    }
+
+    // Take the connections already queued before the sockets are closed
+    for (int i = 0; i < 2; i++) {
+        if (fds[i].fd == -1) {
+            continue;
+        }
+        int client_sock;
+        while ((client_sock = accept(fds[i].fd, NULL, NULL)) != -1) {
+            start_handler(client_sock);
+        }
+        close(fds[i].fd);
+    }
+    if (local_sock != -1) {
+        remove_local_socket(port);
+    }
+}
+
+/*
+ * Open Local
+ * The Unix domain socket for peers on this host, if enabled. Failing to
+ * open it only costs co-located peers the fast path.
+ * Returns: socket file descriptor, or -1
+ */
+int Listener::open_local() {
+    if (!local_transport) {
+        return -1;
+    }
+    int sock = open_local_listen_socket(port, SOMAXCONN);
+    if (sock == -1) {
+        log("Warning: local transport unavailable, peers on this host will use TCP");
+    }
+    return sock;
+}
+
+/*
+ * Datagram Loop
+ * Receives transfer frames over UDP (see datagram.h), up to DATAGRAM_BATCH
+ * datagrams per system call. The new frames of a batch go to on_frame in
+ * one call; only then are their seqs acknowledged, so an ack means the
+ * transfer was processed. Consecutive datagrams of one sender share an ACK.
+ */
+void Listener::datagram_loop() {
+    int sock = open_datagram_socket(port);
+    if (sock == -1) {
+        log("Warning: cannot receive datagrams on port " + to_string(port));
+        return;
+    }
+    log("P2P listener receiving datagrams on port " + to_string(port));
+
+    DatagramBatch in;
+    DatagramBatch acks;
+    DatagramDedup dedup;
+    vector<string> frames;
+    uint64_t sessions[DATAGRAM_BATCH];
+    uint32_t seqs[DATAGRAM_BATCH];
+    bool valid[DATAGRAM_BATCH];
+    unsigned long datagram_count = 0;
+    unsigned long transfers = 0;
+
+    struct pollfd fds[2] = { { sock, POLLIN, 0 }, { wakeup_read, POLLIN, 0 } };
+    bool draining = false;
+    while (true) {
+        if (!draining) {
+            if (poll(fds, 2, -1) == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("poll");
+                break;
+            }
+            // Stopped: take what is already queued on the socket, then leave
+            draining = fds[1].revents != 0;
+        }
+        size_t received = in.receive(sock);
+        if (received == 0) {
+            if (draining) {
+                break;
+            }
+            continue;
+        }
+
+        size_t count = 0;
+        for (size_t i = 0; i < received; i++) {
+            int frame_count = parse_data_datagram(in.data(i), in.length(i), sessions[i], seqs[i], frames, count);
+            valid[i] = frame_count >= 0;
+            if (valid[i]) {
+                datagram_count++;
+                if (dedup.first_time(sessions[i], seqs[i])) {
+                    count += frame_count;
+                }
+            }
+        }
+        if (count > 0) {
+            transfers += on_frame(&frames[0], count);
+        }
+
+        string* ack = NULL;
+        size_t acked = 0;  // A datagram acknowledged by ack
+        for (size_t i = 0; i < received; i++) {
+            if (!valid[i]) {
+                continue;
+            }
+            const struct sockaddr_in& from = in.from(i);
+            bool same = ack != NULL && sessions[i] == sessions[acked] &&
+                        memcmp(&from, &in.from(acked), sizeof(from)) == 0;
+            acked = i;
+            if (!same || !add_datagram_ack(*ack, sessions[i], seqs[i])) {
+                if (acks.full()) {
+                    acks.send(sock);
+                }
+                ack = &acks.add(from);
+                add_datagram_ack(*ack, sessions[i], seqs[i]);
+            }
+        }
+        if (acks.pending() > 0) {
+            acks.send(sock);
+        }
+    }
+    close(sock);
+
+    log("Datagram listener: received " + to_string(datagram_count) + " datagrams with " + to_string(transfers) +
+        " transfers (" + to_string(dedup.duplicates()) + " duplicates, " + to_string(dedup.late()) +
+        " older than the window), " + to_string(in.syscalls + acks.syscalls) +
+        " recvmmsg/sendmmsg calls");
+}
+
+/*
+ * Start Handler
+ * Runs handle_connection() on a new detached thread. The socket is listed in
+ * handler_sockets until the thread is done, so stop() can wait for it.
+ */
+void Listener::start_handler(int client_sock) {
+#ifndef __linux__
+    // BSD accept() passes O_NONBLOCK on to the new socket
+    fcntl(client_sock, F_SETFL, fcntl(client_sock, F_GETFL, 0) & ~O_NONBLOCK);
+#endif
+    {
+        lock_guard<mutex> lock(handler_mutex);
+        handler_sockets.push_back(client_sock);
+    }
+    thread handler(&Listener::handle_connection, this, client_sock);
+    handler.detach();  // Detach so handler runs independently
+}
+
+/*
+ * Handle Connection
+ * Handles an incoming P2P transfer from another client: receives one
+ * message (at most MAX_PARTIAL_FRAME bytes, like a shard) and hands it to
+ * the frame handler. A peer that sends nothing within CONNECTION_IDLE_MS
+ * is dropped, so it cannot hold a handler thread forever.
+ * Protocol: <sender>#<amount>#<recipient>\r\n
+ */
+void Listener::handle_connection(int client_sock) {
+    struct timeval timeout = { CONNECTION_IDLE_MS / 1000, (CONNECTION_IDLE_MS % 1000) * 1000 };
+    setsockopt(client_sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Receive transfer message from peer
+    string message = receive_message(client_sock);
+
+    if (!message.empty()) {
+        on_frame(&message, 1);
+    }
+
+    // Close P2P connection. Closed under the lock, so stop() never shuts
+    // down a descriptor that was already reused.
+    lock_guard<mutex> lock(handler_mutex);
+    handler_sockets.erase(find(handler_sockets.begin(), handler_sockets.end(), client_sock));
+    close(client_sock);
+    handler_done.notify_all();
+}
+
+/*
+ * Pin Thread To Core
+ * Binds the calling thread to one CPU core so a shard keeps its cache and
+ * its share of the socket's receive queues local. No-op outside Linux.
+ */
+void Listener::pin_thread_to_core(int core) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (err != 0) {
+        log("Warning: could not pin listener shard to core " + to_string(core) + ": " + strerror(err));
+    }
+#else
+    (void)core;
+#endif
+}
+
+/*
+ * Shard Loop
+ * One of N listeners bound to the port with SO_REUSEPORT. Instead of one thread
+ * per connection, each shard runs its own event loop (on the configured I/O
+ * backend) over its listening socket and the connections it accepted, so
+ * shards never contend with each other. Shards share only what the frame
+ * handler touches: the balance and the server reporting queue. Owns
+ * listen_fd, this shard's socket opened by start().
+ */
+void Listener::shard_loop(int shard_id, int listen_fd) {
+    unsigned int cores = thread::hardware_concurrency();
+    pin_thread_to_core(cores > 0 ? shard_id % cores : 0);
+
+    ListenerShard shard;
+    shard.id = shard_id;
+    shard.batch_size = 0;
+    shard.open = 0;
+    shard.accepted = 0;
+    shard.accepted_local = 0;
+    shard.transfers = 0;
+    shard.dropped_oversized = 0;
+    shard.dropped_idle = 0;
+    shard.listen_fd = listen_fd;
+    fcntl(shard.listen_fd, F_SETFL, fcntl(shard.listen_fd, F_GETFL, 0) | O_NONBLOCK);
+    // A Unix domain socket cannot be shared with SO_REUSEPORT, so shard 0 alone serves local peers
+    shard.local_fd = shard_id == 0 ? open_local() : -1;
+    if (shard.local_fd != -1) {
+        fcntl(shard.local_fd, F_SETFL, fcntl(shard.local_fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    IoBackend* io = create_io_backend(io_backend, [this](const string& text) { log(text); });
+    if (!io->watch_listener(shard.listen_fd) || (shard.local_fd != -1 && !io->watch_listener(shard.local_fd))) {
+        close(shard.listen_fd);
+        if (shard.local_fd != -1) {
+            close(shard.local_fd);
+        }
+        delete io;
+        return;
+    }
+    io->watch_wakeup(wakeup_read);  // Without it, stop() is noticed at the next timeout
+    log("P2P listener shard " + to_string(shard_id) + " started on port " + to_string(port) +
+        (shard.local_fd != -1 ? " and local socket" : "") + " (" + io->name() + ")");
+
+    vector<IoEvent> events;
+    bool draining = false;  // stop() was called: no new connections, finish the open ones
+    chrono::steady_clock::time_point next_sweep = chrono::steady_clock::now() + chrono::milliseconds(IDLE_SWEEP_MS);
+    while (true) {
+        int timeout_ms = IDLE_SWEEP_MS;
+        if (chrono::steady_clock::now() >= next_sweep) {
+            drop_idle_connections(shard);
+            next_sweep = chrono::steady_clock::now() + chrono::milliseconds(IDLE_SWEEP_MS);
+        }
+        if (!running && !draining) {
+            draining = true;
+            io->unwatch_listener(shard.listen_fd);
+            accept_backlog(shard, io, shard.listen_fd);
+            close(shard.listen_fd);
+            if (shard.local_fd != -1) {
+                io->unwatch_listener(shard.local_fd);
+                accept_backlog(shard, io, shard.local_fd);
+                close(shard.local_fd);
+                remove_local_socket(port);
+            }
+        }
+        if (draining) {
+            long long left = milliseconds_until(stop_deadline);
+            if (shard.open == 0 || left == 0) {
+                break;
+            }
+            timeout_ms = (int)min(left, (long long)timeout_ms);
+        }
+
+        if (io->wait(events, timeout_ms) == -1) {
+            break;
+        }
+
+        for (const IoEvent& ev : events) {
+            if (ev.type == IO_WAKEUP) {
+                continue;  // running is false by now; handled at the top of the loop
+            }
+            if (ev.type == IO_ACCEPT) {
+                if (ev.result < 0) {
+                    if (!draining) {
+                        errno = -ev.result;
+                        perror("accept");
+                    }
+                } else if (io->watch_connection(ev.result)) {
+                    open_connection(shard, ev.result);
+                    shard.accepted++;
+                    if (ev.fd == shard.local_fd) {
+                        shard.accepted_local++;
+                    }
+                } else {
+                    close(ev.result);
+                }
+                continue;
+            }
+
+            if (ev.fd < 0 || (size_t)ev.fd >= shard.connections.size() || shard.connections[ev.fd] == NULL) {
+                continue;
+            }
+            Connection* conn = shard.connections[ev.fd];
+            if (ev.result > 0 && conn->dropped) {
+                continue;  // Waiting for the end of the stream after drop_connection()
+            }
+            if (ev.result > 0) {
+                conn->last_active = chrono::steady_clock::now();
+                if (conn->spill.empty() && conn->length + ev.result <= CONNECTION_BUFFER_SIZE) {
+                    memcpy(conn->data + conn->length, ev.data, ev.result);
+                    conn->length += ev.result;
+                    size_t consumed = queue_frames(on_frame, shard, conn->data, conn->length);
+                    if (consumed > 0) {
+                        memmove(conn->data, conn->data + consumed, conn->length - consumed);
+                        conn->length -= consumed;
+                    }
+                } else {
+                    // Frame longer than the inline buffer
+                    if (conn->spill.empty()) {
+                        conn->spill.assign(conn->data, conn->length);
+                        conn->length = 0;
+                    }
+                    conn->spill.append(ev.data, ev.result);
+                    conn->spill.erase(0, queue_frames(on_frame, shard, conn->spill.data(), conn->spill.size()));
+                    if (conn->spill.size() > MAX_PARTIAL_FRAME) {
+                        // No transfer frame is this long; do not buffer a peer that never sends '\n'
+                        drop_connection(conn);
+                        shard.dropped_oversized++;
+                    }
+                }
+                continue;
+            }
+
+            // Peer closed (or error): a trailing frame without CRLF is still accepted,
+            // matching the single-recv behaviour of handle_connection()
+            if (ev.result == 0 && !conn->dropped && (conn->length > 0 || !conn->spill.empty())) {
+                string& frame = next_batch_frame(on_frame, shard);
+                if (conn->spill.empty()) {
+                    frame.assign(conn->data, conn->length);
+                } else {
+                    frame.swap(conn->spill);
+                }
+            }
+            close_connection(shard, conn);
+        }
+        flush_batch(on_frame, shard);
+    }
+    if (!draining) {
+        close(shard.listen_fd);  // The backend failed before stop()
+        if (shard.local_fd != -1) {
+            close(shard.local_fd);
+            remove_local_socket(port);
+        }
+    }
+
+    // Whatever is still open missed the deadline
+    size_t cut = shard.open;
+    for (Connection* conn : shard.connections) {
+        if (conn != NULL) {
+            close_connection(shard, conn);
+        }
+    }
+    connections_cut += cut;
+    log("Listener shard " + to_string(shard.id) + ": accepted " + to_string(shard.accepted) + " connections" +
+        (shard.local_fd != -1 ? " (" + to_string(shard.accepted_local) + " local)" : "") + ", processed " + to_string(shard.transfers) + " transfers, " +
+        to_string(io->syscalls) + " " + io->name() + " syscalls, " +
+        to_string(shard.pool.capacity()) + " connection slots (" + to_string(shard.pool.bytes() / 1024) +
+        " KB), peak RSS " + to_string(peak_rss_kb()) + " KB" +
+        (shard.dropped_oversized + shard.dropped_idle > 0
+             ? ", dropped " + to_string(shard.dropped_oversized) + " connections with an oversized frame and " +
+                   to_string(shard.dropped_idle) + " idle ones"
+             : "") +
+        (cut > 0 ? ", " + to_string(cut) + " connections cut off at shutdown" : ""));
+    delete io;
+}
@@ -0,0 +1,94 @@
+/*
+ * P2P Micropayment System - P2P Listener
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Accepts transfer connections from other clients on our P2P port and hands
+ * the received frames to a callback in batches. Two modes:
+ * - shards == 0: one accept thread, one handler thread per connection
+ * - shards == N: N listeners bound to the port with SO_REUSEPORT, each pinned
+ *   to a core and running its own event loop on an IoBackend
+ *
+ * stop() wakes every listener thread through one wakeup descriptor (an
+ * eventfd on Linux, a pipe elsewhere). The threads accept what is already in
+ * their backlog, close the listening sockets and keep reading the open
+ * connections until the peers are done or the deadline passes.
+ *
+ * With the local transport on, the listener also accepts on a Unix domain
+ * socket named after the port (see open_local_listen_socket() in net.h), so
+ * peers on the same host skip the TCP stack. In sharded mode only shard 0
+ * serves it.
+ *
+ * With datagrams on, one more thread receives transfer frames over UDP on
+ * the same port number (see datagram.h).
+ */
+
+#ifndef LISTENER_H
+#define LISTENER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+class Listener {
+public:
+    // Called with the frames received together (one per call in single-thread
+    // mode, up to one event loop iteration's worth in a shard); returns how
+    // many were valid transfers. May be called from several threads at once.
+    typedef std::function<size_t(const std::string* frames, size_t count)> FrameHandler;
+    // Status messages (listener started, shard statistics, warnings)
+    typedef std::function<void(const std::string& text)> LogCallback;
+
+    Listener();
+    ~Listener();
+
+    // Binds the listening socket(s) and starts the listener threads in the background.
+    // Returns: false if the options are invalid, the port cannot be bound or
+    //          the wakeup descriptor cannot be created
+    bool start(int port, int shards, const std::string& io_backend, FrameHandler on_frame, LogCallback log);
+
+    // Stops accepting, hands the frames still arriving on open connections
+    // to on_frame for up to timeout_ms, then closes whatever is left and
+    // joins all listener threads.
+    // Returns: number of connections cut off at the deadline (their transfers are lost)
+    size_t stop(int timeout_ms);
+
+    // Also accept on the local Unix domain socket; call before start()
+    void set_local_transport(bool enabled) { local_transport = enabled; }
+    // Also receive transfers as UDP datagrams; call before start()
+    void set_datagrams(bool enabled) { datagrams = enabled; }
+
+private:
+    void accept_loop(int sock);
+    void shard_loop(int shard_id, int listen_fd);
+    void datagram_loop();
+    int open_local();
+    void start_handler(int client_sock);
+    void handle_connection(int client_sock);
+    void pin_thread_to_core(int core);
+    void log(const std::string& text);
+
+    int port;                       // Our listening port for P2P connections
+    bool local_transport;           // Accept on the Unix domain socket as well
+    bool datagrams;                 // Receive UDP datagrams as well
+    std::string io_backend;         // Backend name for the shards
+    FrameHandler on_frame;
+    LogCallback on_log;
+    std::atomic<bool> running;
+    std::vector<std::thread> threads;  // Accept thread or shard threads, and the datagram thread
+    int wakeup_read;                   // Readable once stop() was called
+    int wakeup_write;                  // Same descriptor as wakeup_read for an eventfd
+    std::chrono::steady_clock::time_point stop_deadline;  // Set by stop() before waking the threads
+    std::atomic<size_t> connections_cut;  // Open connections closed at the deadline
+
+    // Single-thread mode: sockets of the running handler threads
+    std::vector<int> handler_sockets;
+    std::mutex handler_mutex;
+    std::condition_variable handler_done;
+};
+
+#endif
@@ -0,0 +1,530 @@
+/*
+ * P2P Micropayment System - Load Generator
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Drives a client's P2P listener the same way real peers do: for every
+ * transfer it opens a TCP connection, sends one sender#amount#recipient#id frame
+ * and closes the connection. Several worker threads run in parallel so the
+ * accept path of the target client is the bottleneck, not this tool.
+ *
+ * With --key-file every connection seals its frame like an encrypting client
+ * (see secure_frame.h), including the per-connection key derivation. With
+ * --signing-key every frame carries the sender's signature (see signing.h).
+ *
+ * Frames are sender#amount#recipient, as in the course protocol. With
+ * --transfer-ids on (implied by --signing-key, --key-file, --duplicate-every and udp) every
+ * frame gets a new transfer ID. With --duplicate-every N, every Nth
+ * transfer resends the previous frame instead (same ID, like a sender
+ * retrying), which the target should credit only once.
+ *
+ * The dialing sockets use a socket profile (see socket_profile.h). Given a
+ * comma-separated list, --socket-profile repeats the whole run once per
+ * profile and prints their latencies side by side. --transport tcp,unix,udp
+ * does the same for the transport: unix dials the target's local Unix
+ * domain socket (see open_local_listen_socket() in net.h) instead of TCP,
+ * which only works when the target runs on this host; udp sends the frames
+ * as acknowledged datagrams (see datagram.h) to a target started with
+ * --datagram. The workers wait for every ack, so --threads is also the
+ * number of frames that can share a datagram.
+ *
+ * With --outbound P the tool measures the sending side instead: <ip> <port>
+ * is the server, P in-process peers log in there and listen on --peer-port
+ * and up, and one sender pushes the transfers to them round-robin with
+ * PaymentClient::send_transfers(), first on one thread and then on
+ * --threads send threads. --balance limits the sender's balance, which
+ * shows the reservations stopping the batch at the balance.
+ *
+ * Usage: ./loadgen <ip> <port> [--threads T] [--transfers N] [--amount A]
+ *                  [--sender NAME] [--recipient NAME] [--key-file PATH] [--cipher NAME]
+ *                  [--signing-key PATH] [--duplicate-every N] [--transfer-ids on|off]
+ *                  [--socket-profile NAME[,NAME...]] [--transport tcp|unix|udp[,...]]
+ *                  [--outbound P] [--peer-port PORT] [--balance B]
+ */
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "protocol.h"
+#include "secure_frame.h"
+#include "signing.h"
+#include "idempotency.h"
+#include "socket_profile.h"
+#include "net.h"
+#include "datagram.h"
+#include "payment_client.h"
+
+using namespace std;
+
+// Load parameters (set from the command line)
+string target_ip = "127.0.0.1";
+int target_port = 0;
+int num_threads = 4;
+int num_transfers = 10000;
+int transfer_amount = 1;
+string sender_name = "loadgen";
+string recipient_name = "merchant";
+FrameKey frame_key;              // Loaded with --key-file: send encrypted frames
+CipherSuite cipher_suite = CIPHER_AES_256_GCM;
+SigningKey signing_key;          // Loaded with --signing-key: send signed frames
+enum Transport {
+    TRANSPORT_TCP,
+    TRANSPORT_UNIX,  // The target's Unix domain socket
+    TRANSPORT_UDP    // Acknowledged datagrams
+};
+Transport transport = TRANSPORT_TCP;
+DatagramSender datagram_sender;  // Started for the first udp run
+int duplicate_every = 0;         // Resend the previous frame every Nth transfer (0 = never)
+bool transfer_ids = false;       // Append a transfer ID to every frame (implied by signing and duplicates)
+int outbound_peers = 0;          // Peers of the outbound benchmark (0 = drive a listener instead)
+int peer_port = 9400;            // First listening port of the outbound peers
+int sender_balance = 0;          // Balance the outbound sender registers with (0 = enough for every run)
+
+atomic<int> next_transfer(0);   // Transfers handed out to workers so far
+atomic<int> failed_transfers(0);
+atomic<int> duplicate_transfers(0);  // Transfers that repeated the previous frame
+mutex latency_mutex;
+vector<double> latencies_us;    // Connect+send latency of every successful transfer
+
+static const char* transport_name(Transport which) {
+    return which == TRANSPORT_UNIX ? "unix" : which == TRANSPORT_UDP ? "udp" : "tcp";
+}
+
+/*
+ * Send One Transfer
+ * Connects to the target, sends a single transfer frame and closes. Over
+ * udp: sends the frame and waits for its ack.
+ * Returns: true on success, false on failure
+ */
+bool send_one_transfer(const struct sockaddr_in& addr, const string& frame) {
+    if (transport == TRANSPORT_UDP) {
+        return datagram_sender.send(addr, frame);
+    }
+    int sock;
+    if (transport == TRANSPORT_UNIX) {
+        sock = connect_local(target_port);
+        if (sock == -1) {
+            return false;
+        }
+    } else {
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock == -1) {
+            return false;
+        }
+        tune_socket(sock, SOCKET_PEER);
+        if (connect(sock, (const struct sockaddr*)&addr, sizeof(addr)) == -1) {
+            close(sock);
+            return false;
+        }
+    }
+    ssize_t sent = send(sock, frame.c_str(), frame.length(), 0);
+    close(sock);
+    return sent == (ssize_t)frame.length();
+}
+
+/*
+ * Worker Thread
+ * Keeps sending transfers until the shared budget is used up.
+ */
+void worker_thread() {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(target_port);
+    inet_pton(AF_INET, target_ip.c_str(), &addr.sin_addr);
+
+    vector<double> local;
+
+    string frame;
+    string signature;
+    string sealed;
+    int transfer;
+    while ((transfer = next_transfer.fetch_add(1)) < num_transfers) {
+        if (frame.empty() || duplicate_every <= 0 || (transfer + 1) % duplicate_every != 0) {
+            if (transfer_ids) {
+                frame = make_transfer_message(sender_name, transfer_amount, recipient_name, new_transfer_id());
+            } else {
+                frame = make_transfer_message(sender_name, transfer_amount, recipient_name);
+            }
+            if (signing_key.loaded()) {
+                if (!signing_key.sign(frame.data(), transfer_signed_length(frame), signature)) {
+                    failed_transfers++;
+                    continue;
+                }
+                append_transfer_signature(frame, signature);
+            }
+        } else {
+            duplicate_transfers++;
+        }
+
+        auto start = chrono::steady_clock::now();
+        bool ok;
+        if (frame_key.loaded()) {
+            // New connection, new connection key
+            FrameSealer sealer(frame_key, cipher_suite);
+            ok = sealer.seal(frame, sealed) && send_one_transfer(addr, sealed);
+        } else {
+            ok = send_one_transfer(addr, frame);
+        }
+        if (ok) {
+            auto end = chrono::steady_clock::now();
+            local.push_back(chrono::duration<double, micro>(end - start).count());
+        } else {
+            failed_transfers++;
+        }
+    }
+
+    lock_guard<mutex> lock(latency_mutex);
+    latencies_us.insert(latencies_us.end(), local.begin(), local.end());
+}
+
+/*
+ * Percentile
+ * Returns the p-th percentile of a sorted sample (0 if empty).
+ */
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1));
+    return sorted[index];
+}
+
+// Result of one run, for the comparison of socket profiles and transports
+struct RunSummary {
+    string profile;
+    string transport;
+    size_t completed;
+    int failed;
+    double throughput;
+    double p50_us;
+    double p99_us;
+    double p999_us;
+    double datagram_rate;  // Datagrams per second incl. retransmissions (udp only)
+};
+
+/*
+ * Run Load
+ * Sends num_transfers transfers with the current socket profile and
+ * transport and prints the results.
+ */
+RunSummary run_load() {
+    next_transfer = 0;
+    failed_transfers = 0;
+    duplicate_transfers = 0;
+    latencies_us.clear();
+    unsigned long datagrams_before = datagram_sender.datagrams_sent();
+    unsigned long retransmits_before = datagram_sender.retransmits();
+    unsigned long syscalls_before = datagram_sender.syscalls();
+
+    cout << "Sending " << num_transfers << " transfers to " << target_ip << ":" << target_port
+         << " from " << num_threads << " threads"
+         << (frame_key.loaded() ? string(" (") + cipher_suite_name(cipher_suite) + ")" : string(""))
+         << (signing_key.loaded() ? " (signed)" : "")
+         << (transport == TRANSPORT_UNIX  ? string(", Unix domain socket")
+             : transport == TRANSPORT_UDP ? string(", datagrams")
+                                          : ", socket profile " + socket_profile().name)
+         << "..." << endl;
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int i = 0; i < num_threads; i++) {
+        workers.push_back(thread(worker_thread));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    sort(latencies_us.begin(), latencies_us.end());
+    RunSummary summary;
+    summary.profile = socket_profile().name;
+    summary.transport = transport_name(transport);
+    summary.completed = latencies_us.size();
+    summary.failed = failed_transfers;
+    summary.throughput = elapsed > 0 ? latencies_us.size() / elapsed : 0;
+    summary.p50_us = percentile(latencies_us, 50);
+    summary.p99_us = percentile(latencies_us, 99);
+    summary.p999_us = percentile(latencies_us, 99.9);
+    unsigned long datagrams = datagram_sender.datagrams_sent() - datagrams_before;
+    summary.datagram_rate = elapsed > 0 ? datagrams / elapsed : 0;
+
+    cout << "Completed:   " << latencies_us.size() << " transfers in " << elapsed << " s" << endl;
+    cout << "Failed:      " << failed_transfers << endl;
+    if (duplicate_every > 0) {
+        cout << "Duplicates:  " << duplicate_transfers << " (resent frames the target should drop)" << endl;
+    }
+    cout << "Throughput:  " << summary.throughput << " transfers/s" << endl;
+    cout << "Latency us:  p50 " << summary.p50_us << "  p99 " << summary.p99_us << "  p99.9 " << summary.p999_us
+         << "  max " << percentile(latencies_us, 100) << endl;
+    if (transport == TRANSPORT_UDP) {
+        cout << "Datagrams:   " << datagrams << " (" << (datagrams > 0 ? (double)latencies_us.size() / datagrams : 0)
+             << " transfers each), " << datagram_sender.retransmits() - retransmits_before << " retransmitted, "
+             << summary.datagram_rate << " datagrams/s, " << datagram_sender.syscalls() - syscalls_before
+             << " sendmmsg/recvmmsg calls" << endl;
+    }
+    return summary;
+}
+
+/*
+ * Run Outbound
+ * Logs in the peers and the sender at the server, then sends the batch
+ * once per entry of send_threads and prints the throughput of each.
+ * Returns: exit code
+ */
+int run_outbound() {
+    if (frame_key.loaded() || signing_key.loaded()) {
+        cout << "--key-file and --signing-key are not supported with --outbound" << endl;
+        return 1;
+    }
+    vector<unique_ptr<PaymentClient> > peers;
+    for (int i = 0; i < outbound_peers; i++) {
+        unique_ptr<PaymentClient> peer(new PaymentClient());
+        string name = recipient_name + to_string(i);
+        if (!peer->connect(target_ip, target_port) || !peer->start_listener(peer_port + i, 1)) {
+            cout << "Peer " << name << " cannot connect or listen on port " << peer_port + i << endl;
+            return 1;
+        }
+        peer->register_user(name, 0);
+        if (peer->login(name) != REQUEST_OK) {
+            cout << "Peer " << name << " cannot log in" << endl;
+            return 1;
+        }
+        peers.push_back(move(peer));
+    }
+
+    PaymentClient sender;
+    sender.set_transfer_ids(transfer_ids);
+    int balance = sender_balance > 0 ? sender_balance : 2 * num_transfers * transfer_amount;
+    if (!sender.connect(target_ip, target_port)) {
+        cout << "Cannot connect to the server" << endl;
+        return 1;
+    }
+    sender.register_user(sender_name, balance);
+    if (sender.login(sender_name) != REQUEST_OK) {
+        cout << "Sender " << sender_name << " cannot log in" << endl;
+        return 1;
+    }
+
+    vector<TransferRequest> requests(num_transfers);
+    for (int i = 0; i < num_transfers; i++) {
+        requests[i].recipient = recipient_name + to_string(i % outbound_peers);
+        requests[i].amount = transfer_amount;
+    }
+
+    int runs[2] = {0, num_threads};
+    for (int run = 0; run < 2; run++) {
+        sender.refresh();
+        if (sender_balance > 0) {
+            sender.ledger.set_balance(sender_balance);  // Same start for both runs
+        }
+        long long received_before = 0;
+        for (const auto& peer : peers) {
+            received_before += peer->ledger.balance();
+        }
+
+        cout << (run > 0 ? "\n" : "") << "Sending " << num_transfers << " transfers from " << sender_name << " to "
+             << outbound_peers << " peers on " << runs[run] << " send threads, balance "
+             << sender.ledger.balance() << "..." << endl;
+        sender.set_send_threads(runs[run]);
+        vector<TransferResult> results;
+        auto start = chrono::steady_clock::now();
+        size_t sent = sender.send_transfers(requests, results);
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        size_t insufficient = 0;
+        for (const TransferResult& result : results) {
+            if (result.status == TRANSFER_INSUFFICIENT_BALANCE) {
+                insufficient++;
+            }
+        }
+
+        // Wait for the peers to credit what was sent
+        long long received = 0;
+        for (int wait = 0; wait < 200; wait++) {
+            received = -received_before;
+            for (const auto& peer : peers) {
+                received += peer->ledger.balance();
+            }
+            if (received >= (long long)sent * transfer_amount) {
+                break;
+            }
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+
+        cout << "Sent:        " << sent << " transfers in " << elapsed << " s" << endl;
+        cout << "Refused:     " << insufficient << " (insufficient balance)" << endl;
+        cout << "Failed:      " << results.size() - sent - insufficient << endl;
+        cout << "Spent:       " << (long long)sent * transfer_amount << " (received by peers: " << received << ")"
+             << endl;
+        cout << "Throughput:  " << (elapsed > 0 ? sent / elapsed : 0) << " transfers/s" << endl;
+    }
+
+    sender.shutdown();
+    sender.logout();
+    size_t dropped = 0;
+    for (const auto& peer : peers) {
+        dropped += peer->shutdown().reports_dropped;
+        peer->logout();
+    }
+    if (dropped > 0) {
+        cout << "Warning: peers dropped " << dropped << " TRANSACTION reports at shutdown" << endl;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cout << "Usage: " << argv[0] << " <ip> <port> [--threads T] [--transfers N] [--amount A]"
+             << " [--sender NAME] [--recipient NAME] [--key-file PATH] [--cipher NAME]"
+             << " [--signing-key PATH] [--duplicate-every N] [--transfer-ids on|off]"
+             << " [--socket-profile NAME[,NAME...]]"
+             << " [--transport tcp|unix[,...]] [--outbound P] [--peer-port PORT] [--balance B]" << endl;
+        return 1;
+    }
+    vector<SocketProfile> profiles;
+    vector<Transport> transports;
+    target_ip = argv[1];
+    target_port = atoi(argv[2]);
+    for (int i = 3; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--threads") {
+            num_threads = atoi(argv[i + 1]);
+        } else if (arg == "--transfers") {
+            num_transfers = atoi(argv[i + 1]);
+        } else if (arg == "--amount") {
+            transfer_amount = atoi(argv[i + 1]);
+        } else if (arg == "--sender") {
+            sender_name = argv[i + 1];
+        } else if (arg == "--recipient") {
+            recipient_name = argv[i + 1];
+        } else if (arg == "--key-file") {
+            string error;
+            if (!frame_key.load_file(argv[i + 1], error)) {
+                cout << "Cannot load key: " << error << endl;
+                return 1;
+            }
+        } else if (arg == "--signing-key") {
+            string error;
+            if (!signing_key.load_file(argv[i + 1], error)) {
+                cout << "Cannot load signing key: " << error << endl;
+                return 1;
+            }
+        } else if (arg == "--duplicate-every") {
+            duplicate_every = atoi(argv[i + 1]);
+        } else if (arg == "--transfer-ids") {
+            string value = argv[i + 1];
+            if (value != "on" && value != "off") {
+                cout << "--transfer-ids must be on or off" << endl;
+                return 1;
+            }
+            transfer_ids = value == "on";
+        } else if (arg == "--cipher") {
+            if (!parse_cipher_suite(argv[i + 1], cipher_suite)) {
+                cout << "Unknown cipher: " << argv[i + 1] << endl;
+                return 1;
+            }
+        } else if (arg == "--outbound") {
+            outbound_peers = atoi(argv[i + 1]);
+        } else if (arg == "--peer-port") {
+            peer_port = atoi(argv[i + 1]);
+        } else if (arg == "--balance") {
+            sender_balance = atoi(argv[i + 1]);
+        } else if (arg == "--socket-profile") {
+            string names = argv[i + 1];
+            size_t start = 0;
+            while (start <= names.size()) {
+                size_t comma = names.find(',', start);
+                string name = names.substr(start, comma == string::npos ? string::npos : comma - start);
+                SocketProfile profile;
+                if (!parse_socket_profile(name, profile)) {
+                    cout << "Unknown socket profile: " << name << endl;
+                    return 1;
+                }
+                profiles.push_back(profile);
+                start = comma == string::npos ? names.size() + 1 : comma + 1;
+            }
+        } else if (arg == "--transport") {
+            string names = argv[i + 1];
+            size_t start = 0;
+            while (start <= names.size()) {
+                size_t comma = names.find(',', start);
+                string name = names.substr(start, comma == string::npos ? string::npos : comma - start);
+                if (name != "tcp" && name != "unix" && name != "udp") {
+                    cout << "Unknown transport: " << name << endl;
+                    return 1;
+                }
+                transports.push_back(name == "unix" ? TRANSPORT_UNIX : name == "udp" ? TRANSPORT_UDP : TRANSPORT_TCP);
+                start = comma == string::npos ? names.size() + 1 : comma + 1;
+            }
+        } else {
+            cout << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+
+    // Signatures cover the ID, and a duplicate can only be recognized by it;
+    // the datagram receiver relies on it for seqs older than its window, and
+    // an encrypting or verifying client drops frames without it
+    if (signing_key.loaded() || frame_key.loaded() || duplicate_every > 0 ||
+        find(transports.begin(), transports.end(), TRANSPORT_UDP) != transports.end()) {
+        transfer_ids = true;
+    }
+    if (profiles.empty()) {
+        profiles.push_back(socket_profile());
+    }
+    if (transports.empty()) {
+        transports.push_back(TRANSPORT_TCP);
+    }
+    if (outbound_peers > 0) {
+        set_socket_profile(profiles[0]);
+        return run_outbound();
+    }
+
+    // Socket profiles only apply to TCP; the other transports run once
+    vector<RunSummary> runs;
+    for (size_t t = 0; t < transports.size(); t++) {
+        transport = transports[t];
+        if (transport == TRANSPORT_UDP && !datagram_sender.started()) {
+            string error;
+            if (!datagram_sender.start(error)) {
+                cout << error << endl;
+                return 1;
+            }
+        }
+        for (size_t i = 0; i < (transport == TRANSPORT_TCP ? profiles.size() : 1); i++) {
+            if (!runs.empty()) {
+                cout << endl;
+            }
+            set_socket_profile(profiles[i]);
+            runs.push_back(run_load());
+        }
+    }
+
+    if (runs.size() > 1) {
+        cout << endl
+             << "Transport  Profile        Completed  Failed  Transfers/s  Datagrams/s     p50 us     p99 us   p99.9 us"
+             << endl;
+        for (const RunSummary& run : runs) {
+            bool udp = run.transport == "udp";
+            printf("%-10s %-13s %10zu %7d %12.0f %12s %10.1f %10.1f %10.1f\n", run.transport.c_str(),
+                   run.transport == "tcp" ? run.profile.c_str() : "-", run.completed, run.failed, run.throughput,
+                   udp ? to_string((long)run.datagram_rate).c_str() : "-", run.p50_us, run.p99_us, run.p999_us);
+        }
+    }
+    return 0;
+}
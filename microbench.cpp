@@ -0,0 +1,745 @@
+/*
+ * P2P Micropayment System - Microbenchmarks
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Measures the hot paths of libp2ppay.a in isolation, without a server:
+ * - parse_list_reply() for 10, 1k and 100k online users
+ * - transfer frame parsing (parse_transfer_frame / handle_transfer_frame)
+ * - transfer message construction (make_transfer_message)
+ * - receive_message() over a socketpair
+ * - online user lookup (Directory::find by name and by UserId, InternTable::find)
+ * - directory rebuild, and lookups in FlatHashMap vs std::unordered_map
+ * - peer address for a dial: parsing the IP string vs the directory's cached sockaddr
+ * - sealing / opening encrypted transfer frames (AES-256-GCM, ChaCha20-Poly1305)
+ * - Ed25519 signing, and verifying batches of signatures on 1..N threads
+ * - duplicate transfer detection: IdempotencyFilter vs an unbounded std::unordered_set
+ * - per-connection state of a listener shard: std::map + std::string vs SlabPool
+ * - the poll, epoll and io_uring I/O backends: receives on watched sockets and
+ *   server round trips, including system calls per operation
+ *
+ * Every benchmark reports ns/op, items/s (signatures verified per second for
+ * the batch benchmarks, operations per second otherwise) and heap
+ * allocations/op (counted by replacing the global operator new). With --json
+ * the results are also written as JSON, so runs of two versions can be
+ * compared.
+ *
+ * Usage: ./microbench [--json FILE] [--filter TEXT] [--min-time MS]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <new>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "p2ppay.h"
+#include "slab_pool.h"
+
+using namespace std;
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+// Only the benchmark thread allocates while a benchmark runs
+static unsigned long allocation_count = 0;
+
+void* operator new(size_t size) {
+    allocation_count++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+// ============================================================================
+// Harness
+// ============================================================================
+
+struct BenchResult {
+    string name;
+    unsigned long iterations;
+    double ns_per_op;
+    double items_per_sec;
+    double allocs_per_op;
+    double syscalls_per_op;  // -1 when the benchmark does not count them
+};
+
+// Keeps results alive so the compiler cannot drop the measured work
+volatile size_t sink = 0;
+
+double min_time_ms = 200;  // Minimum measured time per benchmark
+string filter = "";        // Only run benchmarks whose name contains this
+vector<BenchResult> results;
+
+/*
+ * Run Benchmark
+ * Doubles the iteration count until one batch takes at least min_time_ms,
+ * then reports that batch. op() runs one iteration, which processes
+ * items_per_op items. If syscalls is given, it is a counter (such as
+ * IoBackend::syscalls) that op() advances, and syscalls/op is reported too.
+ */
+void run_benchmark(const string& name, const function<void()>& op, int items_per_op = 1,
+                   const unsigned long* syscalls = NULL) {
+    if (!filter.empty() && name.find(filter) == string::npos) {
+        return;
+    }
+
+    op();  // Warm up caches and lazily initialized state
+    unsigned long iterations = 1;
+    while (true) {
+        unsigned long allocs_before = allocation_count;
+        unsigned long syscalls_before = syscalls != NULL ? *syscalls : 0;
+        auto start = chrono::steady_clock::now();
+        for (unsigned long i = 0; i < iterations; i++) {
+            op();
+        }
+        double elapsed_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        unsigned long allocs = allocation_count - allocs_before;
+
+        if (elapsed_ns >= min_time_ms * 1e6 || iterations >= (1UL << 40)) {
+            BenchResult result;
+            result.name = name;
+            result.iterations = iterations;
+            result.ns_per_op = elapsed_ns / iterations;
+            result.items_per_sec = items_per_op * 1e9 / result.ns_per_op;
+            result.allocs_per_op = (double)allocs / iterations;
+            result.syscalls_per_op = syscalls != NULL ? (double)(*syscalls - syscalls_before) / iterations : -1;
+            results.push_back(result);
+
+            char line[160];
+            snprintf(line, sizeof(line), "%-40s %12lu %14.1f %14.0f %12.2f", name.c_str(), iterations,
+                     result.ns_per_op, result.items_per_sec, result.allocs_per_op);
+            cout << line;
+            if (syscalls != NULL) {
+                snprintf(line, sizeof(line), " %12.2f", result.syscalls_per_op);
+                cout << line;
+            }
+            cout << endl;
+            return;
+        }
+        iterations *= 2;
+    }
+}
+
+/*
+ * Write JSON
+ * {"benchmarks": [{"name": ..., "iterations": ..., "ns_per_op": ..., "items_per_sec": ..., "allocs_per_op": ...}]}
+ * The I/O backend benchmarks also have "syscalls_per_op".
+ */
+bool write_json(const string& path) {
+    ofstream out(path.c_str());
+    if (!out) {
+        cout << "Cannot write " << path << endl;
+        return false;
+    }
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "    {\"name\": \"%s\", \"iterations\": %lu, \"ns_per_op\": %.2f, \"items_per_sec\": %.1f, "
+                 "\"allocs_per_op\": %.3f",
+                 r.name.c_str(), r.iterations, r.ns_per_op, r.items_per_sec, r.allocs_per_op);
+        out << line;
+        if (r.syscalls_per_op >= 0) {
+            snprintf(line, sizeof(line), ", \"syscalls_per_op\": %.3f", r.syscalls_per_op);
+            out << line;
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+// ============================================================================
+// Fixtures
+// ============================================================================
+
+/*
+ * Make List Reply
+ * A login/List reply with num_users users, as the server would send it.
+ */
+string make_list_reply(int num_users) {
+    ostringstream reply;
+    reply << "10000" << CRLF;
+    reply << "-----BEGIN PUBLIC KEY-----MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAE" << CRLF;
+    reply << num_users << CRLF;
+    for (int i = 0; i < num_users; i++) {
+        reply << "user" << i << "#10.0." << (i / 256) % 256 << "." << i % 256 << "#" << 9000 + i % 1000 << CRLF;
+    }
+    return reply.str();
+}
+
+vector<OnlineUser> make_users(int num_users) {
+    return parse_list_reply(make_list_reply(num_users)).users;
+}
+
+/*
+ * Log In Offline
+ * Logs client in as user against a fake server on a loopback port that only
+ * answers the login, then closes the session: received transfers are
+ * credited, but no TRANSACTION reports pile up.
+ * Returns: false if the login failed
+ */
+bool log_in_offline(PaymentClient& client, const string& user) {
+    int listen_fd = open_listen_socket(0, false, 1);
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    if (listen_fd == -1 || getsockname(listen_fd, (struct sockaddr*)&addr, &length) == -1) {
+        return false;
+    }
+    thread server([listen_fd]() {
+        int sock = accept(listen_fd, NULL, NULL);
+        if (sock != -1) {
+            receive_message(sock);
+            send_message(sock, make_list_reply(10));
+            close(sock);
+        }
+        close(listen_fd);
+    });
+    bool ok = client.connect("127.0.0.1", ntohs(addr.sin_port)) && client.login(user) == REQUEST_OK;
+    server.join();
+    client.session.close();
+    return ok;
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+void bench_parse_list_reply() {
+    int sizes[] = {10, 1000, 100000};
+    for (int n : sizes) {
+        string reply = make_list_reply(n);
+        run_benchmark("parse_list_reply/" + to_string(n), [&]() {
+            ListReply parsed = parse_list_reply(reply);
+            sink += parsed.users.size();
+        });
+    }
+}
+
+void bench_transfer_frame() {
+    string frame = "alice#250#bob" + string(CRLF);
+    run_benchmark("parse_transfer_frame", [&]() {
+        TransferFrame parsed;
+        parse_transfer_frame(frame, parsed);
+        sink += parsed.amount;
+    });
+
+    // Full receive path: parse + recipient check + ledger credit (the session
+    // is closed after login, so no report is queued)
+    PaymentClient client;
+    if (!log_in_offline(client, "bob")) {
+        cout << "Cannot log in to the fake server" << endl;
+        return;
+    }
+    run_benchmark("handle_transfer_frame", [&]() {
+        sink += client.handle_transfer_frame(frame);
+    });
+}
+
+void bench_make_transfer_message() {
+    string sender = "alice";
+    string recipient = "bob";
+    run_benchmark("make_transfer_message", [&]() {
+        string message = make_transfer_message(sender, 250, recipient);
+        sink += message.size();
+    });
+    run_benchmark("make_transaction_message", [&]() {
+        string message = make_transaction_message(sender, recipient, "250");
+        sink += message.size();
+    });
+}
+
+void bench_receive_message() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+        perror("socketpair");
+        return;
+    }
+    string frame = "alice#250#bob" + string(CRLF);
+    // Includes the send() that makes a frame available to each recv()
+    run_benchmark("receive_message/socketpair", [&]() {
+        send(fds[0], frame.c_str(), frame.size(), 0);
+        string message = receive_message(fds[1]);
+        sink += message.size();
+    });
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void bench_directory_find() {
+    int sizes[] = {10, 1000, 100000};
+    for (int n : sizes) {
+        Directory directory;
+        directory.replace(make_users(n));
+        vector<string> names;
+        vector<UserId> ids;
+        for (int i = 0; i < 1024; i++) {
+            names.push_back("user" + to_string((i * 7919) % n));
+            ids.push_back(user_names().find(names.back()));
+        }
+        size_t next = 0;
+        run_benchmark("directory_find/" + to_string(n), [&]() {
+            OnlineUser user;
+            sink += directory.find(names[next++ & 1023], user);
+        });
+        run_benchmark("directory_find_id/" + to_string(n), [&]() {
+            PeerEndpoint endpoint;
+            sink += directory.find(ids[next++ & 1023], endpoint);
+        });
+        run_benchmark("intern_find/" + to_string(n), [&]() {
+            sink += user_names().find(names[next++ & 1023]);
+        });
+    }
+}
+
+/*
+ * User Table
+ * Lookup and rebuild of the directory's table: FlatHashMap of packed
+ * endpoints vs std::unordered_map of string addresses (the previous layout).
+ * Address parsing is left out here; directory_replace includes it.
+ */
+struct StringEndpoint {
+    string ip;
+    int port;
+};
+
+void bench_user_table() {
+    int sizes[] = {1000, 100000};
+    for (int n : sizes) {
+        vector<OnlineUser> users = make_users(n);
+        vector<UserId> ids;
+        for (const OnlineUser& user : users) {
+            ids.push_back(user_names().intern(user.username));
+        }
+        vector<UserId> probes;
+        for (int i = 0; i < 4096; i++) {
+            probes.push_back(ids[(i * 7919) % n]);
+        }
+
+        vector<PeerEndpoint> packed(n);
+        for (int i = 0; i < n; i++) {
+            pack_endpoint(users[i].ip, users[i].port, packed[i]);
+        }
+
+        unordered_map<UserId, StringEndpoint> node_table;
+        FlatHashMap<PeerEndpoint> flat_table;
+        run_benchmark("user_table_rebuild/unordered_map/" + to_string(n), [&]() {
+            node_table.clear();
+            node_table.reserve(n);
+            for (int i = 0; i < n; i++) {
+                StringEndpoint& endpoint = node_table[ids[i]];
+                endpoint.ip = users[i].ip;
+                endpoint.port = users[i].port;
+            }
+            sink += node_table.size();
+        });
+        run_benchmark("user_table_rebuild/flat/" + to_string(n), [&]() {
+            flat_table.clear();
+            flat_table.reserve(n);
+            for (int i = 0; i < n; i++) {
+                flat_table[ids[i]] = packed[i];
+            }
+            sink += flat_table.size();
+        });
+
+        size_t next = 0;
+        run_benchmark("user_table_find/unordered_map/" + to_string(n), [&]() {
+            auto it = node_table.find(probes[next++ & 4095]);
+            sink += it->second.port;
+        });
+        run_benchmark("user_table_find/flat/" + to_string(n), [&]() {
+            sink += endpoint_port(*flat_table.find(probes[next++ & 4095]));
+        });
+
+        Directory directory;
+        run_benchmark("directory_replace/" + to_string(n), [&]() {
+            directory.replace(users);
+            sink += directory.size();
+        });
+    }
+}
+
+/*
+ * Dial Address
+ * What a transfer does before connect(): "parse" is the old path through
+ * connect_to_server() (inet_pton + sockaddr_in from OnlineUser::ip), "cached"
+ * copies the sockaddr the directory built when the List reply was applied.
+ */
+void bench_dial_address() {
+    vector<OnlineUser> users = make_users(1000);
+    Directory directory;
+    directory.replace(users);
+    vector<UserId> ids;
+    for (const OnlineUser& user : users) {
+        ids.push_back(user_names().find(user.username));
+    }
+
+    size_t next = 0;
+    run_benchmark("dial_address/parse", [&]() {
+        const OnlineUser& user = users[next++ % users.size()];
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(user.port);
+        sink += inet_pton(AF_INET, user.ip.c_str(), &addr.sin_addr) + addr.sin_addr.s_addr;
+    });
+    run_benchmark("dial_address/cached", [&]() {
+        PeerEndpoint endpoint;
+        sink += directory.find(ids[next++ % ids.size()], endpoint) + endpoint_length(endpoint);
+    });
+}
+
+/*
+ * Secure Frame
+ * "connection" includes the per-connection key derivation (a new sealer and
+ * a new salt every time), like one loadgen transfer; "frame" reuses the
+ * connection and measures the AEAD pass alone. Opening reuses the
+ * per-thread cached key because every frame has the same salt.
+ */
+void bench_secure_frame() {
+#ifndef P2PPAY_NO_CRYPTO
+    char path[] = "/tmp/microbench_keyXXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1 || write(fd, "microbench network key", 22) != 22) {
+        perror("mkstemp");
+        return;
+    }
+    close(fd);
+    FrameKey key;
+    string error;
+    bool loaded = key.load_file(path, error);
+    unlink(path);
+    if (!loaded) {
+        cout << error << endl;
+        return;
+    }
+
+    string frame = "alice#250#bob" + string(CRLF);
+    CipherSuite suites[] = {CIPHER_AES_256_GCM, CIPHER_CHACHA20_POLY1305};
+    for (CipherSuite suite : suites) {
+        string name = cipher_suite_name(suite);
+        string line;
+        run_benchmark("seal_connection/" + name, [&]() {
+            FrameSealer sealer(key, suite);
+            sink += sealer.seal(frame, line);
+        });
+        FrameSealer sealer(key, suite);
+        run_benchmark("seal_frame/" + name, [&]() {
+            sink += sealer.seal(frame, line);
+        });
+        string opened;
+        run_benchmark("open_frame/" + name, [&]() {
+            sink += open_sealed_frame(key, line, opened);
+        });
+    }
+#endif
+}
+
+/*
+ * Signatures
+ * verify_batch/<W>w verifies a burst of 64 differently signed frames with
+ * verify_signatures() on the calling thread plus W pool workers; items/s is
+ * signatures verified per second. On a machine with fewer cores than
+ * threads the extra workers only add hand-off cost.
+ */
+void bench_signatures() {
+#ifndef P2PPAY_NO_CRYPTO
+    SigningKey key;
+    TrustStore trusted;
+    if (!key.generate() || !trusted.add("alice", key)) {
+        cout << "Cannot create a signing key" << endl;
+        return;
+    }
+
+    string frame = make_transfer_message("alice", 250, "bob");
+    string signature;
+    run_benchmark("sign_transfer", [&]() {
+        key.sign(frame.data(), transfer_signed_length(frame), signature);
+        sink += signature.size();
+    });
+
+    const int batch_size = 64;
+    vector<string> frames(batch_size);
+    vector<SignatureCheck> checks(batch_size);
+    for (int i = 0; i < batch_size; i++) {
+        frames[i] = make_transfer_message("alice", i + 1, "bob");
+        key.sign(frames[i].data(), transfer_signed_length(frames[i]), signature);
+        SignatureCheck& check = checks[i];
+        check.public_key = trusted.find("alice");
+        check.data = frames[i].data();
+        check.length = transfer_signed_length(frames[i]);
+        decode_signature(signature, check.signature);
+    }
+    run_benchmark("verify_signature", [&]() {
+        sink += verify_signature(checks[0].public_key, checks[0].data, checks[0].length, checks[0].signature);
+    });
+
+    unsigned int cores = thread::hardware_concurrency();
+    vector<int> worker_counts = {0, 1};
+    if (cores > 2) {
+        worker_counts.push_back(cores - 1);
+    }
+    for (int workers : worker_counts) {
+        WorkerPool pool;
+        pool.start(workers);
+        run_benchmark("verify_batch/" + to_string(workers) + "w", [&]() {
+            verify_signatures(&checks[0], batch_size, pool);
+            sink += checks[batch_size - 1].valid;
+        }, batch_size);
+    }
+#endif
+}
+
+/*
+ * Duplicate Filter
+ * insert/new sees a new transfer ID every time (the steady state, where old
+ * entries are evicted); insert/duplicate repeats one that is remembered.
+ * The unordered_set reference keeps every ID forever, which is what the
+ * filter's fixed memory avoids.
+ */
+void bench_duplicate_filter() {
+    string id = "0000000000000000";
+    unsigned long counter = 0;
+    auto next_id = [&]() {
+        static const char digits[] = "0123456789abcdef";
+        unsigned long value = counter++;
+        for (int i = 15; i >= 0; i--, value >>= 4) {
+            id[i] = digits[value & 0xF];
+        }
+    };
+
+    string sender = "alice";
+    IdempotencyFilter filter;
+    run_benchmark("duplicate_filter/insert/new", [&]() {
+        next_id();
+        sink += filter.insert(sender, id);
+    });
+    run_benchmark("duplicate_filter/insert/duplicate", [&]() {
+        sink += filter.insert(sender, id);
+    });
+    if (filter.size() > 0) {
+        cout << "  (filter: " << filter.size() << " IDs in " << filter.bytes() / 1024 << " KB, "
+             << filter.evicted_early() << " evicted early)" << endl;
+    }
+
+    unordered_set<string> seen;
+    counter = 0;
+    run_benchmark("duplicate_filter/unordered_set", [&]() {
+        next_id();
+        sink += seen.insert(sender + "#" + id).second;
+    });
+    if (!seen.empty()) {
+        cout << "  (unordered_set: " << seen.size() << " IDs, unbounded)" << endl;
+    }
+}
+
+/*
+ * Connection State
+ * One accept -> recv -> frame -> close cycle of a listener shard, without the
+ * sockets: "map" keeps the buffered bytes in a std::map<int, std::string>
+ * like the shards used to, "slab" uses pooled fixed buffers like listener.cpp.
+ */
+struct BenchConnection {
+    int fd;
+    size_t length;
+    char data[64];   // CONNECTION_BUFFER_SIZE in listener.cpp
+};
+
+void bench_connection_state() {
+    string wire = "loadgen#1#merchant" + string(CRLF);
+
+    map<int, string> pending;
+    int next_fd = 0;
+    run_benchmark("connection_state/map", [&]() {
+        int fd = 16 + (next_fd++ & 63);
+        pending[fd] = "";
+        string& data = pending[fd];
+        data.append(wire.data(), wire.size());
+        size_t end = data.find('\n');
+        string frame = data.substr(0, end + 1);
+        data.erase(0, end + 1);
+        sink += frame.size();
+        pending.erase(fd);
+    });
+
+    SlabPool<BenchConnection> pool;
+    vector<BenchConnection*> connections(128, NULL);
+    string frame;
+    run_benchmark("connection_state/slab", [&]() {
+        int fd = 16 + (next_fd++ & 63);
+        BenchConnection* conn = pool.acquire();
+        conn->fd = fd;
+        conn->length = 0;
+        connections[fd] = conn;
+        memcpy(conn->data, wire.data(), wire.size());
+        conn->length = wire.size();
+        const char* end = (const char*)memchr(conn->data, '\n', conn->length);
+        frame.assign(conn->data, end - conn->data + 1);
+        sink += frame.size();
+        connections[fd] = NULL;
+        pool.release(conn);
+    });
+}
+
+/*
+ * I/O Backends
+ * The same work on every backend this machine has ("uring" falls back to
+ * epoll where io_uring is missing, and is then skipped):
+ * - recv: one frame arrives on each of 16 watched socketpairs and wait() is
+ *   called until all 16 are received, like a listener shard with keep-alive
+ *   senders. The send()s that feed the sockets are not counted.
+ * - round_trip: one request/reply exchange with an echo thread, like a
+ *   server request on the session.
+ * syscalls/op counts only the calls made by the backend.
+ */
+void bench_io_backends() {
+    const int CONNECTIONS = 16;
+    const char* names[] = {"poll", "epoll", "uring"};
+    string frame = "alice#250#bob" + string(CRLF);
+
+    for (const char* name : names) {
+        IoBackend* backend = create_io_backend(name);
+        if (string(backend->name()) != name) {
+            delete backend;
+            continue;
+        }
+
+        int pairs[CONNECTIONS][2];
+        int opened = 0;
+        for (; opened < CONNECTIONS; opened++) {
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[opened]) == -1) {
+                perror("socketpair");
+                break;
+            }
+            backend->watch_connection(pairs[opened][1]);
+        }
+        vector<IoEvent> events;
+        if (opened == CONNECTIONS) {
+            run_benchmark(string("io_backend/") + name + "/recv", [&]() {
+                for (int i = 0; i < CONNECTIONS; i++) {
+                    send(pairs[i][0], frame.c_str(), frame.size(), 0);
+                }
+                int received = 0;
+                while (received < CONNECTIONS) {
+                    if (backend->wait(events, 1000) < 0) {
+                        break;
+                    }
+                    for (const IoEvent& ev : events) {
+                        if (ev.type == IO_RECV && ev.result > 0) {
+                            received++;
+                            sink += ev.result;
+                        }
+                    }
+                }
+            }, CONNECTIONS, &backend->syscalls);
+        }
+        for (int i = 0; i < opened; i++) {
+            close(pairs[i][0]);
+            close(pairs[i][1]);
+        }
+        delete backend;
+
+        // The session uses a backend of its own, so does this
+        backend = create_io_backend(name);
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+            perror("socketpair");
+            delete backend;
+            continue;
+        }
+        thread echo([&fds]() {
+            char buffer[256];
+            ssize_t n;
+            while ((n = recv(fds[1], buffer, sizeof(buffer), 0)) > 0) {
+                send(fds[1], buffer, n, 0);
+            }
+        });
+        string response;
+        run_benchmark(string("io_backend/") + name + "/round_trip", [&]() {
+            backend->round_trip(fds[0], frame, response);
+            sink += response.size();
+        }, 1, &backend->syscalls);
+        shutdown(fds[0], SHUT_RDWR);
+        echo.join();
+        close(fds[0]);
+        close(fds[1]);
+        delete backend;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    string json_path = "";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            min_time_ms = atof(argv[++i]);
+        } else {
+            cout << "Usage: " << argv[0] << " [--json FILE] [--filter TEXT] [--min-time MS]" << endl;
+            return 1;
+        }
+    }
+
+    char header[160];
+    snprintf(header, sizeof(header), "%-40s %12s %14s %14s %12s %12s", "benchmark", "iterations", "ns/op",
+             "items/s", "allocs/op", "syscalls/op");
+    cout << header << endl;
+
+    bench_parse_list_reply();
+    bench_transfer_frame();
+    bench_make_transfer_message();
+    bench_receive_message();
+    bench_directory_find();
+    bench_user_table();
+    bench_dial_address();
+    bench_secure_frame();
+    bench_signatures();
+    bench_duplicate_filter();
+    bench_connection_state();
+    bench_io_backends();
+
+    if (!json_path.empty() && !write_json(json_path)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,368 @@
+/*
+ * P2P Micropayment System - Blocking Socket Helpers
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "net.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+using namespace std;
+
+/*
+ * Connect to Server
+ * Creates a TCP socket and connects to the specified IP (or hostname) and port.
+ * Returns: socket file descriptor on success, -1 on failure
+ */
+int connect_to_server(const string& ip, int port, int timeout_ms) {
+    // Set up server address structure
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);  // Convert port to network byte order
+
+    // Convert IP address from string to binary form
+    if (inet_pton(AF_INET, ip.c_str(), &server_addr.sin_addr) == 1) {
+        return connect_to_address((struct sockaddr*)&server_addr, sizeof(server_addr), timeout_ms, SOCKET_SERVER);
+    }
+
+    // Not a dotted IPv4 address: look it up as a hostname or IPv6 address
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = NULL;
+    int err = getaddrinfo(ip.c_str(), to_string(port).c_str(), &hints, &result);
+    if (err != 0) {
+        cerr << "Cannot resolve " << ip << ": " << gai_strerror(err) << endl;
+        return -1;
+    }
+    int sock = connect_to_address(result->ai_addr, result->ai_addrlen, timeout_ms, SOCKET_SERVER);
+    freeaddrinfo(result);
+    return sock;
+}
+
+/*
+ * Connect to Address
+ * Same as connect_to_server() for an address that is already in network form.
+ */
+int connect_to_address(const struct sockaddr* addr, socklen_t length, int timeout_ms, SocketRole role) {
+    // Create TCP socket
+    int sock = socket(addr->sa_family, SOCK_STREAM, 0);
+    if (sock == -1) {
+        perror("socket");
+        return -1;
+    }
+    tune_socket(sock, role);
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    // On Linux the send timeout also bounds connect()
+    struct timeval timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+    if (timeout_ms > 0) {
+        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+
+    // Connect to server
+    if (connect(sock, addr, length) == -1) {
+        perror("connect");
+        close(sock);
+        return -1;
+    }
+
+    if (timeout_ms > 0) {
+        timeout.tv_sec = timeout.tv_usec = 0;
+        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+    return sock;
+}
+
+/*
+ * Set Keepalive
+ * Probes start after half the timeout of silence and are repeated three
+ * times, so a dead peer is noticed after about timeout_seconds.
+ */
+bool set_keepalive(int sock, int timeout_seconds) {
+    int on = 1;
+    int idle = timeout_seconds / 2 > 0 ? timeout_seconds / 2 : 1;
+    int interval = timeout_seconds / 6 > 0 ? timeout_seconds / 6 : 1;
+    int count = 3;
+    bool ok = setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on)) == 0;
+#if defined(TCP_KEEPIDLE)
+    ok = ok && setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle)) == 0;
+#elif defined(TCP_KEEPALIVE)
+    ok = ok && setsockopt(sock, IPPROTO_TCP, TCP_KEEPALIVE, &idle, sizeof(idle)) == 0;  // macOS
+#endif
+#ifdef TCP_KEEPINTVL
+    ok = ok && setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval)) == 0;
+#endif
+#ifdef TCP_KEEPCNT
+    ok = ok && setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count)) == 0;
+#endif
+#ifdef TCP_USER_TIMEOUT
+    unsigned int user_timeout = timeout_seconds * 1000;
+    ok = ok && setsockopt(sock, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout, sizeof(user_timeout)) == 0;
+#endif
+    (void)interval;
+    (void)count;
+    if (!ok) {
+        perror("setsockopt keepalive");
+    }
+    return ok;
+}
+
+/*
+ * Send Message
+ * Sends a message through the specified socket.
+ * Returns: true on success, false on failure
+ */
+bool send_message(int sock, const string& message) {
+    ssize_t sent = send(sock, message.c_str(), message.length(), SEND_FLAGS);
+    if (sent == -1) {
+        perror("send");
+        return false;
+    }
+    // cout << "[DEBUG] Actually sent " << sent << " bytes" << endl;
+    return true;
+}
+
+/*
+ * Receive Message
+ * Receives a message from the specified socket.
+ * Returns: received message as string, empty string on error
+ */
+string receive_message(int sock) {
+    char buffer[BUFFER_SIZE];
+    memset(buffer, 0, BUFFER_SIZE);
+
+    // cout << "[DEBUG] Calling recv() on socket " << sock << "..." << endl;
+    ssize_t received = recv(sock, buffer, BUFFER_SIZE - 1, 0);
+    // cout << "[DEBUG] recv() returned: " << received << endl;
+
+    if (received == -1) {
+        perror("recv");
+        return "";
+    } else if (received == 0) {
+        // cout << "[DEBUG] Connection closed by peer" << endl;
+        return "";
+    }
+
+    // cout << "[DEBUG] Received " << received << " bytes" << endl;
+    return string(buffer, received);
+}
+
+/*
+ * Open Listen Socket
+ * Creates a TCP socket bound to the given port on all interfaces and puts it
+ * into listening state. With reuse_port set, several sockets may be bound to
+ * the same port and the kernel load-balances new connections across them.
+ * Returns: socket file descriptor on success, -1 on failure
+ */
+int open_listen_socket(int port, bool reuse_port, int backlog) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == -1) {
+        perror("listener socket");
+        return -1;
+    }
+
+    // Set socket option to reuse address (useful for quick restart)
+    int opt = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) {
+        perror("setsockopt");
+        close(sock);
+        return -1;
+    }
+
+#ifdef SO_REUSEPORT
+    if (reuse_port && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+        perror("setsockopt SO_REUSEPORT");
+        close(sock);
+        return -1;
+    }
+#else
+    if (reuse_port) {
+        cout << "SO_REUSEPORT is not supported on this platform" << endl;
+        close(sock);
+        return -1;
+    }
+#endif
+
+    // Before listen(): the receive buffer decides the window scale
+    tune_socket(sock, SOCKET_LISTEN);
+
+    // Bind socket to our listening port
+    struct sockaddr_in listen_addr;
+    memset(&listen_addr, 0, sizeof(listen_addr));
+    listen_addr.sin_family = AF_INET;
+    listen_addr.sin_addr.s_addr = INADDR_ANY;  // Listen on all network interfaces
+    listen_addr.sin_port = htons(port);        // Convert port to network byte order
+
+    if (::bind(sock, (struct sockaddr*)&listen_addr, sizeof(listen_addr)) == -1) {
+        perror("bind");
+        close(sock);
+        return -1;
+    }
+
+    if (listen(sock, backlog) == -1) {
+        perror("listen");
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+
+int open_datagram_socket(int port) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == -1) {
+        perror("datagram socket");
+        return -1;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    // Best effort: the kernel caps it at net.core.rmem_max
+    int rcvbuf = DATAGRAM_RCVBUF;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (::bind(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        perror("bind datagram socket");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool open_wakeup(int& read_fd, int& write_fd) {
+#ifdef __linux__
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd == -1) {
+        perror("eventfd");
+        return false;
+    }
+    read_fd = write_fd = fd;
+#else
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe");
+        return false;
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL, 0) | O_NONBLOCK);
+    read_fd = fds[0];
+    write_fd = fds[1];
+#endif
+    return true;
+}
+
+void signal_wakeup(int write_fd) {
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t written = write(write_fd, &one, sizeof(one));
+#else
+    char one = 1;
+    ssize_t written = write(write_fd, &one, sizeof(one));
+#endif
+    (void)written;  // Only fails if already signalled
+}
+
+void clear_wakeup(int read_fd) {
+    char buffer[64];
+    while (read(read_fd, buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+void close_wakeup(int read_fd, int write_fd) {
+    close(read_fd);
+    if (write_fd != read_fd) {
+        close(write_fd);
+    }
+}
+
+/*
+ * Local Socket Address
+ * "\0p2ppay.<port>" in Linux's abstract namespace (no file, gone with the
+ * process), /tmp/p2ppay.<port>.sock elsewhere.
+ * Returns: the address length to pass to bind()/connect()
+ */
+static socklen_t local_socket_address(int port, struct sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+#ifdef __linux__
+    int length = snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, "p2ppay.%d", port);
+    return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + length);
+#else
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "/tmp/p2ppay.%d.sock", port);
+    return (socklen_t)sizeof(addr);
+#endif
+}
+
+int open_local_listen_socket(int port, int backlog) {
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock == -1) {
+        perror("local listener socket");
+        return -1;
+    }
+    struct sockaddr_un addr;
+    socklen_t length = local_socket_address(port, addr);
+    // A file left behind by a crashed client would block bind()
+    remove_local_socket(port);
+    if (::bind(sock, (struct sockaddr*)&addr, length) == -1 || listen(sock, backlog) == -1) {
+        perror("local listener bind");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+int connect_local(int port) {
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock == -1) {
+        return -1;
+    }
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    struct sockaddr_un addr;
+    socklen_t length = local_socket_address(port, addr);
+    if (connect(sock, (struct sockaddr*)&addr, length) == -1) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+void remove_local_socket(int port) {
+#ifndef __linux__
+    struct sockaddr_un addr;
+    local_socket_address(port, addr);
+    unlink(addr.sun_path);
+#else
+    (void)port;
+#endif
+}
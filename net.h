@@ -0,0 +1,95 @@
+/*
+ * P2P Micropayment System - Blocking Socket Helpers
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#ifndef NET_H
+#define NET_H
+
+#include <string>
+#include <sys/socket.h>
+
+#include "socket_profile.h"
+
+#define BUFFER_SIZE 4096  // Maximum size for network messages
+#define DATAGRAM_RCVBUF (1 << 20)  // Receive buffer of UDP sockets
+
+// send() flags: a peer that went away must not kill us with SIGPIPE
+// (macOS has no MSG_NOSIGNAL; connect_to_address() sets SO_NOSIGPIPE there)
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+// Creates a TCP socket and connects to ip:port (ip may also be a hostname).
+// timeout_ms > 0 bounds the connect() (Linux); 0 = the kernel's default.
+// The socket is tuned as a server session (see socket_profile.h).
+// Returns: socket file descriptor on success, -1 on failure
+int connect_to_server(const std::string& ip, int port, int timeout_ms = 0);
+
+// Creates a TCP socket of the address's family, tunes it for role and connects to it.
+// Returns: socket file descriptor on success, -1 on failure
+int connect_to_address(const struct sockaddr* addr, socklen_t length, int timeout_ms = 0,
+                       SocketRole role = SOCKET_PEER);
+
+// Lets the kernel detect a dead peer within about timeout_seconds: keepalive
+// probes while the connection is idle, and TCP_USER_TIMEOUT (Linux) while
+// sent data goes unacknowledged.
+// Returns: false if the options could not be set
+bool set_keepalive(int sock, int timeout_seconds);
+
+// Returns: true if the whole message was handed to send()
+bool send_message(int sock, const std::string& message);
+
+// One recv() of up to BUFFER_SIZE - 1 bytes.
+// Returns: received message, empty string on error or when the peer closed
+std::string receive_message(int sock);
+
+/*
+ * Local Transport
+ * Peers on the same host also listen on a Unix domain socket named after
+ * their P2P port (in the abstract namespace on Linux, a file in /tmp
+ * elsewhere), so a transfer between them skips the TCP handshake and the
+ * loopback network stack.
+ */
+
+// Creates the Unix domain socket for P2P port and listens on it.
+// Returns: socket file descriptor on success, -1 on failure (e.g. the name is taken)
+int open_local_listen_socket(int port, int backlog);
+
+// Connects to the local socket of the peer listening on port. Fails quietly,
+// so the caller can fall back to TCP.
+// Returns: socket file descriptor on success, -1 on failure
+int connect_local(int port);
+
+// Removes the socket file of port where the name is a file (not on Linux)
+void remove_local_socket(int port);
+
+// Creates a non-blocking UDP socket bound to port on all interfaces (0 = any
+// free port), with a receive buffer of at least DATAGRAM_RCVBUF bytes so a
+// burst of datagrams is not dropped while the owner is busy.
+// Returns: socket file descriptor on success, -1 on failure
+int open_datagram_socket(int port);
+
+/*
+ * Wakeup Descriptor
+ * Makes a thread sleeping in poll() (or an IoBackend) return: an eventfd on
+ * Linux, a pipe elsewhere. It stays readable until clear_wakeup(), so every
+ * thread waiting on the same descriptor sees the wakeup.
+ */
+
+// Returns: false if the descriptor cannot be created (read_fd == write_fd for an eventfd)
+bool open_wakeup(int& read_fd, int& write_fd);
+void signal_wakeup(int write_fd);
+// Makes the descriptor unreadable again
+void clear_wakeup(int read_fd);
+void close_wakeup(int read_fd, int write_fd);
+
+// Creates a TCP socket bound to port on all interfaces and listening.
+// With reuse_port, several sockets may share the port (SO_REUSEPORT).
+// Accepted connections inherit the socket profile's options.
+// Returns: socket file descriptor on success, -1 on failure
+int open_listen_socket(int port, bool reuse_port, int backlog);
+
+#endif
@@ -0,0 +1,527 @@
+/*
+ * P2P Micropayment System - Network Impairment Proxy
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Benchmarks on localhost see an RTT of a few microseconds, which hides
+ * what every round trip of a transfer or a TRANSACTION report costs on a
+ * real network. netproxy listens on a port and relays every TCP connection
+ * (and, with --udp, every datagram) to the target, adding:
+ *   --rtt MS        round-trip time: each direction is delayed by MS / 2
+ *   --jitter MS     up to MS more per chunk and direction (uniform)
+ *   --bandwidth K   a cap of K kbit/s per direction, for all connections together
+ *   --loss P        TCP: a chunk is held back a retransmission timeout (200 ms,
+ *                   doubling) with probability P; UDP: the datagram is dropped
+ *   --reorder P     UDP: a datagram is held back long enough for the next
+ *                   ones to overtake it, with probability P
+ *   --reset P       TCP: the connection is reset (RST both ways) instead of
+ *                   relaying a chunk, with probability P
+ * Bytes of one TCP connection are never reordered (the kernel would put
+ * them back in order anyway), so jitter and loss there show up as
+ * head-of-line delay, as on a real network. The first bytes of a connection
+ * also wait one extra RTT, standing in for the handshake the proxy's kernel
+ * answered at once.
+ *
+ * Put it between a client and the server:
+ *   ./netproxy 12346 127.0.0.1 12345 --rtt 20      (client connects to port 12346)
+ * or between loadgen and a client's P2P port:
+ *   ./netproxy 9100 127.0.0.1 9000 --rtt 100 --udp
+ *   ./loadgen 127.0.0.1 9100 --threads 8 --transfers 2000
+ *
+ * One thread relays everything with poll() and non-blocking sockets;
+ * Ctrl-C prints what was relayed and injected.
+ *
+ * Usage: ./netproxy <listen-port> <target-host> <target-port> [--rtt MS] [--jitter MS]
+ *                   [--bandwidth KBIT] [--loss P] [--reorder P] [--reset P] [--udp] [--seed S]
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdint.h>
+
+#include "net.h"
+
+using namespace std;
+
+#define PROXY_BACKLOG SOMAXCONN
+#define PROXY_CONNECT_TIMEOUT_MS 3000  // Connecting to the target
+#define PROXY_RTO_US 200000            // First retransmission timeout stood in for by --loss (Linux: 200 ms)
+#define PROXY_MAX_QUEUED 1048576       // Bytes held per direction before reading pauses
+#define PROXY_UDP_IDLE_US 60000000     // A UDP flow without traffic for this long is closed
+
+// Proxy parameters
+double rtt_ms = 0;
+double jitter_ms = 0;
+double bandwidth_kbit = 0;       // 0 = no cap
+double loss = 0;
+double reorder = 0;
+double reset = 0;
+bool relay_udp = false;
+mt19937 random_source(1);
+volatile sig_atomic_t stopping = 0;
+
+// Statistics
+unsigned long connections_accepted = 0;
+unsigned long connections_failed = 0;   // The target refused or timed out
+unsigned long connections_reset = 0;
+unsigned long long tcp_bytes = 0;
+unsigned long chunks_delayed = 0;       // Held back for --loss
+unsigned long datagrams_relayed = 0;
+unsigned long datagrams_dropped = 0;
+unsigned long datagrams_reordered = 0;
+
+typedef uint64_t Micros;
+
+Micros now_us() {
+    return (Micros)chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Returns: the one-way delay of one chunk or datagram
+Micros one_way_delay() {
+    Micros delay = (Micros)(rtt_ms * 500);
+    if (jitter_ms > 0) {
+        delay += (Micros)uniform_real_distribution<double>(0, jitter_ms * 1000)(random_source);
+    }
+    return delay;
+}
+
+bool chance(double probability) {
+    return probability > 0 && bernoulli_distribution(probability)(random_source);
+}
+
+// A bandwidth-capped link: returns when size bytes offered at ready are through it
+Micros through_link(Micros& link_free, Micros ready, size_t size) {
+    if (bandwidth_kbit <= 0) {
+        return ready;
+    }
+    link_free = max(link_free, ready) + (Micros)(size * 8 * 1000 / bandwidth_kbit);
+    return link_free;
+}
+
+// Bytes read from one side, waiting for their delivery time
+struct Chunk {
+    Micros due;
+    string data;
+};
+
+// One direction of a relayed connection
+struct Pipe {
+    int from;
+    int to;
+    deque<Chunk> queue;
+    size_t queued;        // Bytes in queue
+    string out;           // Due, not yet taken by send()
+    Micros last_due;      // Keeps the bytes in order
+    bool first;           // Nothing read yet (client side: adds the handshake RTT)
+    bool eof;             // from has closed; to's write side follows once drained
+    bool shut;
+};
+
+struct Relay {
+    Pipe up;              // Client -> target
+    Pipe down;            // Target -> client
+    bool dead;
+};
+
+vector<Relay> relays;
+Micros up_link_free = 0;    // The --bandwidth cap of each direction
+Micros down_link_free = 0;
+
+void init_pipe(Pipe& pipe, int from, int to, bool first) {
+    pipe.from = from;
+    pipe.to = to;
+    pipe.queued = 0;
+    pipe.last_due = 0;
+    pipe.first = first;
+    pipe.eof = false;
+    pipe.shut = false;
+}
+
+// Closes both sockets with an RST instead of a FIN
+void reset_relay(Relay& relay) {
+    struct linger abort_close = { 1, 0 };
+    setsockopt(relay.up.from, SOL_SOCKET, SO_LINGER, &abort_close, sizeof(abort_close));
+    setsockopt(relay.up.to, SOL_SOCKET, SO_LINGER, &abort_close, sizeof(abort_close));
+    relay.dead = true;
+    connections_reset++;
+}
+
+/*
+ * Read Pipe
+ * Reads what arrived on pipe.from and schedules it. Reads until the socket
+ * is empty so that a close right behind the data is passed on with it, the
+ * way the peer sent them. An error ends the direction like a close does.
+ * Returns: false if --reset picked the connection to be reset
+ */
+bool read_pipe(Pipe& pipe, Micros& link_free) {
+    char buffer[BUFFER_SIZE];
+    while (!pipe.eof && pipe.queued < PROXY_MAX_QUEUED) {
+        ssize_t received = recv(pipe.from, buffer, sizeof(buffer), 0);
+        if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return true;
+        }
+        if (received <= 0) {
+            pipe.eof = true;
+            return true;
+        }
+        if (chance(reset)) {
+            return false;
+        }
+        Micros now = now_us();
+        Micros due = now + one_way_delay();
+        if (pipe.first) {
+            due += (Micros)(rtt_ms * 1000);
+            pipe.first = false;
+        }
+        for (Micros rto = PROXY_RTO_US; chance(loss); rto *= 2) {
+            due += rto;
+            chunks_delayed++;
+        }
+        due = through_link(link_free, max(due, pipe.last_due), received);
+        pipe.last_due = due;
+        Chunk chunk = { due, string(buffer, received) };
+        pipe.queue.push_back(chunk);
+        pipe.queued += received;
+        tcp_bytes += received;
+    }
+    return true;
+}
+
+/*
+ * Flush Pipe
+ * Sends what is due. Returns: false if the receiving side is gone
+ */
+bool flush_pipe(Pipe& pipe, Micros now) {
+    while (!pipe.queue.empty() && pipe.queue.front().due <= now) {
+        pipe.out += pipe.queue.front().data;
+        pipe.queued -= pipe.queue.front().data.size();
+        pipe.queue.pop_front();
+    }
+    if (!pipe.out.empty()) {
+        ssize_t sent = send(pipe.to, pipe.out.data(), pipe.out.size(), SEND_FLAGS);
+        if (sent == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+        }
+        if (sent > 0) {
+            pipe.out.erase(0, sent);
+        }
+    }
+    if (pipe.eof && !pipe.shut && pipe.queue.empty() && pipe.out.empty()) {
+        shutdown(pipe.to, SHUT_WR);
+        pipe.shut = true;
+    }
+    return true;
+}
+
+// A UDP client (by source address) and the socket relaying it to the target
+struct UdpFlow {
+    struct sockaddr_in client;
+    int upstream;
+    Micros last_used;
+};
+
+// A datagram on its way
+struct Datagram {
+    int fd;                    // Socket to send it from
+    struct sockaddr_in to;
+    string data;
+};
+
+vector<UdpFlow> flows;
+multimap<Micros, Datagram> datagrams;   // By due time, in arrival order within one time
+struct sockaddr_in target_udp;
+
+// Schedules a datagram with the impairments of one direction
+void schedule_datagram(int fd, const struct sockaddr_in& to, const char* data, size_t length, Micros& link_free) {
+    if (chance(loss)) {
+        datagrams_dropped++;
+        return;
+    }
+    Micros due = now_us() + one_way_delay();
+    if (chance(reorder)) {
+        // Late enough for the datagrams of the next few milliseconds to pass it
+        due += (Micros)(rtt_ms * 500 + jitter_ms * 1000) + 1000;
+        datagrams_reordered++;
+    }
+    due = through_link(link_free, due, length);
+    Datagram datagram = { fd, to, string(data, length) };
+    datagrams.insert(make_pair(due, datagram));
+}
+
+// Reads every datagram waiting on the listening UDP socket
+void receive_from_clients(int udp_fd) {
+    char buffer[65536];
+    while (true) {
+        struct sockaddr_in from;
+        socklen_t length = sizeof(from);
+        ssize_t received = recvfrom(udp_fd, buffer, sizeof(buffer), 0, (struct sockaddr*)&from, &length);
+        if (received < 0) {
+            return;
+        }
+        UdpFlow* flow = NULL;
+        for (UdpFlow& candidate : flows) {
+            if (candidate.client.sin_addr.s_addr == from.sin_addr.s_addr &&
+                candidate.client.sin_port == from.sin_port) {
+                flow = &candidate;
+                break;
+            }
+        }
+        if (flow == NULL) {
+            int upstream = open_datagram_socket(0);
+            if (upstream == -1) {
+                continue;
+            }
+            UdpFlow created = { from, upstream, 0 };
+            flows.push_back(created);
+            flow = &flows.back();
+        }
+        flow->last_used = now_us();
+        schedule_datagram(flow->upstream, target_udp, buffer, received, up_link_free);
+    }
+}
+
+// Reads the target's replies on flow's socket
+void receive_from_target(UdpFlow& flow, int udp_fd) {
+    char buffer[65536];
+    ssize_t received;
+    while ((received = recv(flow.upstream, buffer, sizeof(buffer), 0)) >= 0) {
+        flow.last_used = now_us();
+        schedule_datagram(udp_fd, flow.client, buffer, received, down_link_free);
+    }
+}
+
+void send_due_datagrams(Micros now) {
+    while (!datagrams.empty() && datagrams.begin()->first <= now) {
+        const Datagram& datagram = datagrams.begin()->second;
+        sendto(datagram.fd, datagram.data.data(), datagram.data.size(), 0, (const struct sockaddr*)&datagram.to,
+               sizeof(datagram.to));
+        datagrams_relayed++;
+        datagrams.erase(datagrams.begin());
+    }
+}
+
+void print_statistics() {
+    cout << "\nConnections: " << connections_accepted << " relayed, " << connections_failed
+         << " could not reach the target, " << connections_reset << " reset" << endl;
+    cout << "TCP: " << tcp_bytes << " bytes relayed, " << chunks_delayed << " chunks held back for loss" << endl;
+    if (relay_udp) {
+        cout << "UDP: " << datagrams_relayed << " datagrams relayed, " << datagrams_dropped << " dropped, "
+             << datagrams_reordered << " reordered" << endl;
+    }
+}
+
+void handle_stop(int) {
+    stopping = 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        cout << "Usage: " << argv[0] << " <listen-port> <target-host> <target-port> [--rtt MS] [--jitter MS]"
+             << " [--bandwidth KBIT] [--loss P] [--reorder P] [--reset P] [--udp] [--seed S]" << endl;
+        return 1;
+    }
+    int listen_port = atoi(argv[1]);
+    string target_host = argv[2];
+    int target_port = atoi(argv[3]);
+    for (int i = 4; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--udp") {
+            relay_udp = true;
+        } else if (i + 1 >= argc) {
+            cout << "Missing value for " << arg << endl;
+            return 1;
+        } else if (arg == "--rtt") {
+            rtt_ms = atof(argv[++i]);
+        } else if (arg == "--jitter") {
+            jitter_ms = atof(argv[++i]);
+        } else if (arg == "--bandwidth") {
+            bandwidth_kbit = atof(argv[++i]);
+        } else if (arg == "--loss") {
+            loss = atof(argv[++i]);
+        } else if (arg == "--reorder") {
+            reorder = atof(argv[++i]);
+        } else if (arg == "--reset") {
+            reset = atof(argv[++i]);
+        } else if (arg == "--seed") {
+            random_source.seed((unsigned int)strtoul(argv[++i], NULL, 10));
+        } else {
+            cout << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+    if (rtt_ms < 0 || jitter_ms < 0 || bandwidth_kbit < 0 || loss < 0 || loss >= 1 || reorder < 0 || reorder > 1 ||
+        reset < 0 || reset > 1) {
+        cout << "Delays and the bandwidth must not be negative, probabilities must be in [0, 1) or [0, 1]" << endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, handle_stop);
+    signal(SIGTERM, handle_stop);
+
+    int listen_fd = open_listen_socket(listen_port, false, PROXY_BACKLOG);
+    if (listen_fd == -1) {
+        return 1;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+    int udp_fd = -1;
+    if (relay_udp) {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        struct addrinfo* result = NULL;
+        if (getaddrinfo(target_host.c_str(), to_string(target_port).c_str(), &hints, &result) != 0) {
+            cout << "Cannot resolve " << target_host << endl;
+            return 1;
+        }
+        memcpy(&target_udp, result->ai_addr, sizeof(target_udp));
+        freeaddrinfo(result);
+        udp_fd = open_datagram_socket(listen_port);
+        if (udp_fd == -1) {
+            return 1;
+        }
+    }
+    cout << "Relaying port " << listen_port << " to " << target_host << ":" << target_port
+         << (relay_udp ? " (TCP and UDP)" : "") << ": RTT " << rtt_ms << " ms, jitter " << jitter_ms
+         << " ms, bandwidth "
+         << (bandwidth_kbit > 0 ? to_string((long long)bandwidth_kbit) + " kbit/s" : string("unlimited")) << ", loss "
+         << loss * 100 << "%, reorder " << reorder * 100 << "%, reset " << reset * 100 << "%" << endl;
+
+    vector<struct pollfd> fds;
+    while (!stopping) {
+        Micros now = now_us();
+        Micros next_due = UINT64_MAX;
+        fds.clear();
+        struct pollfd listen_poll = { listen_fd, POLLIN, 0 };
+        fds.push_back(listen_poll);
+        if (udp_fd != -1) {
+            struct pollfd udp_poll = { udp_fd, POLLIN, 0 };
+            fds.push_back(udp_poll);
+        }
+        size_t relay_base = fds.size();
+        for (const Relay& relay : relays) {
+            // fds[relay_base + 2i] is the client side, fds[relay_base + 2i + 1] the target side
+            short client_events = (!relay.up.eof && relay.up.queued < PROXY_MAX_QUEUED ? POLLIN : 0) |
+                                  (!relay.down.out.empty() ? POLLOUT : 0);
+            short target_events = (!relay.down.eof && relay.down.queued < PROXY_MAX_QUEUED ? POLLIN : 0) |
+                                  (!relay.up.out.empty() ? POLLOUT : 0);
+            struct pollfd client_poll = { relay.up.from, client_events, 0 };
+            struct pollfd target_poll = { relay.down.from, target_events, 0 };
+            fds.push_back(client_poll);
+            fds.push_back(target_poll);
+            if (!relay.up.queue.empty()) {
+                next_due = min(next_due, relay.up.queue.front().due);
+            }
+            if (!relay.down.queue.empty()) {
+                next_due = min(next_due, relay.down.queue.front().due);
+            }
+        }
+        size_t flow_base = fds.size();
+        for (const UdpFlow& flow : flows) {
+            struct pollfd flow_poll = { flow.upstream, POLLIN, 0 };
+            fds.push_back(flow_poll);
+        }
+        if (!datagrams.empty()) {
+            next_due = min(next_due, datagrams.begin()->first);
+        }
+        int timeout = next_due == UINT64_MAX ? 1000 : (int)((max(next_due, now) - now + 999) / 1000);
+        if (poll(fds.data(), fds.size(), min(timeout, 1000)) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            return 1;
+        }
+        now = now_us();
+
+        for (size_t i = 0; i < relays.size(); i++) {
+            Relay& relay = relays[i];
+            const struct pollfd& client_poll = fds[relay_base + 2 * i];
+            const struct pollfd& target_poll = fds[relay_base + 2 * i + 1];
+            if ((client_poll.revents & (POLLIN | POLLHUP | POLLERR)) && !read_pipe(relay.up, up_link_free)) {
+                reset_relay(relay);
+                continue;
+            }
+            if ((target_poll.revents & (POLLIN | POLLHUP | POLLERR)) && !read_pipe(relay.down, down_link_free)) {
+                reset_relay(relay);
+                continue;
+            }
+            // What was just read may already be due (no --rtt)
+            Micros flushed = now_us();
+            if (!flush_pipe(relay.up, flushed) || !flush_pipe(relay.down, flushed)) {
+                relay.dead = true;
+            }
+            if (relay.up.shut && relay.down.shut) {
+                relay.dead = true;
+            }
+        }
+        for (size_t i = relays.size(); i-- > 0;) {
+            if (relays[i].dead) {
+                close(relays[i].up.from);
+                close(relays[i].up.to);
+                relays.erase(relays.begin() + i);
+            }
+        }
+
+        if (udp_fd != -1) {
+            if (fds[1].revents & POLLIN) {
+                receive_from_clients(udp_fd);
+            }
+            // flows may have grown above; only the polled ones are checked
+            for (size_t i = 0; flow_base + i < fds.size(); i++) {
+                if (fds[flow_base + i].revents & POLLIN) {
+                    receive_from_target(flows[i], udp_fd);
+                }
+            }
+            send_due_datagrams(now_us());
+            for (size_t i = flows.size(); i-- > 0;) {
+                if (now - min(now, flows[i].last_used) > PROXY_UDP_IDLE_US) {
+                    close(flows[i].upstream);
+                    flows.erase(flows.begin() + i);
+                }
+            }
+        }
+
+        // Every connection waiting, not one per pass: the senders do not wait for us
+        while (fds[0].revents & POLLIN) {
+            int client_fd = accept(listen_fd, NULL, NULL);
+            if (client_fd == -1) {
+                break;
+            }
+            int target_fd = connect_to_server(target_host, target_port, PROXY_CONNECT_TIMEOUT_MS);
+            if (target_fd == -1) {
+                connections_failed++;
+                close(client_fd);
+                continue;
+            }
+            fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(target_fd, F_SETFL, fcntl(target_fd, F_GETFL, 0) | O_NONBLOCK);
+            Relay relay;
+            init_pipe(relay.up, client_fd, target_fd, true);
+            init_pipe(relay.down, target_fd, client_fd, false);
+            relay.dead = false;
+            relays.push_back(relay);
+            connections_accepted++;
+        }
+    }
+    print_statistics();
+    return 0;
+}
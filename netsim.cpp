@@ -0,0 +1,540 @@
+/*
+ * P2P Micropayment System - Network Simulation
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Discrete-event simulation of thousands of clients and one server on a
+ * simulated clock, to see how the transfer and TRANSACTION reporting flows
+ * behave at a scale and on networks we cannot run for real. Only the
+ * sockets are simulated: messages are built and parsed by protocol.h,
+ * recipients are looked up in a Directory filled from a parsed List reply,
+ * and balances, reservations and duplicate checks go through Ledger and
+ * IdempotencyFilter, as in PaymentClient.
+ *
+ * Each client sends transfers to random other clients at --rate per second
+ * (Poisson arrivals) for --duration simulated seconds. Like the client, a
+ * transfer is one new TCP connection (handshake, then the message), and the
+ * recipient reports every transfer it credited with TRANSACTION over its
+ * one server connection, one request at a time. The server handles requests
+ * one after another in --server-us each.
+ *
+ * The network gives every host a link of --bandwidth Mbit/s each way. A
+ * message waits for the sender's link, crosses in rtt/2 plus up to --jitter,
+ * and waits for the receiver's link. --loss of all segments are lost and
+ * sent again after TCP's retransmission timeout (1 s for a SYN, 200 ms
+ * doubling for data); a stream never delivers out of order.
+ *
+ * Events at the same time run in the order they were scheduled and every
+ * random choice comes from one generator, so a run is a function of its
+ * options and --seed: the trace digest printed for each run (a hash of
+ * every delivery) is the same every time.
+ *
+ * Usage: ./netsim [--nodes N] [--rate R[,R...]] [--duration S] [--rtt MS] [--jitter MS]
+ *                 [--bandwidth MBIT] [--loss P] [--server-us US] [--seed S]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <chrono>
+#include <cstdlib>
+#include <stdint.h>
+
+#include "protocol.h"
+#include "ledger.h"
+#include "directory.h"
+#include "idempotency.h"
+#include "hex.h"
+
+using namespace std;
+
+#define SIM_BASE_PORT 10000       // Client i listens on SIM_BASE_PORT + i
+#define SIM_HEADER_BYTES 40       // TCP/IP headers per segment
+#define SIM_SYN_RTO_US 1000000    // Retransmission timeout of a lost SYN or SYN-ACK (Linux: 1 s)
+#define SIM_MIN_RTO_US 200000     // First retransmission timeout of lost data (Linux: 200 ms)
+#define SIM_DEDUP_CAPACITY 1024   // Transfer IDs each simulated client remembers
+#define SIM_BALANCE 100000        // Starting balance of every client
+
+typedef uint64_t SimTime;  // Microseconds
+
+// Simulation parameters
+int num_nodes = 1000;
+vector<double> rates;             // Transfers per client per second, one run each
+double duration_s = 10.0;
+double rtt_ms = 1.0;
+double jitter_ms = 0.0;
+double bandwidth_mbit = 1000.0;
+double loss = 0.0;
+double server_us = 20.0;          // Server time per request
+unsigned int seed = 1;
+
+/*
+ * Event Queue
+ * Callbacks ordered by time, then by the order they were scheduled in.
+ */
+class EventQueue {
+public:
+    EventQueue() : clock(0), scheduled(0), processed(0) {}
+
+    SimTime now() const { return clock; }
+    unsigned long events() const { return processed; }
+
+    void at(SimTime time, const function<void()>& action) {
+        Event event = { max(time, clock), scheduled++, action };
+        queue.push(event);
+    }
+
+    void run() {
+        while (!queue.empty()) {
+            Event event = queue.top();
+            queue.pop();
+            clock = event.time;
+            processed++;
+            event.action();
+        }
+    }
+
+private:
+    struct Event {
+        SimTime time;
+        unsigned long sequence;
+        function<void()> action;
+    };
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const {
+            return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+        }
+    };
+
+    priority_queue<Event, vector<Event>, Later> queue;
+    SimTime clock;
+    unsigned long scheduled;
+    unsigned long processed;
+};
+
+// One direction of a TCP connection
+struct Stream {
+    Stream() : last_arrival(0) {}
+    SimTime last_arrival;  // Later segments never overtake this one
+};
+
+/*
+ * Simulated Network
+ * Hosts 0..n-1 are the clients, host n is the server.
+ */
+class SimNetwork {
+public:
+    SimNetwork(EventQueue& events, int hosts, mt19937& random)
+        : events(events), random(random), uplink_free(hosts, 0), downlink_free(hosts, 0), segments(0),
+          retransmits(0), bytes(0), digest(14695981039346656037ULL) {}
+
+    // Delivers data from host from to host to, in order on stream
+    void send(int from, int to, Stream& stream, const string& data, const function<void(const string&)>& deliver) {
+        SimTime tx = transmit_time(data.size());
+        SimTime depart = max(events.now(), uplink_free[from]);
+        uplink_free[from] = depart + tx;
+        SimTime arrival = depart + tx + one_way() + lost_time(SIM_MIN_RTO_US);
+        arrival = max(arrival, stream.last_arrival);
+        stream.last_arrival = arrival;
+        bytes += data.size() + SIM_HEADER_BYTES;
+
+        events.at(arrival, [this, to, tx, data, deliver]() {
+            SimTime done = max(events.now(), downlink_free[to]) + tx;
+            downlink_free[to] = done;
+            events.at(done, [this, to, data, deliver]() {
+                record(to, data);
+                deliver(data);
+            });
+        });
+    }
+
+    // Opens a connection: SYN, SYN-ACK, then established runs at from
+    void connect(int from, int to, const function<void()>& established) {
+        SimTime tx = transmit_time(0);
+        bytes += 2 * SIM_HEADER_BYTES;
+        SimTime depart = max(events.now(), uplink_free[from]);
+        uplink_free[from] = depart + tx;
+        SimTime syn = depart + tx + one_way() + lost_time(SIM_SYN_RTO_US);
+        // The SYN-ACK leaves when the SYN is in; the listener's backlog is never full
+        events.at(syn, [this, to, tx, established]() {
+            SimTime reply = max(events.now(), uplink_free[to]);
+            uplink_free[to] = reply + tx;
+            events.at(reply + tx + one_way() + lost_time(SIM_SYN_RTO_US), established);
+        });
+    }
+
+    unsigned long segments_sent() const { return segments; }
+    unsigned long segments_retransmitted() const { return retransmits; }
+    unsigned long long bytes_sent() const { return bytes; }
+    uint64_t trace_digest() const { return digest; }
+
+private:
+    // Serialization delay of data plus headers on one link
+    SimTime transmit_time(size_t size) const {
+        return (SimTime)((size + SIM_HEADER_BYTES) * 8 / bandwidth_mbit);
+    }
+
+    SimTime one_way() {
+        SimTime delay = (SimTime)(rtt_ms * 500);
+        if (jitter_ms > 0) {
+            delay += (SimTime)(uniform_real_distribution<double>(0, jitter_ms * 1000)(random));
+        }
+        return delay;
+    }
+
+    // Returns: extra delay until a segment got through, rto doubling per loss
+    SimTime lost_time(SimTime rto) {
+        segments++;
+        SimTime delay = 0;
+        bernoulli_distribution lost(loss);
+        while (lost(random)) {
+            retransmits++;
+            delay += rto;
+            rto *= 2;
+        }
+        return delay;
+    }
+
+    // FNV-1a over (time, host, bytes) of every delivery
+    void record(int host, const string& data) {
+        uint64_t values[2] = { events.now(), (uint64_t)host };
+        const unsigned char* raw = (const unsigned char*)values;
+        for (size_t i = 0; i < sizeof(values); i++) {
+            digest = (digest ^ raw[i]) * 1099511628211ULL;
+        }
+        for (unsigned char c : data) {
+            digest = (digest ^ c) * 1099511628211ULL;
+        }
+    }
+
+    EventQueue& events;
+    mt19937& random;
+    vector<SimTime> uplink_free;    // When each host's outgoing link is idle
+    vector<SimTime> downlink_free;  // When each host's incoming link is idle
+    unsigned long segments;
+    unsigned long retransmits;
+    unsigned long long bytes;
+    uint64_t digest;
+};
+
+// A TRANSACTION waiting for the client's server connection
+struct PendingReport {
+    string message;
+    SimTime started;  // When the sender started the transfer
+};
+
+// One simulated client
+struct SimClient {
+    SimClient() : ledger(SIM_BALANCE), seen(SIM_DEDUP_CAPACITY), reporting(false) {}
+
+    OnlineUser user;
+    Ledger ledger;
+    IdempotencyFilter seen;
+    Stream to_server;
+    Stream from_server;
+    deque<PendingReport> reports;
+    bool reporting;      // A TRANSACTION is waiting for its reply
+    SimTime reporting_started;
+};
+
+// Results of one run
+struct RunResult {
+    unsigned long transfers;     // Started within the duration
+    unsigned long rejected;      // Not enough available balance
+    unsigned long credited;
+    unsigned long reported;      // Answered "Transfer OK!"
+    unsigned long duplicates;
+    vector<uint32_t> transfer_latency;  // Start to credited (us)
+    vector<uint32_t> settle_latency;    // Start to report answered (us)
+    SimTime finished;            // Last event
+    SimTime server_busy;
+    size_t max_backlog;          // Longest report queue of a client
+    bool consistent;             // Every client's balance matches the server's
+    unsigned long events;
+    unsigned long segments;
+    unsigned long retransmits;
+    unsigned long long bytes;
+    uint64_t digest;
+};
+
+// Returns: a random transfer ID from the simulation's generator (without the send
+// time new_transfer_id() starts with: simulated receivers only check for duplicates)
+string sim_transfer_id(mt19937& random) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)random();
+    }
+    string text;
+    append_hex(text, bytes, sizeof(bytes));
+    return text;
+}
+
+// Splits line at '#'
+vector<string> split_fields(const string& line) {
+    vector<string> fields;
+    size_t start = 0, pos;
+    while ((pos = line.find('#', start)) != string::npos) {
+        fields.push_back(line.substr(start, pos - start));
+        start = pos + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+}
+
+// Returns: the value below which fraction of the samples lie, in ms
+double percentile_ms(vector<uint32_t>& samples, double fraction) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t k = min(samples.size() - 1, (size_t)(fraction * samples.size()));
+    nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return samples[k] / 1000.0;
+}
+
+/*
+ * Simulate
+ * One run at rate transfers per client per second
+ */
+RunResult simulate(double rate) {
+    RunResult result = RunResult();
+    mt19937 random(seed);
+    EventQueue events;
+    SimNetwork network(events, num_nodes + 1, random);
+    const int server = num_nodes;
+    const SimTime end = (SimTime)(duration_s * 1000000);
+
+    // Everyone is logged in; the directory comes from one List reply, as at login
+    string list = to_string(SIM_BALANCE) + CRLF + "SIM-PUBLIC-KEY" + CRLF + to_string(num_nodes) + CRLF;
+    vector<unique_ptr<SimClient> > clients;
+    for (int i = 0; i < num_nodes; i++) {
+        clients.push_back(unique_ptr<SimClient>(new SimClient()));
+        SimClient& client = *clients.back();
+        client.user.username = "user" + to_string(i);
+        client.user.ip = "10." + to_string(i / 65536 % 256) + "." + to_string(i / 256 % 256) + "." + to_string(i % 256);
+        client.user.port = SIM_BASE_PORT + i;
+        list += client.user.username + "#" + client.user.ip + "#" + to_string(client.user.port) + CRLF;
+    }
+    Directory directory;
+    directory.replace(parse_list_reply(list).users);
+
+    unordered_map<string, int> balances;  // The server's
+    for (const unique_ptr<SimClient>& client : clients) {
+        balances[client->user.username] = SIM_BALANCE;
+    }
+    SimTime server_free = 0;
+
+    function<void(int)> pump_reports;
+    function<void(int)> next_transfer;
+
+    // Server: one request at a time, in arrival order
+    auto server_receive = [&](int from, const string& request) {
+        SimTime start = max(events.now(), server_free);
+        server_free = start + (SimTime)server_us;
+        result.server_busy += (SimTime)server_us;
+        events.at(server_free, [&, from, request]() {
+            vector<string> fields = split_fields(request.substr(0, request.find_first_of(CRLF)));
+            string reply = "Transfer FAIL!" CRLF;
+            if (fields.size() == 4 && fields[0] == "TRANSACTION") {
+                int amount = atoi(fields[3].c_str());
+                balances[fields[1]] -= amount;
+                balances[fields[2]] += amount;
+                reply = "Transfer OK!" CRLF;
+            }
+            SimClient& client = *clients[from];
+            network.send(server, from, client.from_server, reply, [&, from](const string& response) {
+                SimClient& reporter = *clients[from];
+                if (response.compare(0, 11, "Transfer OK") == 0) {
+                    result.reported++;
+                    result.settle_latency.push_back((uint32_t)(events.now() - reporter.reporting_started));
+                }
+                reporter.reporting = false;
+                pump_reports(from);
+            });
+        });
+    };
+
+    // Sends the client's next TRANSACTION once the previous one was answered
+    pump_reports = [&](int index) {
+        SimClient& client = *clients[index];
+        if (client.reporting || client.reports.empty()) {
+            return;
+        }
+        PendingReport report = client.reports.front();
+        client.reports.pop_front();
+        client.reporting = true;
+        client.reporting_started = report.started;
+        network.send(index, server, client.to_server, report.message,
+                     [&, index](const string& request) { server_receive(index, request); });
+    };
+
+    // Recipient side: what PaymentClient::handle_transfer_frames() does per frame
+    auto receive_transfer = [&](int index, const string& message, SimTime started) {
+        SimClient& client = *clients[index];
+        TransferFrame frame;
+        if (!parse_transfer_frame(message, frame) || frame.recipient != client.user.username) {
+            return;
+        }
+        if (!client.seen.insert(frame.sender, frame.transfer_id)) {
+            result.duplicates++;
+            return;
+        }
+        client.ledger.credit(frame.amount);
+        result.credited++;
+        result.transfer_latency.push_back((uint32_t)(events.now() - started));
+        PendingReport report = { make_transaction_message(frame.sender, frame.recipient, frame.amount_str), started };
+        client.reports.push_back(report);
+        result.max_backlog = max(result.max_backlog, client.reports.size());
+        pump_reports(index);
+    };
+
+    // Sender side: reserve, connect, send, commit, like PaymentClient::send_transfer()
+    exponential_distribution<double> gap(rate > 0 ? rate : 1);
+    uniform_int_distribution<int> pick_peer(0, num_nodes - 2);
+    uniform_int_distribution<int> pick_amount(1, 10);
+    next_transfer = [&](int index) {
+        SimClient& client = *clients[index];
+        int peer = pick_peer(random);
+        peer += peer >= index ? 1 : 0;
+        int amount = pick_amount(random);
+        SimTime following = events.now() + (SimTime)(gap(random) * 1000000);
+        if (following < end) {
+            events.at(following, [&, index]() { next_transfer(index); });
+        }
+
+        result.transfers++;
+        OnlineUser recipient;
+        unsigned long since = client.ledger.version();
+        if (!directory.find("user" + to_string(peer), recipient) || !client.ledger.reserve(amount)) {
+            result.rejected++;
+            return;
+        }
+        int host = recipient.port - SIM_BASE_PORT;
+        string message = make_transfer_message(client.user.username, amount, recipient.username,
+                                               sim_transfer_id(random));
+        SimTime started = events.now();
+        network.connect(index, host, [&, index, host, amount, since, message, started]() {
+            shared_ptr<Stream> stream(new Stream());
+            network.send(index, host, *stream, message, [&, host, started, stream](const string& data) {
+                receive_transfer(host, data, started);
+            });
+            clients[index]->ledger.commit(amount, since);
+        });
+    };
+
+    for (int i = 0; i < num_nodes && rate > 0; i++) {
+        events.at((SimTime)(gap(random) * 1000000), [&, i]() { next_transfer(i); });
+    }
+    events.run();
+
+    result.finished = events.now();
+    result.consistent = true;
+    for (const unique_ptr<SimClient>& client : clients) {
+        result.consistent = result.consistent && client->ledger.balance() == balances[client->user.username];
+    }
+    result.events = events.events();
+    result.segments = network.segments_sent();
+    result.retransmits = network.segments_retransmitted();
+    result.bytes = network.bytes_sent();
+    result.digest = network.trace_digest();
+    return result;
+}
+
+// Parses a comma-separated list of rates
+bool parse_rates(const string& text) {
+    rates.clear();
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        double rate = atof(item.c_str());
+        if (rate <= 0) {
+            return false;
+        }
+        rates.push_back(rate);
+    }
+    return !rates.empty();
+}
+
+int main(int argc, char* argv[]) {
+    bool valid = true;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--nodes") {
+            num_nodes = atoi(argv[i + 1]);
+        } else if (arg == "--rate") {
+            valid = parse_rates(argv[i + 1]) && valid;
+        } else if (arg == "--duration") {
+            duration_s = atof(argv[i + 1]);
+        } else if (arg == "--rtt") {
+            rtt_ms = atof(argv[i + 1]);
+        } else if (arg == "--jitter") {
+            jitter_ms = atof(argv[i + 1]);
+        } else if (arg == "--bandwidth") {
+            bandwidth_mbit = atof(argv[i + 1]);
+        } else if (arg == "--loss") {
+            loss = atof(argv[i + 1]);
+        } else if (arg == "--server-us") {
+            server_us = atof(argv[i + 1]);
+        } else if (arg == "--seed") {
+            seed = (unsigned int)strtoul(argv[i + 1], NULL, 10);
+        } else {
+            cout << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+    if (rates.empty()) {
+        rates.push_back(1.0);
+    }
+    if (!valid || num_nodes < 2 || duration_s <= 0 || rtt_ms < 0 || jitter_ms < 0 || bandwidth_mbit <= 0 ||
+        loss < 0 || loss >= 1 || server_us < 0) {
+        cout << "Usage: " << argv[0] << " [--nodes N] [--rate R[,R...]] [--duration S] [--rtt MS] [--jitter MS]"
+             << " [--bandwidth MBIT] [--loss P] [--server-us US] [--seed S]" << endl;
+        return 1;
+    }
+
+    cout << "Simulating " << num_nodes << " clients for " << duration_s << " s: RTT " << rtt_ms << " ms";
+    if (jitter_ms > 0) {
+        cout << " (+0-" << jitter_ms << " ms jitter each way)";
+    }
+    cout << ", " << bandwidth_mbit << " Mbit/s links, " << loss * 100 << "% loss, server " << server_us
+         << " us per request, seed " << seed << endl;
+    cout << setw(9) << "Rate/s" << setw(12) << "Transfers/s" << setw(11) << "Reports/s" << setw(10) << "p50 ms"
+         << setw(10) << "p99 ms" << setw(12) << "Settle p50" << setw(12) << "Settle p99" << setw(9) << "Server"
+         << setw(9) << "Backlog" << setw(10) << "Events" << setw(9) << "Wall ms" << endl;
+
+    vector<RunResult> results;
+    for (double rate : rates) {
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        RunResult result = simulate(rate);
+        long long wall_ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started).count();
+        double elapsed = max(result.finished / 1e6, duration_s);
+        cout << setw(9) << rate << fixed << setprecision(0) << setw(12) << result.credited / duration_s << setw(11)
+             << result.reported / elapsed << setprecision(2) << setw(10)
+             << percentile_ms(result.transfer_latency, 0.50) << setw(10)
+             << percentile_ms(result.transfer_latency, 0.99) << setw(12) << percentile_ms(result.settle_latency, 0.50)
+             << setw(12) << percentile_ms(result.settle_latency, 0.99) << setprecision(0) << setw(8)
+             << 100.0 * result.server_busy / max(result.finished, (SimTime)1) << "%" << setw(9) << result.max_backlog
+             << setw(10) << result.events << setw(9) << wall_ms << endl;
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+        results.push_back(result);
+    }
+
+    cout << endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const RunResult& result = results[i];
+        cout << "Rate " << rates[i] << ": " << result.transfers << " transfers (" << result.rejected << " rejected, "
+             << result.duplicates << " duplicates), " << result.segments << " segments (" << result.retransmits
+             << " retransmitted), " << result.bytes << " bytes, done at " << result.finished / 1e6 << " s, balances "
+             << (result.consistent ? "match the server" : "DO NOT match the server") << ", trace digest " << hex
+             << setw(16) << setfill('0') << result.digest << dec << setfill(' ') << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * P2P Micropayment System - Client Library (libp2ppay.a)
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Umbrella header for programs that embed the payment client:
+ * - protocol.h        message encoding/decoding
+ * - net.h             blocking socket helpers
+ * - socket_profile.h  TCP options applied to every socket
+ * - datagram.h        acknowledged, batched UDP transport for transfer frames
+ * - gossip.h          peer-to-peer gossip of the online user directory
+ * - io_backend.h      poll/epoll/io_uring socket I/O
+ * - intern.h          username -> UserId intern table
+ * - endpoint.h        peer addresses ready for connect()
+ * - resolver.h        cached background hostname resolution
+ * - directory.h       online user directory
+ * - ledger.h          balance ledger
+ * - session.h         persistent server connection and TRANSACTION reporting
+ * - listener.h        P2P listener (single thread or SO_REUSEPORT shards)
+ * - worker_pool.h     thread pool for splitting a batch of work
+ * - secure_frame.h    optional encryption of P2P transfer frames
+ * - signing.h         optional Ed25519 signatures on P2P transfer frames
+ * - idempotency.h     transfer IDs and duplicate transfer detection
+ * - settlement.h      bulk / netted TRANSACTION reports
+ * - capture.h         binary log of every message sent and received, for replay
+ * - payment_client.h  all of the above behind one object
+ */
+
+#ifndef P2PPAY_H
+#define P2PPAY_H
+
+#include "protocol.h"
+#include "net.h"
+#include "socket_profile.h"
+#include "datagram.h"
+#include "gossip.h"
+#include "io_backend.h"
+#include "intern.h"
+#include "endpoint.h"
+#include "resolver.h"
+#include "directory.h"
+#include "ledger.h"
+#include "session.h"
+#include "listener.h"
+#include "worker_pool.h"
+#include "secure_frame.h"
+#include "signing.h"
+#include "idempotency.h"
+#include "settlement.h"
+#include "capture.h"
+#include "payment_client.h"
+
+#endif
@@ -0,0 +1,789 @@
+/*
+ * P2P Micropayment System - Payment Client
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "payment_client.h"
+#include "net.h"
+
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <climits>
+#include <unistd.h>
+
+using namespace std;
+
+PaymentClient::PaymentClient()
+    : self_id(NO_USER), listen_port(0), cipher_suite(CIPHER_AES_256_GCM), local_transport(true),
+      transfer_ids(false), transfer_retries(TRANSFER_RETRIES), heartbeat_interval(HEARTBEAT_INTERVAL),
+      gossip_interval(0), gossip_fanout(GOSSIP_FANOUT), is_logged_in(false) {}
+
+PaymentClient::~PaymentClient() {
+    shutdown();
+}
+
+bool PaymentClient::connect(const string& server_ip, int server_port, const string& io_backend) {
+    session.set_log([this](const string& text) { log(text); });
+    if (!session.connect(server_ip, server_port, io_backend)) {
+        return false;
+    }
+    session.start_reporter([this](const string& report, const string& response) {
+        if (on_report) {
+            on_report(report, response);
+        }
+    });
+    return true;
+}
+
+bool PaymentClient::start_listener(int port, int shards, const string& io_backend) {
+    listen_port = port;
+    listener.set_local_transport(local_transport);
+    listener.set_datagrams(datagram_sender.started());
+    return listener.start(port, shards, io_backend,
+                          [this](const string* frames, size_t count) { return handle_transfer_frames(frames, count); },
+                          [this](const string& text) { log(text); });
+}
+
+bool PaymentClient::enable_encryption(const string& key_file, CipherSuite suite, string& error) {
+    if (!frame_key.load_file(key_file, error)) {
+        return false;
+    }
+    cipher_suite = suite;
+    return true;
+}
+
+bool PaymentClient::enable_signing(const string& key_file, string& error) {
+    return signing_key.load_file(key_file, error);
+}
+
+bool PaymentClient::require_signatures(const string& key_dir, int verify_threads, string& error) {
+    if (!trusted_keys.load_dir(key_dir, error)) {
+        return false;
+    }
+    if (verify_threads < 0) {
+        unsigned int cores = thread::hardware_concurrency();
+        verify_threads = cores > 1 ? cores - 1 : 0;
+    }
+    verify_pool.start(verify_threads);
+    return true;
+}
+
+bool PaymentClient::enable_settlement(SettlementMode mode, int window_ms, long long threshold, const string& journal,
+                                      string& error) {
+    if (!journal.empty() && !settlement.open_journal(journal, error)) {
+        return false;
+    }
+    settlement.start(mode, window_ms, threshold, [this](const string& report) {
+        if (is_logged_in && !session.closed()) {
+            session.enqueue_report(report);
+        } else {
+            log("Warning: Not logged in, settlement not reported to server");
+        }
+    });
+    return true;
+}
+
+bool PaymentClient::enable_capture(const string& path, string& error) {
+    if (!capture.open(path, error)) {
+        return false;
+    }
+    session.set_capture(&capture);
+    return true;
+}
+
+void PaymentClient::configure_duplicate_filter(size_t capacity, int window_seconds) {
+    seen_transfers.reset(capacity, window_seconds);
+}
+
+void PaymentClient::log(const string& text) {
+    if (on_log) {
+        on_log(text);
+    }
+}
+
+void PaymentClient::apply(const ListReply& reply) {
+    ledger.set_balance(reply.balance);
+    public_key = reply.public_key;
+    directory.replace(reply.users);
+}
+
+/*
+ * Register
+ * Protocol: REGISTER#<username>#<amount>\r\n
+ * Response: 100 OK\r\n (success) or 210 FAIL\r\n (failure)
+ */
+RequestStatus PaymentClient::register_user(const string& name, int amount, string* out) {
+    string response;
+    if (!session.request(make_register_message(name, amount), response)) {
+        return REQUEST_SEND_FAILED;
+    }
+    if (out != NULL) {
+        *out = response;
+    }
+    if (response.empty()) {
+        return REQUEST_NO_RESPONSE;
+    }
+    if (response.find("100 OK") != string::npos) {
+        return REQUEST_OK;
+    }
+    if (response.find("210 FAIL") != string::npos) {
+        return REQUEST_REJECTED;
+    }
+    return REQUEST_UNEXPECTED;
+}
+
+/*
+ * Login
+ * Protocol: <username>#<port>\r\n
+ * Response: balance, public key and online user list (see parse_list_reply)
+ */
+RequestStatus PaymentClient::login(const string& name, ListReply* out) {
+    string response;
+    if (!session.request(make_login_message(name, listen_port), response)) {
+        return REQUEST_SEND_FAILED;
+    }
+    if (response.empty()) {
+        return REQUEST_NO_RESPONSE;
+    }
+    if (response.find("220 AUTH_FAIL") != string::npos) {
+        return REQUEST_REJECTED;
+    }
+
+    ListReply reply = parse_list_reply(response);
+    apply(reply);
+    user = name;
+    self_id = user_names().intern(name);
+    is_logged_in = true;
+    if (out != NULL) {
+        *out = reply;
+    }
+
+    // After a reconnect the session logs in again by itself
+    session.set_resume(make_login_message(name, listen_port),
+                       [this](const string& answer) { return resume(answer); });
+    session.set_heartbeat(make_list_message(), heartbeat_interval);
+
+    if (gossip_interval > 0 && !gossip_agent.running()) {
+        // Others dial us at the address the server lists for us
+        vector<OnlineUser>::const_iterator me =
+            find_if(reply.users.begin(), reply.users.end(),
+                    [&name](const OnlineUser& listed) { return listed.username == name; });
+        if (me == reply.users.end()) {
+            log("Warning: Not listed in the login reply, gossip is off");
+        } else {
+            uint64_t version = chrono::duration_cast<chrono::milliseconds>(
+                                   chrono::system_clock::now().time_since_epoch()).count();
+            gossip_agent.start(
+                *me, version, reply.users, gossip_interval, gossip_fanout,
+                [this](const string& peer, const string& message) { return send_gossip(peer, message); },
+                [this](const GossipEntry& entry) { apply_gossip(entry); });
+        }
+    }
+    return REQUEST_OK;
+}
+
+/*
+ * Resume
+ * Checks the answer to the login the session repeated after reconnecting.
+ * Runs on the reporter thread, so only the thread-safe ledger and directory
+ * are updated.
+ * Returns: false if the server refused the login
+ */
+bool PaymentClient::resume(const string& response) {
+    if (response.find("220 AUTH_FAIL") != string::npos) {
+        log("Warning: Server refused the login after reconnecting");
+        return false;
+    }
+    ListReply reply = parse_list_reply(response);
+    ledger.set_balance(reply.balance);
+    directory.replace(reply.users);
+    return true;
+}
+
+/*
+ * Refresh
+ * Protocol: List\r\n
+ * Response: Same format as login response
+ */
+RequestStatus PaymentClient::refresh(ListReply* out) {
+    string response;
+    if (!session.request(make_list_message(), response)) {
+        return REQUEST_SEND_FAILED;
+    }
+    if (response.empty()) {
+        return REQUEST_NO_RESPONSE;
+    }
+
+    ListReply reply = parse_list_reply(response);
+    apply(reply);
+    if (out != NULL) {
+        *out = reply;
+    }
+    return REQUEST_OK;
+}
+
+/*
+ * Subscribe
+ * Protocol: SUBSCRIBE\r\n
+ * Response: same format as login response (the snapshot the events build
+ * on), then EVENT#... lines whenever the online list or our balance changes.
+ * Servers without subscriptions answer 230 Input format error.
+ */
+bool PaymentClient::subscribe_updates() {
+    if (!is_logged_in) {
+        return false;
+    }
+    return session.subscribe(
+        make_subscribe_message(), EVENT_PREFIX,
+        [this](const string& answer) {
+            if (!is_list_reply(answer)) {
+                return false;
+            }
+            ListReply reply = parse_list_reply(answer);
+            ledger.set_balance(reply.balance);
+            directory.replace(reply.users);
+            return true;
+        },
+        [this](const string& line) { apply_event(line); });
+}
+
+/*
+ * Apply Event
+ * Runs on the session's reader thread, so like resume() it only touches the
+ * thread-safe ledger and directory.
+ */
+void PaymentClient::apply_event(const string& line) {
+    DirectoryEvent event;
+    if (!parse_event(line, event)) {
+        log("Warning: Ignoring malformed event from server");
+        return;
+    }
+    switch (event.type) {
+    case EVENT_JOIN:
+        directory.add(event.user);
+        break;
+    case EVENT_LEAVE:
+        directory.remove(event.user.username);
+        break;
+    case EVENT_BALANCE:
+        ledger.set_balance(event.balance);
+        break;
+    }
+    if (on_directory_event) {
+        on_directory_event(event);
+    }
+}
+
+/*
+ * Send Gossip
+ * Delivers one gossip message like a transfer frame, sealed if transfers
+ * are, but without retries: the next round makes up for a lost one.
+ */
+bool PaymentClient::send_gossip(const string& username, const string& message) {
+    UserId id = user_names().find(username);
+    PeerEndpoint endpoint;
+    if (id == NO_USER || !directory.find(id, endpoint)) {
+        return false;
+    }
+    string sealed;
+    if (frame_key.loaded()) {
+        FrameSealer sealer(frame_key, cipher_suite);
+        if (!sealer.seal(message, sealed)) {
+            return false;
+        }
+    }
+    int peer_sock = local_transport && endpoint_is_local(endpoint) ? connect_local(endpoint_port(endpoint)) : -1;
+    if (peer_sock == -1) {
+        peer_sock =
+            connect_to_address(endpoint_sockaddr(endpoint), endpoint_length(endpoint), GOSSIP_CONNECT_TIMEOUT_MS);
+    }
+    if (peer_sock == -1) {
+        return false;
+    }
+    const string& frame = frame_key.loaded() ? sealed : message;
+    bool sent = send_message(peer_sock, frame);
+    close(peer_sock);
+    if (sent) {
+        capture.record(CAPTURE_P2P, CAPTURE_OUT, frame);
+    }
+    return sent;
+}
+
+/*
+ * Apply Gossip
+ * Runs on a listener thread; reported like a pushed event.
+ */
+void PaymentClient::apply_gossip(const GossipEntry& entry) {
+    DirectoryEvent event;
+    event.user = entry.user;
+    event.balance = 0;
+    bool news;
+    if (entry.online) {
+        // A newer version of a user we already list at that address is no news to show
+        OnlineUser known;
+        news = !directory.find(entry.user.username, known) || known.ip != entry.user.ip ||
+               known.port != entry.user.port;
+        event.type = EVENT_JOIN;
+        directory.add(entry.user);
+    } else {
+        event.type = EVENT_LEAVE;
+        news = directory.remove(entry.user.username);
+    }
+    if (news && on_directory_event) {
+        on_directory_event(event);
+    }
+}
+
+/*
+ * Send Transfer (P2P)
+ * Transfers money directly to another client without going through server.
+ * Protocol: <sender>#<amount>#<recipient>\r\n, with #<transfer_id> before the
+ * line ending if transfer IDs are enabled
+ */
+TransferStatus PaymentClient::send_transfer(const string& recipient, int amount, string* transfer_id) {
+    UserId id = user_names().find(recipient);
+    if (id == NO_USER && is_logged_in) {
+        return TRANSFER_UNKNOWN_RECIPIENT;
+    }
+    return send_transfer(id, amount, transfer_id);
+}
+
+TransferStatus PaymentClient::send_transfer(UserId recipient, int amount, string* transfer_id) {
+    if (!is_logged_in) {
+        return TRANSFER_NOT_LOGGED_IN;
+    }
+    PeerEndpoint endpoint;
+    if (recipient == NO_USER || !directory.find(recipient, endpoint)) {
+        return TRANSFER_UNKNOWN_RECIPIENT;
+    }
+    if (amount <= 0) {
+        return TRANSFER_INVALID_AMOUNT;
+    }
+    if (!ledger.reserve(amount)) {
+        return TRANSFER_INSUFFICIENT_BALANCE;
+    }
+    unsigned long version = ledger.version();
+    TransferStatus status = dispatch_transfer(recipient, endpoint, amount, transfer_id);
+    if (status == TRANSFER_OK) {
+        ledger.commit(amount, version);
+    } else {
+        ledger.release(amount);
+    }
+    return status;
+}
+
+/*
+ * Dispatch Transfer
+ * Builds, signs and seals the frame and delivers it; the amount is already
+ * reserved by the caller.
+ */
+TransferStatus PaymentClient::dispatch_transfer(UserId recipient, const PeerEndpoint& endpoint, int amount,
+                                                string* transfer_id) {
+    // A retry of an earlier transfer keeps its ID, so the recipient drops the copy
+    string id;
+    if (transfer_ids_enabled()) {
+        id = transfer_id != NULL && !transfer_id->empty() ? *transfer_id : new_transfer_id();
+    }
+    if (transfer_id != NULL) {
+        *transfer_id = id;
+    }
+    string message = id.empty() ? make_transfer_message(user, amount, user_names().name(recipient))
+                                : make_transfer_message(user, amount, user_names().name(recipient), id);
+    if (signing_key.loaded()) {
+        string signature;
+        if (!signing_key.sign(message.data(), transfer_signed_length(message), signature)) {
+            return TRANSFER_SIGN_FAILED;
+        }
+        append_transfer_signature(message, signature);
+    }
+    if (frame_key.loaded()) {
+        // One connection key per connection (see secure_frame.h)
+        FrameSealer sealer(frame_key, cipher_suite);
+        string sealed;
+        if (!sealer.seal(message, sealed)) {
+            return TRANSFER_ENCRYPT_FAILED;
+        }
+        message.swap(sealed);
+    }
+
+    // Datagram first if enabled; it retransmits by itself, and a peer that
+    // never acknowledges gets the same frame over TCP below
+    if (datagram_sender.started() && endpoint.addr.sa.sa_family == AF_INET &&
+        datagram_sender.send(endpoint.addr.v4, message)) {
+        capture.record(CAPTURE_P2P, CAPTURE_OUT, message);
+        if (settlement.enabled()) {
+            settlement.record_outgoing(user, user_names().name(recipient), amount, id);
+        }
+        return TRANSFER_OK;
+    }
+
+    // P2P Connection: Connect directly to recipient's client, over its local
+    // socket if it runs on this host. The frame may arrive even when send()
+    // reports an error, which is why retries are only safe with the transfer ID.
+    bool local = local_transport && endpoint_is_local(endpoint);
+    TransferStatus status = TRANSFER_CONNECT_FAILED;
+    int delay_ms = TRANSFER_RETRY_DELAY_MS;
+    for (int attempt = 0; attempt <= transfer_retries; attempt++) {
+        if (attempt > 0) {
+            this_thread::sleep_for(chrono::milliseconds(delay_ms));
+            delay_ms *= 2;
+        }
+        int peer_sock = local ? connect_local(endpoint_port(endpoint)) : -1;
+        if (peer_sock == -1) {
+            peer_sock = connect_to_address(endpoint_sockaddr(endpoint), endpoint_length(endpoint));
+        }
+        if (peer_sock == -1) {
+            status = TRANSFER_CONNECT_FAILED;
+            continue;
+        }
+        bool sent = send_message(peer_sock, message);
+        close(peer_sock);  // Close P2P connection after sending
+        if (sent) {
+            capture.record(CAPTURE_P2P, CAPTURE_OUT, message);
+            if (settlement.enabled()) {
+                settlement.record_outgoing(user, user_names().name(recipient), amount, id);
+            }
+            return TRANSFER_OK;
+        }
+        status = TRANSFER_SEND_FAILED;
+        if (id.empty()) {
+            break;  // Part of the frame may have arrived, and a copy could not be told apart
+        }
+    }
+    return status;
+}
+
+/*
+ * Dispatch Parallel
+ * Runs send(i) for i in [0, count) on at most concurrency threads (0 = every
+ * send thread). Every thread takes the next index when it is done with one,
+ * so a slow peer only holds up its own thread.
+ */
+void PaymentClient::dispatch_parallel(size_t count, size_t concurrency, const function<void(size_t)>& send) {
+    size_t threads = send_pool.workers() + 1;
+    if (concurrency > 0 && concurrency < threads) {
+        threads = concurrency;
+    }
+    atomic<size_t> next(0);
+    send_pool.parallel_for(threads < count ? threads : count, 1, [&](size_t, size_t) {
+        for (size_t i = next++; i < count; i = next++) {
+            send(i);
+        }
+    });
+}
+
+size_t PaymentClient::send_transfers(const vector<TransferRequest>& requests, vector<TransferResult>& results,
+                                     size_t concurrency) {
+    results.resize(requests.size());
+    atomic<size_t> sent(0);
+    dispatch_parallel(requests.size(), concurrency, [&](size_t i) {
+        results[i].transfer_id.clear();
+        results[i].status = send_transfer(requests[i].recipient, requests[i].amount, &results[i].transfer_id);
+        if (results[i].status == TRANSFER_OK) {
+            sent++;
+        }
+    });
+    return sent;
+}
+
+/*
+ * Send Split
+ * Resolves every payee against the directory once, reserves the total in
+ * one step, then dials the payees in parallel. Each transfer commits or
+ * releases its own part of the reservation, against the ledger version read
+ * just before it is sent: a server balance that arrives after one payee was
+ * paid cannot include the payees dialed later.
+ */
+size_t PaymentClient::send_split(const vector<TransferRequest>& payees, vector<TransferResult>& results,
+                                 size_t concurrency) {
+    results.resize(payees.size());
+    vector<UserId> ids(payees.size(), NO_USER);
+    vector<PeerEndpoint> endpoints(payees.size());
+    long long total = 0;
+    for (size_t i = 0; i < payees.size(); i++) {
+        TransferResult& result = results[i];
+        result.transfer_id.clear();
+        result.status = TRANSFER_OK;
+        if (!is_logged_in) {
+            result.status = TRANSFER_NOT_LOGGED_IN;
+        } else if (payees[i].amount <= 0) {
+            result.status = TRANSFER_INVALID_AMOUNT;
+        } else {
+            ids[i] = user_names().find(payees[i].recipient);
+            if (ids[i] == NO_USER || !directory.find(ids[i], endpoints[i])) {
+                result.status = TRANSFER_UNKNOWN_RECIPIENT;
+            }
+        }
+        if (result.status == TRANSFER_OK) {
+            total += payees[i].amount;
+        }
+    }
+
+    // All or nothing: a balance that cannot cover every payee pays none of them
+    if (total > INT_MAX || !ledger.reserve((int)total)) {
+        for (TransferResult& result : results) {
+            if (result.status == TRANSFER_OK) {
+                result.status = TRANSFER_INSUFFICIENT_BALANCE;
+            }
+        }
+        return 0;
+    }
+
+    atomic<size_t> sent(0);
+    dispatch_parallel(payees.size(), concurrency, [&](size_t i) {
+        if (results[i].status != TRANSFER_OK) {
+            return;
+        }
+        int amount = payees[i].amount;
+        unsigned long version = ledger.version();
+        results[i].status = dispatch_transfer(ids[i], endpoints[i], amount, &results[i].transfer_id);
+        if (results[i].status == TRANSFER_OK) {
+            ledger.commit(amount, version);
+            sent++;
+        } else {
+            ledger.release(amount);
+        }
+    });
+    return sent;
+}
+
+bool split_by_shares(int total, const vector<int>& shares, vector<int>& amounts) {
+    long long share_sum = 0;
+    for (int share : shares) {
+        if (share <= 0) {
+            return false;
+        }
+        share_sum += share;
+    }
+    if (total <= 0 || share_sum == 0) {
+        return false;
+    }
+
+    // Largest remainder: round every part down, then hand the leftover units
+    // to the parts that lost the most, so the parts add up to total exactly
+    amounts.resize(shares.size());
+    vector<pair<long long, size_t> > remainders(shares.size());
+    long long assigned = 0;
+    for (size_t i = 0; i < shares.size(); i++) {
+        long long product = (long long)total * shares[i];
+        amounts[i] = (int)(product / share_sum);
+        remainders[i] = make_pair(product % share_sum, i);
+        assigned += amounts[i];
+    }
+    sort(remainders.begin(), remainders.end(),
+         [](const pair<long long, size_t>& a, const pair<long long, size_t>& b) {
+             return a.first > b.first || (a.first == b.first && a.second < b.second);
+         });
+    for (size_t i = 0; assigned < total; i++, assigned++) {
+        amounts[remainders[i].second]++;
+    }
+    return true;
+}
+
+/*
+ * Logout
+ * Protocol: Exit\r\n
+ * Response: Bye\r\n
+ */
+bool PaymentClient::logout() {
+    bool bye = false;
+    session.set_heartbeat("", 0);
+    session.set_resume("", NULL);
+    if (gossip_agent.stop()) {
+        log("Gossip: " + to_string(gossip_agent.messages_sent()) + " messages sent (" +
+            to_string(gossip_agent.bytes_sent()) + " bytes) in " + to_string(gossip_agent.rounds()) + " rounds, " +
+            to_string(gossip_agent.messages_received()) + " received" +
+            (gossip_agent.users_skipped() + gossip_agent.self_overrides() > 0
+                 ? ", " + to_string(gossip_agent.users_skipped()) + " new users skipped, " +
+                       to_string(gossip_agent.self_overrides()) + " entries for us overridden"
+                 : string("")));
+    }
+    if (is_logged_in) {
+        string response;
+        if (session.request_and_close(make_exit_message(), response)) {
+            bye = response.find("Bye") != string::npos;
+        }
+    }
+    session.close();
+    is_logged_in = false;
+    return bye;
+}
+
+/*
+ * Shutdown
+ * The listener goes first: the transfers it drains still queue reports.
+ * Settlement then turns its open positions into reports, and the reporter
+ * gets whatever time is left over.
+ */
+ShutdownReport PaymentClient::shutdown(int timeout_ms) {
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    ShutdownReport report;
+    report.connections_cut = listener.stop(timeout_ms);
+    verify_pool.stop();
+    send_pool.stop();
+    if (datagram_sender.stop() && datagram_sender.datagrams_sent() > 0) {
+        log("Datagrams: " + to_string(datagram_sender.frames_sent()) + " transfers in " +
+            to_string(datagram_sender.datagrams_sent()) + " datagrams (" +
+            to_string(datagram_sender.retransmits()) + " retransmitted), " +
+            to_string(datagram_sender.frames_failed()) + " sent over TCP instead");
+    }
+    if (settlement.stop()) {
+        log("Settlement: " + to_string(settlement.transfers()) + " transfers reported in " +
+            to_string(settlement.reports()) + " TRANSACTION messages");
+    }
+
+    long long left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+    report.reports_dropped = session.stop_reporter(left > 0 ? (int)left : 0);
+    return report;
+}
+
+/*
+ * Decode Transfer
+ * Decrypts (if sealed) and parses one received frame, and fills in the
+ * signature check when signatures are required. plaintext keeps the
+ * decrypted frame alive for the check.
+ * Returns: false if the frame is dropped (a warning has been logged)
+ */
+bool PaymentClient::decode_transfer(const string& message, string& plaintext, TransferFrame& frame,
+                                    SignatureCheck& check) {
+    const string* text = &message;
+    if (is_sealed_frame(message)) {
+        if (!open_sealed_frame(frame_key, message, plaintext)) {
+            log("Warning: Dropped encrypted transfer that could not be decrypted");
+            return false;
+        }
+        text = &plaintext;
+    } else if (frame_key.loaded()) {
+        log("Warning: Dropped unencrypted transfer (encryption is required)");
+        return false;
+    }
+    if (is_gossip_message(*text)) {
+        // Directory gossip shares the P2P port (and its encryption) with transfers
+        gossip_agent.handle_message(*text);
+        return false;
+    }
+    if (!parse_transfer_frame(*text, frame)) {
+        log("Warning: Dropped malformed transfer (missing fields or amount not a positive integer)");
+        return false;
+    }
+
+    // Only transfers to us can be credited and reported as ours
+    if (self_id == NO_USER || user_names().find(frame.recipient) != self_id) {
+        log("Warning: Dropped transfer addressed to " + frame.recipient);
+        return false;
+    }
+
+    // Sealed and signed frames are only safe from replay with a send time to check
+    if ((frame_key.loaded() || trusted_keys.loaded()) && frame.transfer_id.empty()) {
+        log("Warning: Dropped transfer from " + frame.sender + " without a transfer ID");
+        return false;
+    }
+
+    if (trusted_keys.loaded()) {
+        check.public_key = trusted_keys.find(frame.sender);
+        if (check.public_key == NULL) {
+            log("Warning: Dropped transfer from " + frame.sender + " (no trusted key)");
+            return false;
+        }
+        if (!decode_signature(frame.signature, check.signature)) {
+            log("Warning: Dropped unsigned transfer from " + frame.sender);
+            return false;
+        }
+        check.data = text->data();
+        check.length = frame.signed_length;
+        check.valid = false;
+    }
+    return true;
+}
+
+/*
+ * Accept Transfer
+ * Credits the ledger and queues the TRANSACTION report.
+ */
+void PaymentClient::accept_transfer(const TransferFrame& frame) {
+    // Update local balance (optimistic update)
+    int new_balance = ledger.credit(frame.amount);
+    if (on_incoming_transfer) {
+        on_incoming_transfer(frame, new_balance);
+    }
+
+    // Report transaction to server so it can update both accounts. While the
+    // session is reconnecting the report waits in the queue.
+    if (settlement.enabled()) {
+        settlement.record_incoming(frame.recipient, frame.sender, frame.amount, frame.transfer_id);
+    } else if (is_logged_in && !session.closed()) {
+        session.enqueue_report(make_transaction_message(frame.sender, frame.recipient, frame.amount_str));
+    } else {
+        log("Warning: Not logged in, transaction not reported to server");
+    }
+}
+
+/*
+ * Inbound Batch
+ * Per-thread scratch space of handle_transfer_frames(). The vectors and the
+ * strings in them are reused from batch to batch.
+ */
+struct InboundBatch {
+    vector<TransferFrame> frames;
+    vector<string> plaintexts;      // Decrypted frames; signature checks point into them
+    vector<SignatureCheck> checks;
+};
+
+/*
+ * Handle Transfer Frames
+ * Decodes a batch of transfer frames, verifies their signatures together,
+ * drops duplicates, then updates the local balance and queues a report to
+ * the server for each one accepted.
+ * Protocol: <sender>#<amount>#<recipient>[#<transfer_id>[#<signature>]]\r\n, or an ENC1 line sealing it
+ */
+size_t PaymentClient::handle_transfer_frames(const string* messages, size_t count) {
+    static thread_local InboundBatch batch;
+    if (batch.frames.size() < count) {
+        // Sized before decoding: checks keep pointers into plaintexts
+        batch.frames.resize(count);
+        batch.plaintexts.resize(count);
+        batch.checks.resize(count);
+    }
+
+    size_t decoded = 0;
+    for (size_t i = 0; i < count; i++) {
+        capture.record(CAPTURE_P2P, CAPTURE_IN, messages[i]);
+        if (decode_transfer(messages[i], batch.plaintexts[decoded], batch.frames[decoded], batch.checks[decoded])) {
+            decoded++;
+        }
+    }
+
+    bool verify = trusted_keys.loaded();
+    if (verify) {
+        verify_signatures(&batch.checks[0], decoded, verify_pool);
+    }
+
+    size_t accepted = 0;
+    for (size_t i = 0; i < decoded; i++) {
+        const TransferFrame& frame = batch.frames[i];
+        if (verify && !batch.checks[i].valid) {
+            log("Warning: Dropped transfer from " + frame.sender + " with an invalid signature");
+            continue;
+        }
+        // Checked after the signature, so forged frames cannot fill the filter.
+        // Old-style frames without an ID cannot be told apart and are all accepted.
+        if (!frame.transfer_id.empty() && !seen_transfers.fresh(frame.transfer_id)) {
+            log("Warning: Dropped transfer " + frame.transfer_id + " from " + frame.sender +
+                " (send time missing or outside the " + to_string(seen_transfers.window()) + " s dedup window)");
+            continue;
+        }
+        if (!frame.transfer_id.empty() && !seen_transfers.insert(frame.sender, frame.transfer_id)) {
+            log("Warning: Dropped duplicate transfer " + frame.transfer_id + " from " + frame.sender);
+            continue;
+        }
+        accept_transfer(frame);
+        accepted++;
+    }
+    return accepted;
+}
+
+bool PaymentClient::handle_transfer_frame(const string& message) {
+    return handle_transfer_frames(&message, 1) == 1;
+}
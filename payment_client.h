@@ -0,0 +1,328 @@
+/*
+ * P2P Micropayment System - Payment Client
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Everything a payment node needs, without any console I/O: the server
+ * session, the online user directory, the balance ledger and the P2P
+ * listener. The interactive program (client.cpp) is a thin menu on top of
+ * this class; other programs can embed it and call it in-process.
+ *
+ * Typical use:
+ *     PaymentClient client;
+ *     client.connect("127.0.0.1", 12345);
+ *     client.start_listener(9000);
+ *     client.login("alice");
+ *     client.send_transfer("bob", 100);
+ */
+
+#ifndef PAYMENT_CLIENT_H
+#define PAYMENT_CLIENT_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "protocol.h"
+#include "intern.h"
+#include "directory.h"
+#include "ledger.h"
+#include "session.h"
+#include "listener.h"
+#include "secure_frame.h"
+#include "signing.h"
+#include "idempotency.h"
+#include "settlement.h"
+#include "datagram.h"
+#include "gossip.h"
+#include "capture.h"
+#include "worker_pool.h"
+
+#define TRANSFER_RETRIES 2          // Default extra attempts of a failed transfer
+#define TRANSFER_RETRY_DELAY_MS 50  // Wait before the first retry; doubles each time
+#define SHUTDOWN_TIMEOUT_MS 2000    // Default time shutdown() spends draining transfers and reports
+#define SEND_THREADS 8              // Default threads of send_transfers()
+
+// Outcome of a request to the server
+enum RequestStatus {
+    REQUEST_OK,
+    REQUEST_REJECTED,       // 210 FAIL / 220 AUTH_FAIL
+    REQUEST_SEND_FAILED,    // not connected, or send() failed
+    REQUEST_NO_RESPONSE,    // server closed or did not answer
+    REQUEST_UNEXPECTED      // answer not recognized
+};
+
+// Outcome of an outgoing P2P transfer
+enum TransferStatus {
+    TRANSFER_OK,
+    TRANSFER_NOT_LOGGED_IN,
+    TRANSFER_UNKNOWN_RECIPIENT,   // not in the directory
+    TRANSFER_INVALID_AMOUNT,
+    TRANSFER_INSUFFICIENT_BALANCE,
+    TRANSFER_CONNECT_FAILED,
+    TRANSFER_SIGN_FAILED,
+    TRANSFER_ENCRYPT_FAILED,
+    TRANSFER_SEND_FAILED
+};
+
+// One transfer of a send_transfers() batch
+struct TransferRequest {
+    std::string recipient;
+    int amount;
+};
+
+struct TransferResult {
+    TransferStatus status;
+    std::string transfer_id;
+};
+
+// What shutdown() could not finish before its deadline
+struct ShutdownReport {
+    size_t connections_cut;   // Incoming transfer connections closed while still open (transfers lost)
+    size_t reports_dropped;   // TRANSACTION reports not sent, or sent without an answer
+};
+
+// Splits total into parts proportional to shares that add up to total
+// exactly (largest remainder method).
+// Returns: false if total or a share is not positive
+bool split_by_shares(int total, const std::vector<int>& shares, std::vector<int>& amounts);
+
+class PaymentClient {
+public:
+    // Incoming transfer credited to the ledger
+    typedef std::function<void(const TransferFrame& transfer, int new_balance)> TransferCallback;
+    typedef ServerSession::ReportCallback ReportCallback;
+    typedef Listener::LogCallback LogCallback;
+    // Pushed change applied to the directory or ledger (session reader thread)
+    typedef std::function<void(const DirectoryEvent& event)> DirectoryCallback;
+
+    PaymentClient();
+    ~PaymentClient();
+
+    // Opens the persistent server connection
+    bool connect(const std::string& server_ip, int server_port, const std::string& io_backend = "auto");
+
+    // Starts accepting transfers on port (see listener.h for shards)
+    bool start_listener(int port, int shards = 0, const std::string& io_backend = "auto");
+
+    // Encrypts outgoing transfers with the network key in key_file and
+    // rejects unencrypted incoming ones (see secure_frame.h).
+    // Returns: false (and sets error) if the key cannot be loaded
+    bool enable_encryption(const std::string& key_file, CipherSuite suite, std::string& error);
+    bool encryption_enabled() const { return frame_key.loaded(); }
+
+    // Signs outgoing transfers with the Ed25519 private key in key_file
+    // (see signing.h).
+    // Returns: false (and sets error) if the key cannot be loaded
+    bool enable_signing(const std::string& key_file, std::string& error);
+    bool signing_enabled() const { return signing_key.loaded(); }
+
+    // Only accepts incoming transfers signed by a sender with a key in
+    // key_dir (<username>.pub). Batches of frames are verified on the calling
+    // listener thread plus verify_threads workers (-1 = one per extra core).
+    // Returns: false (and sets error) if the keys cannot be loaded
+    bool require_signatures(const std::string& key_dir, int verify_threads, std::string& error);
+    bool signatures_required() const { return trusted_keys.loaded(); }
+
+    RequestStatus register_user(const std::string& user, int amount, std::string* response = NULL);
+    RequestStatus login(const std::string& user, ListReply* reply = NULL);
+    RequestStatus refresh(ListReply* reply = NULL);  // List: updates ledger and directory
+
+    // Has the server push joins, leaves and balance changes (SUBSCRIBE, see
+    // protocol.h) instead of being polled with List. The session's reader
+    // thread applies them to the directory and ledger as they arrive, and
+    // subscribes again after a reconnect. Call after login().
+    // Returns: false if not logged in or the server does not push (keep
+    //          calling refresh() then)
+    bool subscribe_updates();
+    bool updates_pushed() const { return session.subscribed(); }
+
+    // Keeps the directory current by gossip with the other clients instead
+    // of List (see gossip.h): after login, every interval_ms the changes we
+    // know about go to fanout random online users over their P2P port. The
+    // login reply seeds the table and logout() spreads our departure. Every
+    // client should use it. Call before login(), after enable_encryption():
+    // gossip is only accepted sealed with the network key, so a peer outside
+    // the network cannot rewrite the directory.
+    // Returns: false (and sets error) if encryption is not enabled
+    bool enable_gossip(int interval_ms, int fanout, std::string& error) {
+        if (!frame_key.loaded()) {
+            error = "gossip needs encryption with a network key";
+            return false;
+        }
+        gossip_interval = interval_ms;
+        gossip_fanout = fanout;
+        return true;
+    }
+    bool gossip_enabled() const { return gossip_interval > 0; }
+    const GossipAgent& gossip() const { return gossip_agent; }
+
+    // Connects to the recipient found in the directory and sends the transfer.
+    // A failed connect is retried (see set_transfer_retries()). With transfer
+    // IDs (see set_transfer_ids()) a failed send is retried as well, with the
+    // same ID, so the recipient credits it at most once; pass transfer_id to
+    // learn the ID, or to retry an earlier transfer by passing its ID back
+    // (empty = new transfer). Without IDs transfer_id is left empty.
+    // The amount is reserved in the ledger before dialing, so concurrent
+    // calls never spend more than the balance together; a sent transfer is
+    // debited locally until refresh() brings the server's balance.
+    // Thread-safe.
+    TransferStatus send_transfer(UserId recipient, int amount, std::string* transfer_id = NULL);
+    TransferStatus send_transfer(const std::string& recipient, int amount, std::string* transfer_id = NULL);
+
+    // Sends a batch of transfers concurrently on at most concurrency send
+    // threads (0 = all, see set_send_threads()); results[i] is the outcome of
+    // requests[i]. Each transfer reserves its own amount, so once the balance
+    // is used up the rest fail with TRANSFER_INSUFFICIENT_BALANCE.
+    // Returns: number of transfers sent
+    size_t send_transfers(const std::vector<TransferRequest>& requests, std::vector<TransferResult>& results,
+                          size_t concurrency = 0);
+
+    // Split payment: like send_transfers(), but all payees are resolved
+    // before anything is sent and their total is reserved at once, so either
+    // every valid payee is paid or (balance too low) none is. Unknown
+    // recipients and invalid amounts fail on their own without blocking the
+    // rest. The balance is not refreshed; call refresh() once afterwards.
+    // Returns: number of transfers sent
+    size_t send_split(const std::vector<TransferRequest>& payees, std::vector<TransferResult>& results,
+                      size_t concurrency = 0);
+
+    // Extra threads dialing peers in send_transfers() (0 = one at a time on
+    // the calling thread). Not while a batch is running.
+    void set_send_threads(int threads) { send_pool.start(threads); }
+
+    // Peers on this host are reached over a Unix domain socket instead of
+    // TCP (default on); our listener accepts on one as well. A peer without
+    // one is still reached over TCP. Call before start_listener().
+    void set_local_transport(bool enabled) { local_transport = enabled; }
+
+    // Sends transfers to IPv4 peers as UDP datagrams, batched and
+    // acknowledged (see datagram.h), and has the listener receive them. A
+    // transfer the peer does not acknowledge goes over TCP instead, with the
+    // same transfer ID. Call before start_listener().
+    // Returns: false (and sets error) if the UDP socket cannot be opened
+    bool enable_datagrams(std::string& error) { return datagram_sender.start(error); }
+    bool datagrams_enabled() const { return datagram_sender.started(); }
+    const DatagramSender& datagrams() const { return datagram_sender; }
+
+    // Records every message on the server session and every transfer and
+    // gossip frame sent or received in a capture log at path (see
+    // capture.h), for replay.cpp. Call before connect().
+    // Returns: false (and sets error) if the log cannot be created
+    bool enable_capture(const std::string& path, std::string& error);
+    bool capture_enabled() const { return capture.is_open(); }
+
+    // Extra attempts after a failed connect/send (default TRANSFER_RETRIES)
+    void set_transfer_retries(int retries) { transfer_retries = retries; }
+
+    // Appends a transfer ID to outgoing frames (<from>#<amount>#<to>#<id>),
+    // so recipients running this client drop retried copies. Off by default:
+    // peers that only speak the course protocol reject a fourth field.
+    // Signing, encryption and datagrams need the ID and turn it on regardless;
+    // its send time is what keeps an old signed or sealed frame from being replayed.
+    void set_transfer_ids(bool enabled) { transfer_ids = enabled; }
+    bool transfer_ids_enabled() const {
+        return transfer_ids || signing_key.loaded() || frame_key.loaded() || datagram_sender.started();
+    }
+
+    // While logged in, pings the server with List after interval_seconds
+    // of silence (0 = off, default HEARTBEAT_INTERVAL). A lost server
+    // connection is re-established in the background and logged in again;
+    // the TRANSACTION reports queued meanwhile are sent afterwards.
+    void set_heartbeat(int interval_seconds) { heartbeat_interval = interval_seconds; }
+    // Kernel keepalive on the server connection (see ServerSession::set_keepalive()).
+    // Call before connect().
+    void set_keepalive(int timeout_seconds) { session.set_keepalive(timeout_seconds); }
+
+    // Remembers incoming transfer IDs for window_seconds, up to capacity
+    // transfers (see idempotency.h). Call before start_listener().
+    void configure_duplicate_filter(size_t capacity, int window_seconds);
+    const IdempotencyFilter& duplicate_filter() const { return seen_transfers; }
+
+    // Reports incoming transfers in bulk instead of one TRANSACTION each:
+    // per counterparty every window_ms, or once a position reaches threshold
+    // (see settlement.h). journal = file for the per-transfer detail ("" = none).
+    // Call before start_listener().
+    // Returns: false (and sets error) if the journal cannot be opened
+    bool enable_settlement(SettlementMode mode, int window_ms, long long threshold, const std::string& journal,
+                           std::string& error);
+    bool settlement_enabled() const { return settlement.enabled(); }
+
+    // Exit: logs out (if logged in) and closes the server connection.
+    // Returns: true if the server said Bye
+    bool logout();
+
+    // Stops accepting transfers, finishes the ones already arriving, settles
+    // the open positions, sends the queued TRANSACTION reports and joins the
+    // listener, verification, settlement and reporter threads, all within
+    // timeout_ms. Call it before logout(),
+    // which needs the reports to be out. Later calls do nothing.
+    // Returns: what was lost because the deadline expired (all zero if nothing)
+    ShutdownReport shutdown(int timeout_ms = SHUTDOWN_TIMEOUT_MS);
+
+    // Handles frames received together: decrypts sealed ones, drops frames
+    // that are not addressed to us, checks all signatures as one parallel
+    // batch (if required), drops transfer IDs seen before, then credits the
+    // ledger and queues a TRANSACTION report for every valid transfer.
+    // Returns: number of valid transfers
+    size_t handle_transfer_frames(const std::string* messages, size_t count);
+
+    // Same for a single frame.
+    // Returns: false if the frame is malformed or rejected
+    bool handle_transfer_frame(const std::string& message);
+
+    bool logged_in() const { return is_logged_in; }
+    const std::string& username() const { return user; }
+    UserId user_id() const { return self_id; }
+    const std::string& server_public_key() const { return public_key; }
+    int port() const { return listen_port; }
+
+    CaptureLog capture;   // First, so it outlives the threads that record into it
+    Directory directory;
+    Ledger ledger;
+    ServerSession session;
+    Listener listener;
+
+    // Optional callbacks; set them before connect()/start_listener()
+    TransferCallback on_incoming_transfer;
+    ReportCallback on_report;   // Result of every TRANSACTION report
+    LogCallback on_log;         // Status messages and warnings
+    DirectoryCallback on_directory_event;
+
+private:
+    void apply(const ListReply& reply);
+    void log(const std::string& text);
+    bool decode_transfer(const std::string& message, std::string& plaintext, TransferFrame& frame,
+                         SignatureCheck& check);
+    void accept_transfer(const TransferFrame& frame);
+    TransferStatus dispatch_transfer(UserId recipient, const PeerEndpoint& endpoint, int amount,
+                                     std::string* transfer_id);
+    void dispatch_parallel(size_t count, size_t concurrency, const std::function<void(size_t)>& send);
+    bool resume(const std::string& response);
+    void apply_event(const std::string& line);
+    bool send_gossip(const std::string& username, const std::string& message);
+    void apply_gossip(const GossipEntry& entry);
+
+    std::string user;            // Current logged-in username
+    UserId self_id;              // Interned ID of user (NO_USER before login)
+    std::string public_key;      // Server's public key (for Phase 2)
+    int listen_port;             // Our listening port for P2P connections
+    FrameKey frame_key;          // Network key; not loaded = transfers in cleartext
+    CipherSuite cipher_suite;    // Cipher for outgoing transfers
+    SigningKey signing_key;      // Our key; not loaded = outgoing transfers unsigned
+    TrustStore trusted_keys;     // Senders' keys; not loaded = signatures not checked
+    WorkerPool verify_pool;      // Extra threads for verifying batches of signatures
+    WorkerPool send_pool;        // Extra threads for send_transfers()
+    IdempotencyFilter seen_transfers;  // Recently credited (sender, transfer ID) pairs
+    Settlement settlement;       // Bulk TRANSACTION reports (off unless enabled)
+    DatagramSender datagram_sender;  // UDP transfers (off unless started)
+    bool local_transport;        // Unix domain socket for peers on this host
+    bool transfer_ids;           // Send <from>#<amount>#<to>#<id> instead of the three-field frame
+    int transfer_retries;        // Extra attempts of send_transfer()
+    int heartbeat_interval;      // Seconds of silence before the server is pinged
+    int gossip_interval;         // Milliseconds between gossip rounds (0 = no gossip)
+    int gossip_fanout;           // Peers per gossip round
+    volatile bool is_logged_in;  // Login status flag
+    GossipAgent gossip_agent;    // Last, so it stops while the directory is still there
+};
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ * P2P Micropayment System - Protocol Encoding and Decoding
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "protocol.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <climits>
+
+using namespace std;
+
+string make_register_message(const string& username, int amount) {
+    return "REGISTER#" + username + "#" + to_string(amount) + CRLF;
+}
+
+string make_login_message(const string& username, int port) {
+    return username + "#" + to_string(port) + CRLF;
+}
+
+string make_list_message() {
+    return "List" + string(CRLF);
+}
+
+string make_exit_message() {
+    return "Exit" + string(CRLF);
+}
+
+string make_subscribe_message() {
+    return "SUBSCRIBE" + string(CRLF);
+}
+
+string make_join_event(const OnlineUser& user) {
+    return EVENT_PREFIX "JOIN#" + user.username + "#" + user.ip + "#" + to_string(user.port) + CRLF;
+}
+
+string make_leave_event(const string& username) {
+    return EVENT_PREFIX "LEAVE#" + username + CRLF;
+}
+
+string make_balance_event(int balance) {
+    return EVENT_PREFIX "BALANCE#" + to_string(balance) + CRLF;
+}
+
+string make_transaction_message(const string& sender, const string& recipient, const string& amount) {
+    return "TRANSACTION#" + sender + "#" + recipient + "#" + amount + CRLF;
+}
+
+string make_transfer_message(const string& sender, int amount, const string& recipient) {
+    return sender + "#" + to_string(amount) + "#" + recipient + CRLF;
+}
+
+string make_transfer_message(const string& sender, int amount, const string& recipient,
+                             const string& transfer_id) {
+    return sender + "#" + to_string(amount) + "#" + recipient + "#" + transfer_id + CRLF;
+}
+
+size_t transfer_signed_length(const string& message) {
+    size_t length = message.size();
+    while (length > 0 && (message[length - 1] == '\r' || message[length - 1] == '\n')) {
+        length--;
+    }
+    return length;
+}
+
+void append_transfer_signature(string& message, const string& signature) {
+    message.insert(transfer_signed_length(message), "#" + signature);
+}
+
+/*
+ * Strip Line Ending
+ * Remove any CR/LF characters left by getline()
+ */
+static void strip_line_ending(string& line) {
+    line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+    line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
+}
+
+ListReply parse_list_reply(const string& response) {
+    ListReply reply;
+    reply.ok = false;
+    reply.balance = 0;
+    if (response.empty() || response.find("220 AUTH_FAIL") != string::npos) {
+        return reply;
+    }
+
+    istringstream iss(response);
+    string line;
+
+    // First line: account balance
+    if (getline(iss, line)) {
+        strip_line_ending(line);
+        reply.balance = atoi(line.c_str());
+    }
+
+    // Second line: server public key
+    if (getline(iss, line)) {
+        strip_line_ending(line);
+        reply.public_key = line;
+    }
+
+    // Third line: number of online users
+    int num_users = 0;
+    if (getline(iss, line)) {
+        strip_line_ending(line);
+        num_users = atoi(line.c_str());
+    }
+
+    // Parse each online user's information: username#ip#port
+    for (int i = 0; i < num_users && getline(iss, line); i++) {
+        strip_line_ending(line);
+        size_t pos1 = line.find('#');
+        size_t pos2 = line.find('#', pos1 + 1);
+        if (pos1 == string::npos || pos2 == string::npos) {
+            continue;
+        }
+        OnlineUser user;
+        user.username = line.substr(0, pos1);
+        user.ip = line.substr(pos1 + 1, pos2 - pos1 - 1);
+        user.port = atoi(line.c_str() + pos2 + 1);
+        reply.users.push_back(user);
+    }
+
+    reply.ok = true;
+    return reply;
+}
+
+// Returns: true if line (without its line ending) is a non-empty run of digits, optionally negative
+static bool is_number(const string& line) {
+    size_t start = !line.empty() && line[0] == '-' ? 1 : 0;
+    return line.size() > start && line.find_first_not_of("0123456789", start) == string::npos;
+}
+
+bool is_list_reply(const string& response) {
+    string line = response.substr(0, response.find('\n'));
+    strip_line_ending(line);
+    return is_number(line);
+}
+
+/*
+ * Reply Length
+ * Replies carry no length, so a reader that receives them as a byte stream
+ * has to count lines: a reply starting with a balance is a List reply whose
+ * third line says how many user lines follow.
+ */
+size_t reply_length(const string& data) {
+    size_t pos = 0;
+    string line;
+    // Takes the next complete line, or returns false if it is still missing
+    auto next_line = [&]() {
+        size_t newline = data.find('\n', pos);
+        if (newline == string::npos) {
+            return false;
+        }
+        line.assign(data, pos, newline - pos);
+        strip_line_ending(line);
+        pos = newline + 1;
+        return true;
+    };
+
+    if (!next_line()) {
+        return 0;
+    }
+    if (!is_number(line)) {
+        return pos;  // One-line reply
+    }
+    if (!next_line() || !next_line()) {  // Public key, user count
+        return 0;
+    }
+    for (int i = atoi(line.c_str()); i > 0; i--) {
+        if (!next_line()) {
+            return 0;
+        }
+    }
+    return pos;
+}
+
+bool parse_event(const string& line, DirectoryEvent& event) {
+    const size_t prefix = sizeof(EVENT_PREFIX) - 1;
+    if (line.compare(0, prefix, EVENT_PREFIX) != 0) {
+        return false;
+    }
+    string fields = line.substr(prefix);
+    strip_line_ending(fields);
+    size_t pos1 = fields.find('#');
+    if (pos1 == string::npos) {
+        return false;
+    }
+    string type = fields.substr(0, pos1);
+    string rest = fields.substr(pos1 + 1);
+    event.user = OnlineUser();
+    event.user.port = 0;
+    event.balance = 0;
+
+    if (type == "JOIN") {
+        size_t pos2 = rest.find('#');
+        size_t pos3 = pos2 == string::npos ? string::npos : rest.find('#', pos2 + 1);
+        if (pos3 == string::npos) {
+            return false;
+        }
+        event.type = EVENT_JOIN;
+        event.user.username = rest.substr(0, pos2);
+        event.user.ip = rest.substr(pos2 + 1, pos3 - pos2 - 1);
+        event.user.port = atoi(rest.c_str() + pos3 + 1);
+        return !event.user.username.empty();
+    }
+    if (type == "LEAVE") {
+        event.type = EVENT_LEAVE;
+        event.user.username = rest;
+        return !rest.empty();
+    }
+    if (type == "BALANCE") {
+        event.type = EVENT_BALANCE;
+        event.balance = atoi(rest.c_str());
+        return is_number(rest);
+    }
+    return false;
+}
+
+/*
+ * Parse Amount
+ * A transfer amount is a positive decimal integer that fits in an int: no
+ * sign, no spaces, no leading garbage for atoi() to stop at.
+ * Returns: false (amount = 0) for anything else
+ */
+static bool parse_amount(const string& text, int& amount) {
+    amount = 0;
+    if (text.empty() || text.size() > 10 || text.find_first_not_of("0123456789") != string::npos) {
+        return false;
+    }
+    long long value = atoll(text.c_str());
+    if (value <= 0 || value > INT_MAX) {
+        return false;
+    }
+    amount = (int)value;
+    return true;
+}
+
+bool parse_transfer_frame(const string& message, TransferFrame& frame) {
+    size_t end = message.find_first_of(CRLF);
+    if (end == string::npos) {
+        end = message.size();
+    }
+    size_t pos1 = message.find('#');
+    if (pos1 >= end) {
+        return false;
+    }
+    size_t pos2 = message.find('#', pos1 + 1);
+    if (pos2 >= end) {
+        return false;
+    }
+    size_t pos3 = message.find('#', pos2 + 1);
+    size_t pos4 = pos3 < end ? message.find('#', pos3 + 1) : string::npos;
+    if (pos3 > end) {
+        pos3 = end;
+    }
+    if (pos4 > end) {
+        pos4 = end;
+    }
+
+    frame.sender.assign(message, 0, pos1);
+    frame.amount_str.assign(message, pos1 + 1, pos2 - pos1 - 1);
+    if (!parse_amount(frame.amount_str, frame.amount)) {
+        return false;  // A negative amount would debit us, a non-numeric one credit 0
+    }
+    frame.recipient.assign(message, pos2 + 1, pos3 - pos2 - 1);
+    if (pos3 < end) {
+        frame.transfer_id.assign(message, pos3 + 1, pos4 - pos3 - 1);
+    } else {
+        frame.transfer_id.clear();
+    }
+    if (pos4 < end) {
+        frame.signature.assign(message, pos4 + 1, end - pos4 - 1);
+        frame.signed_length = pos4;
+    } else {
+        frame.signature.clear();
+        frame.signed_length = 0;
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+/*
+ * P2P Micropayment System - Protocol Encoding and Decoding
+ * Course: Computer Networks (Fall 2025)
+ *
+ * All messages are ASCII text, fields are separated by '#', and every
+ * message ends with CRLF. These helpers only build and parse strings;
+ * they never touch sockets or global state.
+ */
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <string>
+#include <vector>
+
+#define CRLF "\r\n"       // Carriage Return + Line Feed (protocol requirement)
+
+// Online user as listed by the server (username#ip#port)
+struct OnlineUser {
+    std::string username;  // User's account name
+    std::string ip;        // User's IP address
+    int port;              // User's listening port for P2P connections
+};
+
+// Parsed login/List reply
+struct ListReply {
+    bool ok;                        // false on AUTH_FAIL or an empty reply
+    int balance;                    // Line 1: account balance
+    std::string public_key;         // Line 2: server public key
+    std::vector<OnlineUser> users;  // Line 4+: online users (line 3 is the count)
+};
+
+// Change to the online list pushed to a subscribed session
+enum DirectoryEventType {
+    EVENT_JOIN,     // EVENT#JOIN#<user>#<ip>#<port>: user logged in
+    EVENT_LEAVE,    // EVENT#LEAVE#<user>: user logged out or disconnected
+    EVENT_BALANCE   // EVENT#BALANCE#<balance>: our own balance changed
+};
+
+struct DirectoryEvent {
+    DirectoryEventType type;
+    OnlineUser user;  // JOIN: the whole entry; LEAVE: username only
+    int balance;      // BALANCE only
+};
+
+// Parsed P2P transfer frame (sender#amount#recipient[#transfer_id[#signature]])
+struct TransferFrame {
+    std::string sender;
+    std::string amount_str;  // Amount exactly as received, forwarded in TRANSACTION reports
+    int amount;
+    std::string recipient;
+    std::string transfer_id; // Sender's ID for duplicate detection, empty in old-style frames (see idempotency.h)
+    std::string signature;   // Hex signature, empty if the frame is unsigned (see signing.h)
+    size_t signed_length;    // Bytes of the frame covered by the signature (0 if unsigned)
+};
+
+// Client -> Server
+std::string make_register_message(const std::string& username, int amount);  // REGISTER#<user>#<amount>
+std::string make_login_message(const std::string& username, int port);       // <user>#<port>
+std::string make_list_message();                                             // List
+std::string make_exit_message();                                             // Exit
+std::string make_subscribe_message();                                        // SUBSCRIBE
+std::string make_transaction_message(const std::string& sender, const std::string& recipient,
+                                     const std::string& amount);             // TRANSACTION#<from>#<to>#<amount>
+
+// Server -> Client, after SUBSCRIBE (see README: the TA's server does not push)
+#define EVENT_PREFIX "EVENT#"
+std::string make_join_event(const OnlineUser& user);      // EVENT#JOIN#<user>#<ip>#<port>
+std::string make_leave_event(const std::string& username);  // EVENT#LEAVE#<user>
+std::string make_balance_event(int balance);              // EVENT#BALANCE#<balance>
+
+// Client -> Client
+std::string make_transfer_message(const std::string& sender, int amount,
+                                  const std::string& recipient);             // <from>#<amount>#<to>
+std::string make_transfer_message(const std::string& sender, int amount, const std::string& recipient,
+                                  const std::string& transfer_id);           // <from>#<amount>#<to>#<id>
+
+// Bytes of a transfer message that its signature covers: all but the line ending
+size_t transfer_signed_length(const std::string& message);
+
+// Turns <from>#<amount>#<to>#<id>\r\n into <from>#<amount>#<to>#<id>#<signature>\r\n
+void append_transfer_signature(std::string& message, const std::string& signature);
+
+/*
+ * Parses a login/List reply:
+ *   Line 1: Account balance
+ *   Line 2: Server public key
+ *   Line 3: Number of online users
+ *   Line 4+: username#ip#port for each online user
+ */
+ListReply parse_list_reply(const std::string& response);
+
+// Returns: true if response is a login/List reply, i.e. starts with a
+// balance line, rather than a one-line status such as "230 Input format error"
+bool is_list_reply(const std::string& response);
+
+// Returns: bytes taken by the first complete reply in data (a List reply
+// spans 3 + count lines, any other reply one line; LF or CRLF), or 0 if the
+// rest of it has not arrived yet
+size_t reply_length(const std::string& data);
+
+// Parses one EVENT#... line (with or without CRLF).
+// Returns: false if it is not a well-formed event
+bool parse_event(const std::string& line, DirectoryEvent& event);
+
+// Parses sender#amount#recipient, optionally followed by #transfer_id and
+// #transfer_id#signature (with or without CRLF).
+// Returns: false if the frame has fewer than three fields or the amount is
+//          not a positive integer
+bool parse_transfer_frame(const std::string& message, TransferFrame& frame);
+
+#endif
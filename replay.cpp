@@ -0,0 +1,416 @@
+/*
+ * P2P Micropayment System - Capture Replay
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Plays back a log written by a client started with --capture (see
+ * capture.h), so a traffic mix seen in a real run can be benchmarked
+ * against a new build:
+ *   (always)         what the log holds: messages and bytes per channel,
+ *                    direction and kind, and how long the capture ran
+ *   --parse          times this build's parsers on the captured messages:
+ *                    parse_list_reply() and parse_event() on the server's
+ *                    replies and events, parse_transfer_frame() on the P2P
+ *                    frames, each --repeat times
+ *   --p2p IP PORT    sends the P2P frames the captured client received to
+ *                    the listener at IP:PORT, one connection per frame like
+ *                    the peers did, from --p2p-threads threads (default 4)
+ *   --server IP PORT sends the captured client's requests to the server at
+ *                    IP:PORT (e.g. ./devserver) on one connection, waiting
+ *                    for each reply like ServerSession, and times the replies
+ * --p2p and --server keep the captured timing, --speed times faster
+ * (0 = as fast as they go); given both, they run side by side. How late the
+ * sends fall behind the schedule shows whether the target kept up.
+ *
+ * Frames are sent exactly as captured: sealed or signed frames need a
+ * target with the same keys, a target that already saw the transfer IDs
+ * (the captured client itself) drops them as duplicates, and frames whose
+ * IDs were sent longer ago than the target's dedup window are dropped too.
+ *
+ * Usage: ./replay <log> [--parse] [--repeat N] [--p2p IP PORT] [--p2p-threads T]
+ *                 [--server IP PORT] [--speed X]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "capture.h"
+#include "protocol.h"
+#include "gossip.h"
+#include "net.h"
+
+using namespace std;
+
+#define REPLAY_REPLY_TIMEOUT_MS 5000  // Longest wait for one server reply
+
+// Replay parameters
+string log_path;
+bool run_parse = false;
+int repeat = 100;
+string p2p_ip, server_ip;
+int p2p_port = 0, server_port = 0;
+int p2p_threads = 4;
+double speed = 1.0;
+
+vector<CaptureRecord> records;
+volatile size_t parse_sink;   // Keeps the optimizer from dropping the parsing
+
+typedef chrono::steady_clock::time_point TimePoint;
+
+// Returns: what kind of message a record is, for the summary
+string message_kind(const CaptureRecord& record) {
+    const string& data = record.data;
+    if (record.channel == CAPTURE_P2P) {
+        if (is_gossip_message(data)) {
+            return "gossip";
+        }
+        TransferFrame frame;
+        return parse_transfer_frame(data, frame) && frame.amount > 0 ? "transfer" : "other (sealed?)";
+    }
+    if (record.direction == CAPTURE_IN) {
+        if (data.compare(0, sizeof(EVENT_PREFIX) - 1, EVENT_PREFIX) == 0) {
+            return "event";
+        }
+        return is_list_reply(data) ? "List reply" : "status";
+    }
+    size_t field_end = data.find_first_of("#\r\n");
+    string first = data.substr(0, field_end);
+    if (first == "REGISTER" || first == "TRANSACTION" || first == "List" || first == "Exit" ||
+        first == "SUBSCRIBE") {
+        return first;
+    }
+    return "login";
+}
+
+/*
+ * Percentile
+ * Returns the p-th percentile of a sorted sample (0 if empty).
+ */
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1));
+    return sorted[index];
+}
+
+void print_summary() {
+    struct Count {
+        unsigned long messages;
+        unsigned long long bytes;
+    };
+    map<string, Count> counts;
+    for (const CaptureRecord& record : records) {
+        string key = string(record.channel == CAPTURE_SERVER ? "server " : "p2p    ") +
+                     (record.direction == CAPTURE_OUT ? "sent     " : "received ") + message_kind(record);
+        Count& count = counts[key];
+        count.messages++;
+        count.bytes += record.data.size();
+    }
+    double seconds = records.empty() ? 0 : records.back().time_us / 1e6;
+    cout << records.size() << " messages in " << fixed << setprecision(3) << seconds << " s" << endl;
+    for (const auto& entry : counts) {
+        cout << "  " << left << setw(36) << entry.first << right << setw(10) << entry.second.messages
+             << " messages" << setw(12) << entry.second.bytes << " bytes" << endl;
+    }
+}
+
+/*
+ * Time Parser
+ * Runs parse over every message in sample, repeat times.
+ * Returns: nanoseconds per message
+ */
+template <typename Parse>
+double time_parser(const vector<const string*>& sample, Parse parse) {
+    size_t checksum = 0;
+    TimePoint start = chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        for (const string* message : sample) {
+            checksum += parse(*message);
+        }
+    }
+    double ns = (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    parse_sink = parse_sink + checksum;
+    return sample.empty() ? 0 : ns / ((double)sample.size() * repeat);
+}
+
+void run_parsers() {
+    vector<const string*> lists, events, transfers;
+    for (const CaptureRecord& record : records) {
+        string kind = message_kind(record);
+        if (kind == "List reply") {
+            lists.push_back(&record.data);
+        } else if (kind == "event") {
+            events.push_back(&record.data);
+        } else if (kind == "transfer") {
+            transfers.push_back(&record.data);
+        }
+    }
+    double list_ns = time_parser(lists, [](const string& message) { return parse_list_reply(message).users.size(); });
+    double event_ns = time_parser(events, [](const string& message) {
+        DirectoryEvent event;
+        return (size_t)parse_event(message, event);
+    });
+    double transfer_ns = time_parser(transfers, [](const string& message) {
+        TransferFrame frame;
+        return parse_transfer_frame(message, frame) ? frame.sender.size() : 0;
+    });
+    cout << "\nParsing the captured messages " << repeat << " times:" << endl;
+    cout << setprecision(1);
+    cout << "  parse_list_reply      " << setw(8) << lists.size() << " replies  " << setw(10) << list_ns
+         << " ns each" << endl;
+    cout << "  parse_event           " << setw(8) << events.size() << " events   " << setw(10) << event_ns
+         << " ns each" << endl;
+    cout << "  parse_transfer_frame  " << setw(8) << transfers.size() << " frames   " << setw(10) << transfer_ns
+         << " ns each" << endl;
+}
+
+// Waits until the record's time on the sped-up schedule.
+// Returns: microseconds the call was late for it
+double wait_for_schedule(const CaptureRecord& record, TimePoint start) {
+    if (speed <= 0) {
+        return 0;
+    }
+    TimePoint due = start + chrono::microseconds((long long)(record.time_us / speed));
+    TimePoint now = chrono::steady_clock::now();
+    if (now < due) {
+        this_thread::sleep_until(due);
+        return 0;
+    }
+    return (double)chrono::duration_cast<chrono::microseconds>(now - due).count();
+}
+
+// Describes how one replay went
+void print_replay(ostream& out, const string& name, size_t sent, size_t failed, double seconds,
+                  vector<double>& late_us) {
+    sort(late_us.begin(), late_us.end());
+    out << fixed << setprecision(1);
+    out << "  " << name << ": " << sent << " sent, " << failed << " failed in " << setprecision(3) << seconds
+         << " s (" << setprecision(1) << (seconds > 0 ? sent / seconds : 0) << "/s); behind schedule p50 "
+         << percentile(late_us, 50) / 1000 << " ms, p99 " << percentile(late_us, 99) / 1000 << " ms, max "
+         << percentile(late_us, 100) / 1000 << " ms" << endl;
+}
+
+/*
+ * Replay P2P
+ * The frames the captured client received, each on a new connection, from
+ * --p2p-threads threads: frame i goes out on thread i % threads, so a burst
+ * that many peers sent at once is not serialized behind one connect.
+ * Returns: the report (printed once both replays are done)
+ */
+string replay_p2p(TimePoint start) {
+    vector<const CaptureRecord*> frames;
+    for (const CaptureRecord& record : records) {
+        if (record.channel == CAPTURE_P2P && record.direction == CAPTURE_IN) {
+            frames.push_back(&record);
+        }
+    }
+    vector<size_t> sent(p2p_threads, 0), failed(p2p_threads, 0);
+    vector<vector<double> > late_us(p2p_threads);
+    vector<thread> workers;
+    for (int t = 0; t < p2p_threads; t++) {
+        workers.push_back(thread([&, t] {
+            for (size_t i = t; i < frames.size(); i += p2p_threads) {
+                late_us[t].push_back(wait_for_schedule(*frames[i], start));
+                int sock = connect_to_server(p2p_ip, p2p_port);
+                if (sock == -1) {
+                    failed[t]++;
+                    continue;
+                }
+                if (send_message(sock, frames[i]->data)) {
+                    sent[t]++;
+                } else {
+                    failed[t]++;
+                }
+                close(sock);
+            }
+        }));
+    }
+    size_t total_sent = 0, total_failed = 0;
+    vector<double> all_late_us;
+    for (int t = 0; t < p2p_threads; t++) {
+        workers[t].join();
+        total_sent += sent[t];
+        total_failed += failed[t];
+        all_late_us.insert(all_late_us.end(), late_us[t].begin(), late_us[t].end());
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    ostringstream out;
+    print_replay(out, "P2P frames to " + p2p_ip + ":" + to_string(p2p_port), total_sent, total_failed, seconds,
+                 all_late_us);
+    return out.str();
+}
+
+/*
+ * Receive Reply
+ * Reads lines until a whole reply is in (see reply_length()); pushed events
+ * in between are skipped.
+ * Returns: false if the server closed or timed out first
+ */
+bool receive_reply(int sock, string& pending, string& reply) {
+    reply.clear();
+    char buffer[BUFFER_SIZE];
+    while (true) {
+        size_t newline;
+        while ((newline = pending.find('\n')) != string::npos) {
+            string line = pending.substr(0, newline + 1);
+            pending.erase(0, newline + 1);
+            if (line.compare(0, sizeof(EVENT_PREFIX) - 1, EVENT_PREFIX) == 0) {
+                continue;
+            }
+            reply += line;
+            if (reply_length(reply) == reply.size()) {
+                return true;
+            }
+        }
+        ssize_t received = recv(sock, buffer, sizeof(buffer), 0);
+        if (received == -1 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        pending.append(buffer, received);
+    }
+}
+
+/*
+ * Replay Server
+ * The captured client's requests on one connection, one exchange at a
+ * time. A reply of another kind than the captured one (a status line where
+ * a List reply was, or the other way round) is counted as a mismatch.
+ * Returns: the report
+ */
+string replay_server(TimePoint start) {
+    ostringstream out;
+    int sock = connect_to_server(server_ip, server_port);
+    if (sock == -1) {
+        out << "  Cannot connect to the server at " << server_ip << ":" << server_port << endl;
+        return out.str();
+    }
+    struct timeval timeout = { REPLAY_REPLY_TIMEOUT_MS / 1000, (REPLAY_REPLY_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    size_t sent = 0, failed = 0, mismatched = 0;
+    vector<double> late_us, reply_us;
+    string pending, reply;
+    for (size_t i = 0; i < records.size(); i++) {
+        const CaptureRecord& record = records[i];
+        if (record.channel != CAPTURE_SERVER || record.direction != CAPTURE_OUT) {
+            continue;
+        }
+        // The reply captured for this request: the next server message that is not an event
+        string expected;
+        for (size_t j = i + 1; j < records.size(); j++) {
+            if (records[j].channel == CAPTURE_SERVER && records[j].direction == CAPTURE_IN &&
+                message_kind(records[j]) != "event") {
+                expected = message_kind(records[j]);
+                break;
+            }
+        }
+        late_us.push_back(wait_for_schedule(record, start));
+        TimePoint sent_at = chrono::steady_clock::now();
+        if (!send_message(sock, record.data) || !receive_reply(sock, pending, reply)) {
+            failed++;
+            break;  // The connection is gone; the rest would fail the same way
+        }
+        reply_us.push_back(
+            (double)chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - sent_at).count());
+        sent++;
+        string kind = is_list_reply(reply) ? "List reply" : "status";
+        if (!expected.empty() && kind != expected) {
+            mismatched++;
+        }
+    }
+    close(sock);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    print_replay(out, "Requests to " + server_ip + ":" + to_string(server_port), sent, failed, seconds, late_us);
+    sort(reply_us.begin(), reply_us.end());
+    out << "    replies: p50 " << percentile(reply_us, 50) << " us, p99 " << percentile(reply_us, 99)
+         << " us, max " << percentile(reply_us, 100) << " us; " << mismatched
+         << " of another kind than captured" << endl;
+    return out.str();
+}
+
+int main(int argc, char* argv[]) {
+    bool usage = argc < 2;
+    for (int i = 2; i < argc && !usage; i++) {
+        string arg = argv[i];
+        if (arg == "--parse") {
+            run_parse = true;
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+            usage = repeat < 1;
+        } else if (arg == "--p2p" && i + 2 < argc) {
+            p2p_ip = argv[++i];
+            p2p_port = atoi(argv[++i]);
+        } else if (arg == "--server" && i + 2 < argc) {
+            server_ip = argv[++i];
+            server_port = atoi(argv[++i]);
+        } else if (arg == "--p2p-threads" && i + 1 < argc) {
+            p2p_threads = atoi(argv[++i]);
+            usage = p2p_threads < 1;
+        } else if (arg == "--speed" && i + 1 < argc) {
+            speed = atof(argv[++i]);
+            usage = speed < 0;
+        } else {
+            usage = true;
+        }
+    }
+    if (usage) {
+        cout << "Usage: " << argv[0] << " <log> [--parse] [--repeat N] [--p2p IP PORT] [--p2p-threads T]"
+             << " [--server IP PORT] [--speed X]" << endl;
+        return 1;
+    }
+    log_path = argv[1];
+
+    CaptureReader reader;
+    string error;
+    if (!reader.open(log_path, error)) {
+        cout << error << endl;
+        return 1;
+    }
+    CaptureRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    if (!reader.error().empty()) {
+        cout << "Warning: " << reader.error() << " after " << records.size() << " messages; replaying those"
+             << endl;
+    }
+
+    print_summary();
+    if (run_parse) {
+        run_parsers();
+    }
+    if (p2p_port > 0 || server_port > 0) {
+        ostringstream pace;
+        pace << speed << "x the captured speed";
+        cout << "\nReplaying at " << (speed > 0 ? pace.str() : "full speed") << endl;
+        TimePoint start = chrono::steady_clock::now();
+        string p2p_report, server_report;
+        thread p2p_thread;
+        if (p2p_port > 0) {
+            p2p_thread = thread([&] { p2p_report = replay_p2p(start); });
+        }
+        if (server_port > 0) {
+            server_report = replay_server(start);
+        }
+        if (p2p_thread.joinable()) {
+            p2p_thread.join();
+        }
+        cout << p2p_report << server_report;
+    }
+    return 0;
+}
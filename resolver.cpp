@@ -0,0 +1,120 @@
+/*
+ * P2P Micropayment System - Hostname Resolver
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "resolver.h"
+
+#include <cstring>
+#include <netdb.h>
+
+using namespace std;
+
+Resolver::Resolver() : running(false) {}
+
+Resolver::~Resolver() {
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        running = false;
+        cache_cv.notify_all();
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool Resolver::resolve_now(const string& host, int port, PeerEndpoint& endpoint) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;       // IPv4 or IPv6
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* result = NULL;
+    if (getaddrinfo(host.c_str(), NULL, &hints, &result) != 0 || result == NULL) {
+        return false;
+    }
+    memset(&endpoint, 0, sizeof(endpoint));
+    size_t length = result->ai_addrlen < sizeof(endpoint.addr) ? result->ai_addrlen : sizeof(endpoint.addr);
+    memcpy(&endpoint.addr, result->ai_addr, length);
+    set_endpoint_port(endpoint, port);
+    freeaddrinfo(result);
+    return true;
+}
+
+bool Resolver::claim(const string& host) {
+    // cache_mutex must be held
+    auto it = cache.find(host);
+    if (it != cache.end() && (!it->second.done || chrono::steady_clock::now() < it->second.expires)) {
+        return false;
+    }
+    Entry& entry = cache[host];
+    entry.done = false;
+    entry.ok = false;
+    return true;
+}
+
+void Resolver::finish(const string& host, bool ok, const PeerEndpoint& endpoint) {
+    lock_guard<mutex> lock(cache_mutex);
+    Entry& entry = cache[host];
+    entry.done = true;
+    entry.ok = ok;
+    entry.endpoint = endpoint;
+    entry.expires = chrono::steady_clock::now() +
+                    chrono::seconds(ok ? RESOLVER_TTL_SECONDS : RESOLVER_NEGATIVE_TTL_SECONDS);
+    cache_cv.notify_all();
+}
+
+bool Resolver::resolve(const string& host, int port, PeerEndpoint& endpoint) {
+    unique_lock<mutex> lock(cache_mutex);
+    if (claim(host)) {
+        lock.unlock();
+        PeerEndpoint resolved;
+        bool ok = resolve_now(host, 0, resolved);
+        finish(host, ok, resolved);
+        lock.lock();
+    }
+
+    // Cached, or being resolved by another thread
+    cache_cv.wait(lock, [&] { return cache[host].done; });
+    const Entry& entry = cache[host];
+    if (!entry.ok) {
+        return false;
+    }
+    endpoint = entry.endpoint;
+    set_endpoint_port(endpoint, port);
+    return true;
+}
+
+void Resolver::prefetch(const string& host) {
+    lock_guard<mutex> lock(cache_mutex);
+    if (!claim(host)) {
+        return;
+    }
+    queue.push_back(host);
+    if (!running) {
+        running = true;
+        worker = thread(&Resolver::worker_loop, this);
+    }
+    cache_cv.notify_all();
+}
+
+/*
+ * Worker Loop
+ * Resolves prefetched hosts one at a time.
+ */
+void Resolver::worker_loop() {
+    while (true) {
+        unique_lock<mutex> lock(cache_mutex);
+        cache_cv.wait(lock, [this] { return !queue.empty() || !running; });
+        if (!running) {
+            return;
+        }
+        string host = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        PeerEndpoint resolved;
+        bool ok = resolve_now(host, 0, resolved);
+        finish(host, ok, resolved);
+    }
+}
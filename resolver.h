@@ -0,0 +1,67 @@
+/*
+ * P2P Micropayment System - Hostname Resolver
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Caches getaddrinfo() results so a hostname in the online list is resolved
+ * once, not on every transfer. prefetch() resolves in a background thread,
+ * so parsing a List reply never waits on DNS; resolve() returns the cached
+ * address, waits for a lookup already in flight, or resolves on the spot.
+ *
+ * Successful lookups are kept for RESOLVER_TTL_SECONDS, failures for
+ * RESOLVER_NEGATIVE_TTL_SECONDS. Thread-safe.
+ */
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include "endpoint.h"
+
+#define RESOLVER_TTL_SECONDS 60
+#define RESOLVER_NEGATIVE_TTL_SECONDS 5
+
+class Resolver {
+public:
+    Resolver();
+    ~Resolver();  // Stops the background thread
+
+    // Fills endpoint with host's address and port.
+    // Returns: false if host could not be resolved
+    bool resolve(const std::string& host, int port, PeerEndpoint& endpoint);
+
+    // Starts resolving host in the background (no-op if cached or in flight)
+    void prefetch(const std::string& host);
+
+    // Resolves host now with getaddrinfo(), bypassing the cache
+    static bool resolve_now(const std::string& host, int port, PeerEndpoint& endpoint);
+
+private:
+    struct Entry {
+        bool done;        // false while a lookup is in flight
+        bool ok;          // lookup succeeded
+        PeerEndpoint endpoint;  // port 0; the caller's port is filled in
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // Claims host for a lookup if it is not cached or in flight.
+    // Returns: true if the caller must resolve it and call finish()
+    bool claim(const std::string& host);
+    void finish(const std::string& host, bool ok, const PeerEndpoint& endpoint);
+    void worker_loop();
+
+    std::mutex cache_mutex;              // Protects everything below
+    std::condition_variable cache_cv;    // Signalled when a lookup finishes or work arrives
+    std::map<std::string, Entry> cache;  // host -> result
+    std::deque<std::string> queue;       // hosts waiting for the background thread
+    std::thread worker;                  // Started by the first prefetch()
+    bool running;
+};
+
+#endif
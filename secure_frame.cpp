@@ -0,0 +1,331 @@
+/*
+ * P2P Micropayment System - Encrypted Transfer Frames
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "secure_frame.h"
+#include "hex.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#ifndef P2PPAY_NO_CRYPTO
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/rand.h>
+#endif
+
+using namespace std;
+
+#define SEALED_PREFIX "ENC1#"
+#define FRAME_TAG_SIZE 16
+#define FRAME_NONCE_SIZE 12
+#define MAX_SEALED_FRAME 4096  // Largest plaintext frame (same as BUFFER_SIZE)
+
+bool parse_cipher_suite(const string& name, CipherSuite& suite) {
+    if (name == "aes-256-gcm") {
+        suite = CIPHER_AES_256_GCM;
+    } else if (name == "chacha20-poly1305") {
+        suite = CIPHER_CHACHA20_POLY1305;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* cipher_suite_name(CipherSuite suite) {
+    return suite == CIPHER_CHACHA20_POLY1305 ? "chacha20-poly1305" : "aes-256-gcm";
+}
+
+bool is_sealed_frame(const string& line) {
+    return line.compare(0, strlen(SEALED_PREFIX), SEALED_PREFIX) == 0;
+}
+
+FrameKey::FrameKey() : is_loaded(false) {
+    memset(key, 0, sizeof(key));
+}
+
+#ifdef P2PPAY_NO_CRYPTO
+
+bool FrameKey::load_file(const string&, string& error) {
+    error = "built without OpenSSL (NO_CRYPTO=1), encryption is not available";
+    return false;
+}
+
+FrameSealer::FrameSealer(const FrameKey&, CipherSuite suite) : suite(suite), seq(0), ctx(NULL), ready(false) {}
+
+FrameSealer::~FrameSealer() {}
+
+bool FrameSealer::seal(const string&, string&) {
+    return false;
+}
+
+bool open_sealed_frame(const FrameKey&, const string&, string&) {
+    return false;
+}
+
+#else
+
+#define KDF_LABEL "p2ppay frame v1"
+
+static EVP_MAC_CTX* new_hmac_sha256(const unsigned char* key, size_t length) {
+    EVP_MAC* mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+    EVP_MAC_CTX* ctx = mac != NULL ? EVP_MAC_CTX_new(mac) : NULL;
+    EVP_MAC_free(mac);
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()
+    };
+    if (ctx != NULL && EVP_MAC_init(ctx, key, length, params) != 1) {
+        EVP_MAC_CTX_free(ctx);
+        ctx = NULL;
+    }
+    return ctx;
+}
+
+static bool finish_hmac(EVP_MAC_CTX* ctx, unsigned char* out) {
+    size_t out_length = 0;
+    return EVP_MAC_final(ctx, out, &out_length, FRAME_KEY_SIZE) == 1 && out_length == FRAME_KEY_SIZE;
+}
+
+/*
+ * Load Key File
+ * The network key is HKDF-Extract(salt = KDF_LABEL, file contents), i.e. the
+ * pseudorandom key that the per-connection keys are expanded from.
+ */
+bool FrameKey::load_file(const string& path, string& error) {
+    ifstream file(path.c_str(), ios::binary);
+    if (!file) {
+        error = "cannot read key file " + path;
+        return false;
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string secret = contents.str();
+    if (secret.empty()) {
+        error = "key file " + path + " is empty";
+        return false;
+    }
+    EVP_MAC_CTX* ctx = new_hmac_sha256((const unsigned char*)KDF_LABEL, strlen(KDF_LABEL));
+    bool ok = ctx != NULL &&
+              EVP_MAC_update(ctx, (const unsigned char*)secret.data(), secret.size()) == 1 &&
+              finish_hmac(ctx, key);
+    EVP_MAC_CTX_free(ctx);
+    OPENSSL_cleanse(&secret[0], secret.size());
+    if (!ok) {
+        error = "cannot derive a key from " + path;
+        return false;
+    }
+    is_loaded = true;
+    return true;
+}
+
+static const EVP_CIPHER* suite_cipher(char suite) {
+    return suite == CIPHER_CHACHA20_POLY1305 ? EVP_chacha20_poly1305() : EVP_aes_256_gcm();
+}
+
+/*
+ * Expand Cache
+ * Per-thread HMAC context already keyed with the network key. Duplicating it
+ * is much cheaper than setting up a fresh HKDF (EVP_PKEY_HKDF fetches and
+ * keys everything again, ~15 us per connection).
+ */
+struct ExpandCache {
+    EVP_MAC_CTX* ctx;
+    unsigned char key[FRAME_KEY_SIZE];
+
+    ExpandCache() : ctx(NULL) {}
+    ~ExpandCache() {
+        EVP_MAC_CTX_free(ctx);
+        OPENSSL_cleanse(key, sizeof(key));
+    }
+};
+
+/*
+ * Derive Connection Key
+ * HKDF-Expand(network key, KDF_LABEL + suite + salt, 32 bytes): a single
+ * HMAC-SHA256 block.
+ */
+static bool derive_connection_key(const FrameKey& key, const unsigned char* salt, char suite, unsigned char* out) {
+    static thread_local ExpandCache cache;
+    if (cache.ctx == NULL || memcmp(cache.key, key.bytes(), FRAME_KEY_SIZE) != 0) {
+        EVP_MAC_CTX_free(cache.ctx);
+        cache.ctx = new_hmac_sha256(key.bytes(), FRAME_KEY_SIZE);
+        if (cache.ctx == NULL) {
+            return false;
+        }
+        memcpy(cache.key, key.bytes(), FRAME_KEY_SIZE);
+    }
+
+    EVP_MAC_CTX* ctx = EVP_MAC_CTX_dup(cache.ctx);
+    unsigned char counter = 1;
+    bool ok = ctx != NULL &&
+              EVP_MAC_update(ctx, (const unsigned char*)KDF_LABEL, strlen(KDF_LABEL)) == 1 &&
+              EVP_MAC_update(ctx, (const unsigned char*)&suite, 1) == 1 &&
+              EVP_MAC_update(ctx, salt, FRAME_SALT_SIZE) == 1 &&
+              EVP_MAC_update(ctx, &counter, 1) == 1 &&
+              finish_hmac(ctx, out);
+    EVP_MAC_CTX_free(ctx);
+    return ok;
+}
+
+// 96-bit nonce: 4 zero bytes + the frame number, big-endian
+static void make_nonce(uint64_t seq, unsigned char* nonce) {
+    memset(nonce, 0, FRAME_NONCE_SIZE);
+    for (int i = 0; i < 8; i++) {
+        nonce[FRAME_NONCE_SIZE - 1 - i] = (unsigned char)(seq >> (8 * i));
+    }
+}
+
+FrameSealer::FrameSealer(const FrameKey& key, CipherSuite suite) : suite(suite), seq(0), ctx(NULL), ready(false) {
+    unsigned char connection_key[FRAME_KEY_SIZE];
+    if (!key.loaded() || RAND_bytes(salt, sizeof(salt)) != 1 ||
+        !derive_connection_key(key, salt, (char)suite, connection_key)) {
+        return;
+    }
+
+    EVP_CIPHER_CTX* cipher_ctx = EVP_CIPHER_CTX_new();
+    ready = cipher_ctx != NULL &&
+            EVP_EncryptInit_ex(cipher_ctx, suite_cipher((char)suite), NULL, connection_key, NULL) == 1;
+    OPENSSL_cleanse(connection_key, sizeof(connection_key));
+    ctx = cipher_ctx;
+
+    header = SEALED_PREFIX;
+    header += (char)suite;
+    header += '#';
+    append_hex(header, salt, sizeof(salt));
+    header += '#';
+}
+
+FrameSealer::~FrameSealer() {
+    EVP_CIPHER_CTX_free((EVP_CIPHER_CTX*)ctx);
+}
+
+bool FrameSealer::seal(const string& frame, string& line) {
+    if (!ready || frame.size() > MAX_SEALED_FRAME) {
+        return false;
+    }
+    EVP_CIPHER_CTX* cipher_ctx = (EVP_CIPHER_CTX*)ctx;
+    unsigned char nonce[FRAME_NONCE_SIZE];
+    make_nonce(seq, nonce);
+
+    line = header;
+    line += to_string(seq);
+    line += '#';
+    seq++;
+
+    // Associated data: everything before the ciphertext
+    unsigned char out[MAX_SEALED_FRAME + FRAME_TAG_SIZE];
+    int length = 0;
+    int final_length = 0;
+    if (EVP_EncryptInit_ex(cipher_ctx, NULL, NULL, NULL, nonce) != 1 ||
+        EVP_EncryptUpdate(cipher_ctx, NULL, &length, (const unsigned char*)line.data(), (int)line.size()) != 1 ||
+        EVP_EncryptUpdate(cipher_ctx, out, &length, (const unsigned char*)frame.data(), (int)frame.size()) != 1 ||
+        EVP_EncryptFinal_ex(cipher_ctx, out + length, &final_length) != 1 ||
+        EVP_CIPHER_CTX_ctrl(cipher_ctx, EVP_CTRL_AEAD_GET_TAG, FRAME_TAG_SIZE, out + length + final_length) != 1) {
+        return false;
+    }
+
+    append_hex(line, out, length + final_length + FRAME_TAG_SIZE);
+    line += "\r\n";
+    return true;
+}
+
+/*
+ * Open Cache
+ * Per-thread decryption context keyed with the connection key of the last
+ * salt seen, so consecutive frames of a connection skip the key derivation.
+ */
+struct OpenCache {
+    EVP_CIPHER_CTX* ctx;
+    bool valid;
+    const FrameKey* key;
+    char suite;
+    unsigned char salt[FRAME_SALT_SIZE];
+
+    OpenCache() : ctx(EVP_CIPHER_CTX_new()), valid(false), key(NULL), suite(0) {}
+    ~OpenCache() { EVP_CIPHER_CTX_free(ctx); }
+};
+
+bool open_sealed_frame(const FrameKey& key, const string& line, string& frame) {
+    // ENC1#<suite>#<salt>#<seq>#<ciphertext||tag>
+    const size_t prefix = strlen(SEALED_PREFIX);
+    const size_t salt_start = prefix + 2;
+    const size_t salt_end = salt_start + 2 * FRAME_SALT_SIZE;
+    if (!key.loaded() || !is_sealed_frame(line) || line.size() <= salt_end ||
+        line[prefix + 1] != '#' || line[salt_end] != '#') {
+        return false;
+    }
+    char suite = line[prefix];
+    if (suite != CIPHER_AES_256_GCM && suite != CIPHER_CHACHA20_POLY1305) {
+        return false;
+    }
+    unsigned char salt[FRAME_SALT_SIZE];
+    if (!decode_hex(line.data() + salt_start, 2 * FRAME_SALT_SIZE, salt)) {
+        return false;
+    }
+
+    size_t seq_end = line.find('#', salt_end + 1);
+    if (seq_end == string::npos || seq_end == salt_end + 1) {
+        return false;
+    }
+    uint64_t seq = 0;
+    for (size_t i = salt_end + 1; i < seq_end; i++) {
+        if (line[i] < '0' || line[i] > '9') {
+            return false;
+        }
+        seq = seq * 10 + (line[i] - '0');
+    }
+
+    size_t data_start = seq_end + 1;
+    size_t data_end = line.find_first_of("\r\n", data_start);
+    if (data_end == string::npos) {
+        data_end = line.size();
+    }
+    size_t sealed_length = (data_end - data_start) / 2;
+    if (sealed_length < FRAME_TAG_SIZE || sealed_length > MAX_SEALED_FRAME + FRAME_TAG_SIZE) {
+        return false;
+    }
+    unsigned char sealed[MAX_SEALED_FRAME + FRAME_TAG_SIZE];
+    if (!decode_hex(line.data() + data_start, data_end - data_start, sealed)) {
+        return false;
+    }
+    size_t cipher_length = sealed_length - FRAME_TAG_SIZE;
+
+    static thread_local OpenCache cache;
+    if (cache.ctx == NULL) {
+        return false;
+    }
+    if (!cache.valid || cache.key != &key || cache.suite != suite || memcmp(cache.salt, salt, sizeof(salt)) != 0) {
+        unsigned char connection_key[FRAME_KEY_SIZE];
+        cache.valid = derive_connection_key(key, salt, suite, connection_key) &&
+                      EVP_DecryptInit_ex(cache.ctx, suite_cipher(suite), NULL, connection_key, NULL) == 1;
+        OPENSSL_cleanse(connection_key, sizeof(connection_key));
+        if (!cache.valid) {
+            return false;
+        }
+        cache.key = &key;
+        cache.suite = suite;
+        memcpy(cache.salt, salt, sizeof(salt));
+    }
+
+    unsigned char nonce[FRAME_NONCE_SIZE];
+    make_nonce(seq, nonce);
+    unsigned char out[MAX_SEALED_FRAME];
+    int length = 0;
+    int final_length = 0;
+    if (EVP_DecryptInit_ex(cache.ctx, NULL, NULL, NULL, nonce) != 1 ||
+        EVP_DecryptUpdate(cache.ctx, NULL, &length, (const unsigned char*)line.data(), (int)data_start) != 1 ||
+        EVP_DecryptUpdate(cache.ctx, out, &length, sealed, (int)cipher_length) != 1 ||
+        EVP_CIPHER_CTX_ctrl(cache.ctx, EVP_CTRL_AEAD_SET_TAG, FRAME_TAG_SIZE, sealed + cipher_length) != 1 ||
+        EVP_DecryptFinal_ex(cache.ctx, out + length, &final_length) != 1) {
+        return false;
+    }
+    frame.assign((const char*)out, length + final_length);
+    return true;
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * P2P Micropayment System - Encrypted Transfer Frames
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Optional AEAD encryption of P2P transfer frames with a network key that
+ * every client loads from the same key file (--key-file). The key itself
+ * never goes on the wire.
+ *
+ * Each outgoing connection draws a random 16-byte salt and derives its
+ * connection key once (HKDF-SHA256 expanded from the network key with the
+ * salt); every
+ * frame on the connection then costs a single AES-256-GCM or
+ * ChaCha20-Poly1305 pass (OpenSSL's libcrypto, which uses AES-NI / ARMv8 AES
+ * when the CPU has it). A sealed frame is still one CRLF-terminated line, so
+ * the listener's framing is unchanged:
+ *
+ *   ENC1#<suite>#<salt: 32 hex>#<seq>#<hex(ciphertext || 16-byte tag)>\r\n
+ *
+ * suite is 'a' (AES-256-GCM) or 'c' (ChaCha20-Poly1305), seq is the frame's
+ * number on the connection and forms the nonce, and everything up to the last
+ * '#' is authenticated as associated data. The plaintext is the ordinary
+ * transfer frame (sender#amount#recipient#id...\r\n).
+ *
+ * Replayed frames are not detected here.
+ * Build with NO_CRYPTO=1 to leave out OpenSSL; loading a key then fails.
+ */
+
+#ifndef SECURE_FRAME_H
+#define SECURE_FRAME_H
+
+#include <string>
+#include <cstdint>
+
+#define FRAME_KEY_SIZE 32
+#define FRAME_SALT_SIZE 16
+
+enum CipherSuite {
+    CIPHER_AES_256_GCM = 'a',
+    CIPHER_CHACHA20_POLY1305 = 'c'
+};
+
+// "aes-256-gcm" / "chacha20-poly1305"
+bool parse_cipher_suite(const std::string& name, CipherSuite& suite);
+const char* cipher_suite_name(CipherSuite suite);
+
+// Network key shared by all clients
+class FrameKey {
+public:
+    FrameKey();
+
+    // Key = HKDF-Extract of the file's contents.
+    // Returns: false (and sets error) if the file cannot be read or crypto is not built in
+    bool load_file(const std::string& path, std::string& error);
+
+    bool loaded() const { return is_loaded; }
+    const unsigned char* bytes() const { return key; }
+
+private:
+    unsigned char key[FRAME_KEY_SIZE];
+    bool is_loaded;
+};
+
+/*
+ * FrameSealer
+ * Encrypts the frames sent on one connection. Construct one per connection;
+ * the connection key is derived in the constructor.
+ */
+class FrameSealer {
+public:
+    FrameSealer(const FrameKey& key, CipherSuite suite);
+    ~FrameSealer();
+
+    // Returns: false if encryption failed; line is the ENC1 line to send
+    bool seal(const std::string& frame, std::string& line);
+
+private:
+    FrameSealer(const FrameSealer&);
+    FrameSealer& operator=(const FrameSealer&);
+
+    CipherSuite suite;
+    unsigned char salt[FRAME_SALT_SIZE];
+    std::string header;  // "ENC1#<suite>#<salt hex>#"
+    uint64_t seq;        // Next frame number
+    void* ctx;           // EVP_CIPHER_CTX keyed with the connection key
+    bool ready;
+};
+
+// Returns: true if line is a sealed frame (starts with ENC1#)
+bool is_sealed_frame(const std::string& line);
+
+// Decrypts and authenticates a sealed frame. The connection key of the last
+// salt seen is cached per thread, so the frames of one connection derive it once.
+// Returns: false if the line is malformed or fails authentication
+bool open_sealed_frame(const FrameKey& key, const std::string& line, std::string& frame);
+
+#endif
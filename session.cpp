@@ -0,0 +1,577 @@
+/*
+ * P2P Micropayment System - Server Session
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "session.h"
+#include "net.h"
+#include "io_backend.h"
+#include "protocol.h"
+
+#include <chrono>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+
+using namespace std;
+
+// Returns: steady_clock time in milliseconds
+static long long now_ms() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Peer Closed
+ * The server only talks when asked, so a socket that is readable between
+ * exchanges carries the server's FIN or RST.
+ */
+static bool peer_closed(int fd) {
+    char byte;
+    ssize_t received = recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return received == 0 || (received == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+}
+
+ServerSession::ServerSession()
+    : sock(-1), io(NULL), link(LINK_CLOSED), server_port(0), keepalive_seconds(KEEPALIVE_TIMEOUT), heartbeat_ms(0),
+      capture(NULL), last_exchange_ms(0), reconnect_count(0), reporter_running(false), report_in_flight(false),
+      pushing(false), reader_wakeup_read(-1), reader_wakeup_write(-1), stream_closed(false),
+      subscription(SUBSCRIPTION_PENDING) {}
+
+ServerSession::~ServerSession() {
+    // Closed first, so a reporter that is reconnecting gives up; call
+    // stop_reporter() with a timeout beforehand to get the queue out
+    close();
+    stop_reporter();
+    delete io;
+    if (reader_wakeup_read != -1) {
+        close_wakeup(reader_wakeup_read, reader_wakeup_write);
+    }
+}
+
+bool ServerSession::connect(const string& ip, int port, const string& io_backend) {
+    int fd = connect_to_server(ip, port);
+    if (fd == -1) {
+        return false;
+    }
+    lock_guard<mutex> lock(socket_mutex);
+    if (io == NULL) {
+        io = create_io_backend(io_backend, [this](const string& text) { log(text); });
+    }
+    if (keepalive_seconds > 0) {
+        ::set_keepalive(fd, keepalive_seconds);
+    }
+    if (sock != -1) {
+        stop_push();
+    }
+    replace_socket(fd);
+    server_ip = ip;
+    server_port = port;
+    last_exchange_ms = now_ms();
+    link = LINK_UP;
+    return true;
+}
+
+bool ServerSession::connected() const {
+    return link == LINK_UP;
+}
+
+bool ServerSession::closed() const {
+    return link == LINK_CLOSED;
+}
+
+/*
+ * Request
+ * Holds socket_mutex for the whole exchange because the main thread and the
+ * reporter thread share the socket. With io_uring the send and the receive
+ * are submitted in a single syscall, after a non-blocking peek that catches
+ * a server that went away while the session was idle: the request is then
+ * not sent at all, so a report can safely be sent again after reconnecting.
+ * The server always answers, so an empty response means the connection is gone.
+ * In push mode the reader thread receives, and the request waits for the
+ * next reply it queues, for at most the keepalive timeout.
+ */
+bool ServerSession::request(const string& message, string& response) {
+    lock_guard<mutex> lock(socket_mutex);
+    response.clear();
+    if (sock == -1) {
+        return false;
+    }
+    if (pushing) {
+        {
+            lock_guard<mutex> reply_lock(reply_mutex);
+            if (stream_closed) {
+                drop_connection();
+                return false;
+            }
+        }
+        // Recorded before sending: the reader may record the reply at once
+        capture_message(CAPTURE_OUT, message);
+        bool sent = send_message(sock, message);
+        if (sent) {
+            // A server that stays silent this long is treated like a dead one
+            wait_reply(response, (keepalive_seconds > 0 ? keepalive_seconds : KEEPALIVE_TIMEOUT) * 1000);
+        }
+        last_exchange_ms = now_ms();
+        if (!sent || response.empty()) {
+            drop_connection();
+        }
+        return sent;
+    }
+    if (peer_closed(sock)) {
+        drop_connection();
+        return false;
+    }
+    capture_message(CAPTURE_OUT, message);
+    bool sent = io->round_trip(sock, message, response);
+    rearm_quickack(sock);
+    if (!response.empty()) {
+        capture_message(CAPTURE_IN, response);
+    }
+    last_exchange_ms = now_ms();
+    if (!sent || response.empty()) {
+        drop_connection();
+    }
+    return sent;
+}
+
+/*
+ * Drop Connection
+ * Called with socket_mutex held after a failed exchange. Unless close() is
+ * in progress, the reporter thread starts reconnecting.
+ */
+void ServerSession::drop_connection() {
+    stop_push();
+    replace_socket(-1);
+    int up = LINK_UP;
+    if (link.compare_exchange_strong(up, LINK_DOWN)) {
+        log("Lost the connection to the server, reconnecting");
+        wake_reporter();
+    }
+}
+
+/*
+ * Replace Socket
+ * Called with socket_mutex held. Closes the current socket, if any, and
+ * installs fd. Both happen under sock_mutex as well, so close() can shut
+ * down sock without socket_mutex and never hits a descriptor that was
+ * closed (and maybe reused) in between.
+ */
+void ServerSession::replace_socket(int fd) {
+    lock_guard<mutex> sock_lock(sock_mutex);
+    if (sock != -1) {
+        ::close(sock);
+    }
+    sock = fd;
+}
+
+void ServerSession::close() {
+    // Marked closed before shutdown(), so the failing exchange does not start a reconnect
+    link = LINK_CLOSED;
+    // shutdown() first so an exchange blocked in recv() returns and releases
+    // socket_mutex; sock_mutex keeps the descriptor from being closed and
+    // reused meanwhile
+    {
+        lock_guard<mutex> sock_lock(sock_mutex);
+        if (sock != -1) {
+            shutdown(sock, SHUT_RDWR);
+        }
+    }
+    {
+        lock_guard<mutex> lock(socket_mutex);
+        if (sock != -1) {
+            stop_push();
+            replace_socket(-1);
+        }
+    }
+    wake_reporter();
+}
+
+bool ServerSession::request_and_close(const string& message, string& response) {
+    link = LINK_CLOSED;
+    bool sent = request(message, response);
+    close();
+    return sent;
+}
+
+void ServerSession::set_heartbeat(const string& ping, int interval_seconds) {
+    {
+        lock_guard<mutex> lock(socket_mutex);
+        ping_message = ping;
+    }
+    heartbeat_ms = ping.empty() || interval_seconds <= 0 ? 0 : interval_seconds * 1000LL;
+    wake_reporter();
+}
+
+void ServerSession::set_resume(const string& message, ResumeCallback callback) {
+    lock_guard<mutex> lock(socket_mutex);
+    resume_message = message;
+    on_resume = callback;
+}
+
+/*
+ * Reconnect
+ * One attempt: connect, send the resume message and let on_resume check
+ * the answer before the connection is handed to anybody else. The resume
+ * exchange uses the plain blocking round trip with a receive timeout, so a
+ * server that accepts but never answers cannot hang the reporter.
+ * Returns: true if the connection is up again
+ */
+bool ServerSession::reconnect() {
+    string ip;
+    int port;
+    {
+        lock_guard<mutex> lock(socket_mutex);
+        ip = server_ip;
+        port = server_port;
+    }
+    int fd = connect_to_server(ip, port, RECONNECT_TIMEOUT_MS);
+    if (fd == -1) {
+        return false;
+    }
+
+    lock_guard<mutex> lock(socket_mutex);
+    if (link != LINK_DOWN) {
+        ::close(fd);  // close() was called meanwhile
+        return false;
+    }
+    if (sock != -1) {
+        // The reader saw the old connection end; nobody has closed it yet
+        stop_push();
+        replace_socket(-1);
+    }
+    if (keepalive_seconds > 0) {
+        ::set_keepalive(fd, keepalive_seconds);
+    }
+    if (!resume_message.empty()) {
+        struct timeval timeout = { RECONNECT_TIMEOUT_MS / 1000, (RECONNECT_TIMEOUT_MS % 1000) * 1000 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        string response;
+        capture_message(CAPTURE_OUT, resume_message);
+        bool ok = io->IoBackend::round_trip(fd, resume_message, response) && !response.empty();
+        if (ok) {
+            capture_message(CAPTURE_IN, response);
+        }
+        ok = ok && (!on_resume || on_resume(response));
+        timeout.tv_sec = timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if (!ok) {
+            ::close(fd);
+            return false;
+        }
+    }
+    if (!subscribe_message.empty() && !start_push(fd)) {
+        ::close(fd);
+        return false;
+    }
+
+    replace_socket(fd);
+    last_exchange_ms = now_ms();
+    int down = LINK_DOWN;
+    if (!link.compare_exchange_strong(down, LINK_UP)) {
+        return false;  // close() is waiting for the lock and closes fd
+    }
+    reconnect_count++;
+    log("Reconnected to the server");
+    return true;
+}
+
+bool ServerSession::subscribe(const string& message, const string& prefix, ResumeCallback on_reply,
+                              EventCallback callback) {
+    lock_guard<mutex> lock(socket_mutex);
+    if (sock == -1 || pushing) {
+        return pushing;
+    }
+    subscribe_message = message;
+    event_prefix = prefix;
+    on_subscribed = on_reply;
+    on_event = callback;
+    if (!start_push(sock)) {
+        subscribe_message.clear();
+        return false;
+    }
+    last_exchange_ms = now_ms();
+    return true;
+}
+
+/*
+ * Start Push
+ * Called with socket_mutex held. Starts the reader on fd, then sends the
+ * subscribe message. The reader checks the answer itself, so the snapshot
+ * it carries is applied before any event that follows it on the stream. A
+ * server that does not know the message answers with an error line, which
+ * on_subscribed refuses.
+ * Returns: true if the subscription is active on fd
+ */
+bool ServerSession::start_push(int fd) {
+    if (reader_wakeup_read == -1 && !open_wakeup(reader_wakeup_read, reader_wakeup_write)) {
+        return false;
+    }
+    {
+        lock_guard<mutex> reply_lock(reply_mutex);
+        replies.clear();
+        stream_closed = false;
+        subscription = SUBSCRIPTION_PENDING;
+    }
+    pushing = true;
+    reader = thread(&ServerSession::reader_loop, this, fd);
+
+    capture_message(CAPTURE_OUT, subscribe_message);
+    bool ok = send_message(fd, subscribe_message);
+    if (ok) {
+        unique_lock<mutex> reply_lock(reply_mutex);
+        reply_cv.wait_for(reply_lock, chrono::milliseconds(RECONNECT_TIMEOUT_MS),
+                          [this] { return subscription != SUBSCRIPTION_PENDING || stream_closed; });
+        ok = subscription == SUBSCRIPTION_ACTIVE;
+    }
+    if (!ok) {
+        stop_push();
+    }
+    return ok;
+}
+
+// Called with socket_mutex held, before the socket is closed
+void ServerSession::stop_push() {
+    if (!reader.joinable()) {
+        return;
+    }
+    signal_wakeup(reader_wakeup_write);
+    reader.join();
+    clear_wakeup(reader_wakeup_read);
+    pushing = false;
+}
+
+// Returns: true and the oldest queued reply, false if the connection ended
+// or timeout_ms passed first
+bool ServerSession::wait_reply(string& response, int timeout_ms) {
+    unique_lock<mutex> lock(reply_mutex);
+    reply_cv.wait_for(lock, chrono::milliseconds(timeout_ms), [this] { return !replies.empty() || stream_closed; });
+    if (replies.empty()) {
+        return false;
+    }
+    response = replies.front();
+    replies.pop_front();
+    return true;
+}
+
+/*
+ * Reader Loop
+ * Receives everything on fd while the session is subscribed, one line at a
+ * time in stream order: events go to on_event as they arrive, other lines
+ * are collected until reply_length() says a reply is complete. When the
+ * server goes away, the reader wakes a waiting request and lets the
+ * reporter thread reconnect. It never takes socket_mutex: stop_push() joins
+ * it with that lock held.
+ */
+void ServerSession::reader_loop(int fd) {
+    struct pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = reader_wakeup_read;
+    fds[1].events = POLLIN;
+    char buffer[BUFFER_SIZE];
+    string pending;  // Received bytes not yet split into lines
+    string reply;    // Lines of the reply being received
+    bool active = false;
+
+    while (true) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            return;  // stop_push(): the connection stays open for its owner
+        }
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received == -1 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.append(buffer, received);
+
+        size_t start = 0, newline;
+        while ((newline = pending.find('\n', start)) != string::npos) {
+            size_t length = newline + 1 - start;
+            if (pending.compare(start, event_prefix.size(), event_prefix) == 0) {
+                if (active) {
+                    string line = pending.substr(start, length);
+                    capture_message(CAPTURE_IN, line);
+                    on_event(line);
+                }
+            } else {
+                reply.append(pending, start, length);
+                if (reply_length(reply) == reply.size()) {
+                    capture_message(CAPTURE_IN, reply);
+                    if (!active) {
+                        // The answer to the subscribe message
+                        active = !on_subscribed || on_subscribed(reply);
+                        lock_guard<mutex> reply_lock(reply_mutex);
+                        subscription = active ? SUBSCRIPTION_ACTIVE : SUBSCRIPTION_REFUSED;
+                    } else {
+                        lock_guard<mutex> reply_lock(reply_mutex);
+                        replies.push_back(reply);
+                    }
+                    reply_cv.notify_all();
+                    reply.clear();
+                }
+            }
+            start = newline + 1;
+        }
+        pending.erase(0, start);
+    }
+
+    {
+        lock_guard<mutex> reply_lock(reply_mutex);
+        stream_closed = true;
+    }
+    reply_cv.notify_all();
+    int up = LINK_UP;
+    if (link.compare_exchange_strong(up, LINK_DOWN)) {
+        log("Lost the connection to the server, reconnecting");
+        wake_reporter();
+    }
+}
+
+void ServerSession::wake_reporter() {
+    // Taking the lock orders the notification after the reporter's last check
+    { lock_guard<mutex> lock(report_mutex); }
+    report_cv.notify_all();
+}
+
+void ServerSession::capture_message(CaptureDirection direction, const string& message) {
+    if (capture != NULL) {
+        capture->record(CAPTURE_SERVER, direction, message);
+    }
+}
+
+void ServerSession::log(const string& text) {
+    if (on_log) {
+        on_log(text);
+    }
+}
+
+void ServerSession::start_reporter(ReportCallback callback) {
+    on_report = callback;
+    reporter_running = true;
+    reporter = thread(&ServerSession::reporter_loop, this);
+}
+
+void ServerSession::enqueue_report(const string& message) {
+    lock_guard<mutex> lock(report_mutex);
+    report_queue.push_back(message);
+    report_cv.notify_one();
+}
+
+size_t ServerSession::stop_reporter(int timeout_ms) {
+    size_t dropped = 0;
+    {
+        unique_lock<mutex> lock(report_mutex);
+        if (!reporter_running) {
+            return 0;
+        }
+        reporter_running = false;
+        report_cv.notify_all();
+
+        // While reconnecting, the reporter keeps trying until the deadline
+        chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+        if (timeout_ms >= 0 && !report_cv.wait_until(lock, deadline, [this] {
+                return (report_queue.empty() && !report_in_flight) || link == LINK_CLOSED;
+            })) {
+            dropped = report_queue.size() + (report_in_flight ? 1 : 0);
+            report_queue.clear();
+        }
+    }
+    if (dropped > 0) {
+        close();  // The server is not answering: wake the reporter from recv() or its backoff
+    }
+    reporter.join();
+
+    // Reports that could not be sent because the session was closed
+    lock_guard<mutex> lock(report_mutex);
+    dropped += report_queue.size();
+    report_queue.clear();
+    return dropped;
+}
+
+/*
+ * Reporter Loop
+ * Sends queued TRANSACTION reports to the server one at a time. In between
+ * it reconnects a lost session with exponential backoff and pings an idle
+ * one. A report whose send failed goes back to the front of the queue; one
+ * that was sent but never answered is not sent again, since the server may
+ * have applied it.
+ */
+void ServerSession::reporter_loop() {
+    int delay_ms = RECONNECT_DELAY_MS;
+    unique_lock<mutex> lock(report_mutex);
+    while (true) {
+        if (link == LINK_DOWN) {
+            lock.unlock();
+            bool up = reconnect();
+            lock.lock();
+            if (up) {
+                delay_ms = RECONNECT_DELAY_MS;
+            } else {
+                // close() (also from stop_reporter() at its deadline) cuts the wait short
+                report_cv.wait_for(lock, chrono::milliseconds(delay_ms), [this] { return link != LINK_DOWN; });
+                delay_ms = min(delay_ms * 2, RECONNECT_MAX_DELAY_MS);
+            }
+            continue;
+        }
+
+        if (link == LINK_UP && !report_queue.empty()) {
+            string transaction_msg = report_queue.front();
+            report_queue.pop_front();
+            report_in_flight = true;
+            lock.unlock();
+
+            string response;
+            bool sent = request(transaction_msg, response);
+            if (sent && on_report) {
+                on_report(transaction_msg, response);
+            }
+
+            lock.lock();
+            if (!sent) {
+                report_queue.push_front(transaction_msg);  // Sent again after the reconnect
+            }
+            report_in_flight = false;
+            report_cv.notify_all();  // stop_reporter() may be waiting for the queue to empty
+            continue;
+        }
+
+        if (!reporter_running) {
+            return;  // Stopped and nothing left to send (or closed)
+        }
+
+        long long interval = heartbeat_ms;
+        if (link != LINK_UP || interval == 0) {
+            report_cv.wait(lock);
+            continue;
+        }
+        long long idle = now_ms() - last_exchange_ms;
+        if (idle < interval) {
+            report_cv.wait_for(lock, chrono::milliseconds(interval - idle));
+            continue;
+        }
+
+        // Heartbeat: a failed ping drops the connection and starts the reconnect
+        lock.unlock();
+        string ping;
+        {
+            lock_guard<mutex> socket_lock(socket_mutex);
+            ping = ping_message;
+        }
+        string response;
+        if (!ping.empty()) {
+            request(ping, response);
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,198 @@
+/*
+ * P2P Micropayment System - Server Session
+ * Course: Computer Networks (Fall 2025)
+ *
+ * The persistent connection to the server. The TA's server expects one
+ * connection for the whole program (Register, Login, List, TRANSACTION, Exit),
+ * so every request from any thread goes through this object, one
+ * request/response exchange at a time.
+ *
+ * TRANSACTION reports for incoming transfers are queued and sent by a
+ * reporter thread, so listener threads never wait on the server.
+ *
+ * The reporter thread also keeps the connection alive: it pings an idle
+ * server (set_heartbeat()), and when an exchange fails it reconnects with
+ * exponential backoff, logs in again with the resume message and then sends
+ * the reports that queued up meanwhile. TCP keepalive (set_keepalive())
+ * lets the kernel notice a dead server even while nothing is sent.
+ *
+ * A session can also subscribe to events the server pushes between replies
+ * (subscribe()). A reader thread then owns the receiving side: it hands
+ * event lines to a callback as they arrive and queues everything else as
+ * the replies that request() waits for.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+#include "capture.h"
+
+#define HEARTBEAT_INTERVAL 10        // Default seconds of silence before the server is pinged
+#define KEEPALIVE_TIMEOUT 30         // Default seconds until the kernel gives up on a silent server
+#define RECONNECT_DELAY_MS 100       // Wait before the second reconnect attempt; doubles each time
+#define RECONNECT_MAX_DELAY_MS 5000  // Longest wait between reconnect attempts
+#define RECONNECT_TIMEOUT_MS 2000    // connect() timeout of one reconnect attempt
+
+class IoBackend;
+
+class ServerSession {
+public:
+    // Called by the reporter thread after each report; response is empty
+    // when the report could not be sent or the server did not answer
+    typedef std::function<void(const std::string& report, const std::string& response)> ReportCallback;
+    // Called with the server's answer to the resume message after a reconnect.
+    // Runs with the connection locked, so it must not call request().
+    // Returns: false to drop the new connection and try again later
+    typedef std::function<bool(const std::string& response)> ResumeCallback;
+    // Connection lost / restored
+    typedef std::function<void(const std::string& text)> LogCallback;
+    // Called by the reader thread with each pushed event line; it must not call request()
+    typedef std::function<void(const std::string& line)> EventCallback;
+
+    ServerSession();
+    ~ServerSession();
+
+    // Connects to the server. io_backend selects the I/O strategy used for
+    // request/response exchanges (see io_backend.h).
+    bool connect(const std::string& ip, int port, const std::string& io_backend);
+
+    // true while the connection is up; false while reconnecting or after close()
+    bool connected() const;
+    // true before connect() and after close(); reports queued now are never sent
+    bool closed() const;
+
+    // Sends one request and receives the reply. A failed exchange drops the
+    // connection and the reporter thread starts reconnecting.
+    // Returns: false if the request could not be sent; response is empty
+    //          when the server did not answer
+    bool request(const std::string& message, std::string& response);
+
+    // Closes the connection for good (wakes up a reporter blocked on the server)
+    void close();
+
+    // Last exchange (e.g. Exit), then close(). The session counts as closed
+    // from the start, so the server hanging up after its answer does not
+    // start a reconnect.
+    // Returns: like request()
+    bool request_and_close(const std::string& message, std::string& response);
+
+    // Kernel-level dead peer detection: keepalive probes on an idle
+    // connection and TCP_USER_TIMEOUT for unacknowledged data, both about
+    // timeout_seconds (0 = off, default KEEPALIVE_TIMEOUT). Applies to the
+    // next connect.
+    void set_keepalive(int timeout_seconds) { keepalive_seconds = timeout_seconds; }
+
+    // Sends ping (e.g. List) whenever the connection was idle for
+    // interval_seconds (0 or an empty ping = off); the answer is discarded.
+    void set_heartbeat(const std::string& ping, int interval_seconds);
+
+    // Message sent first on every new connection after a reconnect (e.g. the
+    // login), and the callback that checks its answer. Empty = none.
+    void set_resume(const std::string& message, ResumeCallback on_resume);
+
+    void set_log(LogCallback callback) { on_log = callback; }
+
+    // Records every request, reply and pushed event in log (NULL = off).
+    // Call before connect().
+    void set_capture(CaptureLog* log) { capture = log; }
+
+    // Sends message (e.g. SUBSCRIBE) and switches to push mode: from now on
+    // lines starting with event_prefix go to on_event, and on_reply checks
+    // the answer to message. Both run on the reader thread, in the order the
+    // server sent them. The subscription is repeated after every reconnect.
+    // Returns: false if the server did not answer within RECONNECT_TIMEOUT_MS
+    //          or on_reply refused the answer; the session stays in
+    //          request/response mode
+    // Replies are framed with reply_length() (see protocol.h).
+    bool subscribe(const std::string& message, const std::string& event_prefix, ResumeCallback on_reply,
+                   EventCallback on_event);
+    bool subscribed() const { return pushing; }
+
+    // Connections re-established so far
+    unsigned long reconnects() const { return reconnect_count; }
+
+    // Starts the reporter thread; reports are sent in FIFO order
+    void start_reporter(ReportCallback on_report);
+    void enqueue_report(const std::string& message);
+
+    // Stops the reporter thread once the queued reports are sent, waiting at
+    // most timeout_ms (-1 = no limit). At the deadline the remaining reports
+    // are dropped and an exchange still waiting for the server is cut off by
+    // closing the connection.
+    // Returns: number of reports dropped or cut off
+    size_t stop_reporter(int timeout_ms = -1);
+
+private:
+    enum LinkState {
+        LINK_CLOSED,  // Not connected on purpose: nothing is sent or retried
+        LINK_UP,
+        LINK_DOWN     // Lost: the reporter thread is reconnecting
+    };
+
+    enum SubscriptionState {
+        SUBSCRIPTION_PENDING,  // Subscribe message sent, answer not checked yet
+        SUBSCRIPTION_ACTIVE,
+        SUBSCRIPTION_REFUSED
+    };
+
+    void reporter_loop();
+    bool reconnect();
+    void drop_connection();
+    void wake_reporter();
+    void log(const std::string& text);
+    bool start_push(int fd);
+    void stop_push();
+    void reader_loop(int fd);
+    bool wait_reply(std::string& response, int timeout_ms);
+    void replace_socket(int fd);
+    void capture_message(CaptureDirection direction, const std::string& message);
+
+    int sock;                       // Socket for persistent connection to server
+    IoBackend* io;                  // Backend used for request/response on sock
+    mutable std::mutex socket_mutex;  // Protects sock and the settings below
+    std::mutex sock_mutex;          // Also held while sock is replaced; close() shuts sock down under it
+    std::atomic<int> link;          // LinkState; atomic so close() can set it during an exchange
+    std::string server_ip;          // Where to reconnect to
+    int server_port;
+    int keepalive_seconds;
+    std::string ping_message;
+    std::atomic<long long> heartbeat_ms;      // 0 = no heartbeat
+    std::string resume_message;
+    ResumeCallback on_resume;
+    LogCallback on_log;
+    CaptureLog* capture;            // NULL = not capturing
+    std::atomic<long long> last_exchange_ms;  // steady_clock time of the last exchange
+    std::atomic<unsigned long> reconnect_count;
+
+    std::deque<std::string> report_queue;  // TRANSACTION reports waiting to be sent
+    std::mutex report_mutex;
+    std::condition_variable report_cv;   // New report, report sent, or stop
+    bool reporter_running;
+    bool report_in_flight;                // Reporter is waiting for the server
+    std::thread reporter;
+    ReportCallback on_report;
+
+    std::string subscribe_message;  // Empty = not subscribed (socket_mutex)
+    std::string event_prefix;
+    ResumeCallback on_subscribed;
+    EventCallback on_event;
+    std::atomic<bool> pushing;      // The reader thread owns the receiving side of sock
+    std::thread reader;
+    int reader_wakeup_read;         // Pipe that stops the reader
+    int reader_wakeup_write;
+    std::deque<std::string> replies;  // Complete replies the reader received
+    bool stream_closed;               // The reader saw the connection end
+    SubscriptionState subscription;   // Outcome of the reader's subscribe exchange
+    std::mutex reply_mutex;           // Protects replies, stream_closed and subscription
+    std::condition_variable reply_cv;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * P2P Micropayment System - Net Settlement
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "settlement.h"
+#include "protocol.h"
+
+#include <chrono>
+
+using namespace std;
+
+Settlement::Settlement()
+    : mode(SETTLE_OFF), window_ms(SETTLE_WINDOW_MS), threshold(0), transfer_count(0), report_count(0),
+      running(false) {}
+
+Settlement::~Settlement() {
+    stop();
+}
+
+bool Settlement::open_journal(const string& path, string& error) {
+    lock_guard<mutex> lock(settle_mutex);
+    journal.open(path.c_str(), ios::out | ios::app);
+    if (!journal.is_open()) {
+        error = "Cannot open journal " + path;
+        return false;
+    }
+    return true;
+}
+
+void Settlement::start(SettlementMode settle_mode, int window, long long settle_threshold, ReportSink report_sink) {
+    lock_guard<mutex> lock(settle_mutex);
+    if (running || settle_mode == SETTLE_OFF) {
+        return;
+    }
+    mode = settle_mode;
+    window_ms = window > 0 ? window : SETTLE_WINDOW_MS;
+    threshold = settle_threshold;
+    sink = report_sink;
+    running = true;
+    flusher = thread(&Settlement::flush_loop, this);
+}
+
+void Settlement::record_incoming(const string& self_name, const string& sender, int amount,
+                                 const string& transfer_id) {
+    record(self_name, sender, amount, true, transfer_id);
+}
+
+void Settlement::record_outgoing(const string& self_name, const string& recipient, int amount,
+                                 const string& transfer_id) {
+    record(self_name, recipient, -(long long)amount, false, transfer_id);
+}
+
+/*
+ * Record
+ * amount is signed: positive = paid to us. Transfers whose pair is settled
+ * elsewhere (the recipient in aggregate mode, the other party in net mode)
+ * only go to the journal.
+ */
+void Settlement::record(const string& self_name, const string& counterparty, long long amount, bool incoming,
+                        const string& transfer_id) {
+    vector<string> out;
+    {
+        lock_guard<mutex> lock(settle_mutex);
+        self = self_name;
+        transfer_count++;
+        if (journal.is_open()) {
+            journal << (incoming ? "IN#" : "OUT#") << counterparty << '#' << (incoming ? amount : -amount) << '#'
+                    << transfer_id << '\n';
+        }
+        bool ours = mode == SETTLE_NET ? self < counterparty : incoming;
+        if (!ours) {
+            return;
+        }
+
+        Position& position = positions[counterparty];
+        position.net += amount;
+        position.transfers++;
+        if (threshold > 0 && (position.net >= threshold || position.net <= -threshold)) {
+            settle(counterparty, position, out);
+            positions.erase(counterparty);
+        }
+    }
+    for (const string& report : out) {
+        sink(report);
+    }
+}
+
+/*
+ * Settle
+ * Turns one position into a TRANSACTION message; a position that netted
+ * out to zero needs none.
+ */
+void Settlement::settle(const string& counterparty, const Position& position, vector<string>& out) {
+    if (position.net == 0) {
+        return;
+    }
+    const string& payer = position.net > 0 ? counterparty : self;
+    const string& payee = position.net > 0 ? self : counterparty;
+    string amount = to_string(position.net > 0 ? position.net : -position.net);
+    out.push_back(make_transaction_message(payer, payee, amount));
+    report_count++;
+    if (journal.is_open()) {
+        journal << "SETTLE#" << payer << '#' << payee << '#' << amount << '#' << position.transfers << '\n';
+    }
+}
+
+size_t Settlement::flush() {
+    vector<string> out;
+    {
+        lock_guard<mutex> lock(settle_mutex);
+        for (const auto& entry : positions) {
+            settle(entry.first, entry.second, out);
+        }
+        positions.clear();
+        if (journal.is_open()) {
+            journal.flush();
+        }
+    }
+    for (const string& report : out) {
+        sink(report);
+    }
+    return out.size();
+}
+
+void Settlement::flush_loop() {
+    unique_lock<mutex> lock(settle_mutex);
+    while (running) {
+        stop_cv.wait_for(lock, chrono::milliseconds(window_ms));
+        if (!running) {
+            break;
+        }
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+bool Settlement::stop() {
+    {
+        lock_guard<mutex> lock(settle_mutex);
+        if (!running) {
+            return false;
+        }
+        running = false;
+    }
+    stop_cv.notify_all();
+    flusher.join();
+    flush();
+    return true;
+}
+
+unsigned long Settlement::transfers() const {
+    lock_guard<mutex> lock(settle_mutex);
+    return transfer_count;
+}
+
+unsigned long Settlement::reports() const {
+    lock_guard<mutex> lock(settle_mutex);
+    return report_count;
+}
@@ -0,0 +1,110 @@
+/*
+ * P2P Micropayment System - Net Settlement
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Without settlement every incoming transfer costs one TRANSACTION exchange
+ * with the server. With it, transfers are added to a position per
+ * counterparty and reported in bulk: one TRANSACTION per counterparty at the
+ * end of each window, or as soon as a position reaches the threshold.
+ *
+ * Two modes:
+ * - SETTLE_AGGREGATE: the position is the sum of incoming transfers from a
+ *   sender, reported as TRANSACTION#<sender>#<us>#<total>. Works with any
+ *   peer and any server.
+ * - SETTLE_NET: transfers in both directions are netted. Each pair of users
+ *   is settled by the one whose name sorts first; it reports the net amount
+ *   in whichever direction it points (TRANSACTION#<payer>#<payee>#<net>),
+ *   and the other side reports nothing for the pair. Every client must use
+ *   this mode, and the server must accept a report from either party.
+ *   An outgoing transfer counts once send_transfer() succeeded; one that
+ *   failed after reaching the recipient is not reported by anyone.
+ *
+ * The optional journal keeps the detail that the reports no longer carry:
+ * one line per transfer and per report,
+ *   IN#<sender>#<amount>#<id>, OUT#<recipient>#<amount>#<id>,
+ *   SETTLE#<payer>#<payee>#<amount>#<transfers>
+ * written out at the end of each window.
+ */
+
+#ifndef SETTLEMENT_H
+#define SETTLEMENT_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+
+#define SETTLE_WINDOW_MS 1000  // Default time a transfer waits before it is reported
+
+enum SettlementMode {
+    SETTLE_OFF,        // One TRANSACTION per transfer
+    SETTLE_AGGREGATE,  // Incoming transfers summed per sender
+    SETTLE_NET         // Both directions netted per pair
+};
+
+class Settlement {
+public:
+    // Queues a TRANSACTION message for the server
+    typedef std::function<void(const std::string& report)> ReportSink;
+
+    Settlement();
+    ~Settlement();
+
+    // Appends the journal to path.
+    // Returns: false (and sets error) if the file cannot be opened
+    bool open_journal(const std::string& path, std::string& error);
+
+    // Starts the flush thread. threshold = report a counterparty as soon as
+    // its position reaches this amount either way (0 = at the window only).
+    void start(SettlementMode mode, int window_ms, long long threshold, ReportSink sink);
+    bool enabled() const { return mode != SETTLE_OFF; }
+
+    // Transfer from sender to self (credited to the ledger)
+    void record_incoming(const std::string& self, const std::string& sender, int amount,
+                         const std::string& transfer_id);
+    // Transfer from self to recipient (sent successfully)
+    void record_outgoing(const std::string& self, const std::string& recipient, int amount,
+                         const std::string& transfer_id);
+
+    // Reports every open position now.
+    // Returns: number of TRANSACTION messages queued
+    size_t flush();
+
+    // Final flush; joins the flush thread.
+    // Returns: false if it was not running (not started, or stopped before)
+    bool stop();
+
+    unsigned long transfers() const;  // Transfers recorded so far
+    unsigned long reports() const;    // TRANSACTION messages queued so far
+
+private:
+    struct Position {
+        long long net;       // Incoming minus outgoing
+        unsigned transfers;
+    };
+
+    void record(const std::string& self, const std::string& counterparty, long long amount, bool incoming,
+                const std::string& transfer_id);
+    void settle(const std::string& counterparty, const Position& position, std::vector<std::string>& out);
+    void flush_loop();
+
+    SettlementMode mode;
+    int window_ms;
+    long long threshold;
+    ReportSink sink;
+    std::string self;                                     // Our username, from the last transfer
+    std::unordered_map<std::string, Position> positions;  // Counterparty -> open position
+    std::ofstream journal;
+    unsigned long transfer_count;
+    unsigned long report_count;
+    mutable std::mutex settle_mutex;  // Protects everything above
+    std::condition_variable stop_cv;
+    bool running;
+    std::thread flusher;
+};
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ * P2P Micropayment System - Signed Transfer Frames
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "signing.h"
+#include "hex.h"
+
+#include <dirent.h>
+#ifndef P2PPAY_NO_CRYPTO
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#endif
+
+using namespace std;
+
+#define VERIFY_GRAIN 8  // Signatures per chunk handed to another thread
+
+bool decode_signature(const string& hex, unsigned char* signature) {
+    return hex.size() == 2 * SIGNATURE_SIZE && decode_hex(hex.data(), hex.size(), signature);
+}
+
+void verify_signatures(SignatureCheck* checks, size_t count, WorkerPool& pool) {
+    pool.parallel_for(count, VERIFY_GRAIN, [checks](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            SignatureCheck& check = checks[i];
+            check.valid = check.public_key != NULL &&
+                          verify_signature(check.public_key, check.data, check.length, check.signature);
+        }
+    });
+}
+
+#ifdef P2PPAY_NO_CRYPTO
+
+SigningKey::SigningKey() : pkey(NULL) {}
+SigningKey::~SigningKey() {}
+
+bool SigningKey::load_file(const string&, string& error) {
+    error = "built without OpenSSL (NO_CRYPTO=1), signatures are not available";
+    return false;
+}
+
+bool SigningKey::generate() {
+    return false;
+}
+
+bool SigningKey::sign(const char*, size_t, string&) const {
+    return false;
+}
+
+TrustStore::TrustStore() {}
+TrustStore::~TrustStore() {}
+
+bool TrustStore::load_dir(const string&, string& error) {
+    error = "built without OpenSSL (NO_CRYPTO=1), signatures are not available";
+    return false;
+}
+
+bool TrustStore::add(const string&, const SigningKey&) {
+    return false;
+}
+
+const void* TrustStore::find(const string&) const {
+    return NULL;
+}
+
+bool verify_signature(const void*, const char*, size_t, const unsigned char*) {
+    return false;
+}
+
+#else
+
+SigningKey::SigningKey() : pkey(NULL) {}
+
+SigningKey::~SigningKey() {
+    EVP_PKEY_free((EVP_PKEY*)pkey);
+}
+
+bool SigningKey::load_file(const string& path, string& error) {
+    BIO* file = BIO_new_file(path.c_str(), "r");
+    if (file == NULL) {
+        error = "cannot read signing key " + path;
+        return false;
+    }
+    EVP_PKEY* key = PEM_read_bio_PrivateKey(file, NULL, NULL, NULL);
+    BIO_free(file);
+    if (key == NULL || EVP_PKEY_base_id(key) != EVP_PKEY_ED25519) {
+        EVP_PKEY_free(key);
+        error = path + " is not an Ed25519 private key (PEM)";
+        return false;
+    }
+    EVP_PKEY_free((EVP_PKEY*)pkey);
+    pkey = key;
+    return true;
+}
+
+bool SigningKey::generate() {
+    EVP_PKEY* key = NULL;
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, NULL);
+    bool ok = ctx != NULL && EVP_PKEY_keygen_init(ctx) > 0 && EVP_PKEY_keygen(ctx, &key) > 0;
+    EVP_PKEY_CTX_free(ctx);
+    if (!ok) {
+        return false;
+    }
+    EVP_PKEY_free((EVP_PKEY*)pkey);
+    pkey = key;
+    return true;
+}
+
+bool SigningKey::sign(const char* data, size_t length, string& signature) const {
+    if (pkey == NULL) {
+        return false;
+    }
+    unsigned char raw[SIGNATURE_SIZE];
+    size_t raw_length = sizeof(raw);
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    bool ok = ctx != NULL &&
+              EVP_DigestSignInit(ctx, NULL, NULL, NULL, (EVP_PKEY*)pkey) == 1 &&
+              EVP_DigestSign(ctx, raw, &raw_length, (const unsigned char*)data, length) == 1;
+    EVP_MD_CTX_free(ctx);
+    if (!ok) {
+        return false;
+    }
+    signature.clear();
+    append_hex(signature, raw, raw_length);
+    return true;
+}
+
+TrustStore::TrustStore() {}
+
+TrustStore::~TrustStore() {
+    for (auto& entry : keys) {
+        EVP_PKEY_free((EVP_PKEY*)entry.second);
+    }
+}
+
+bool TrustStore::load_dir(const string& dir, string& error) {
+    DIR* entries = opendir(dir.c_str());
+    if (entries == NULL) {
+        error = "cannot open key directory " + dir;
+        return false;
+    }
+    const string suffix = ".pub";
+    bool ok = true;
+    struct dirent* entry;
+    while (ok && (entry = readdir(entries)) != NULL) {
+        string file = entry->d_name;
+        if (file.size() <= suffix.size() || file.compare(file.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        string path = dir + "/" + file;
+        BIO* bio = BIO_new_file(path.c_str(), "r");
+        EVP_PKEY* key = bio != NULL ? PEM_read_bio_PUBKEY(bio, NULL, NULL, NULL) : NULL;
+        BIO_free(bio);
+        if (key == NULL || EVP_PKEY_base_id(key) != EVP_PKEY_ED25519) {
+            EVP_PKEY_free(key);
+            error = path + " is not an Ed25519 public key (PEM)";
+            ok = false;
+            break;
+        }
+        void*& slot = keys[file.substr(0, file.size() - suffix.size())];
+        EVP_PKEY_free((EVP_PKEY*)slot);
+        slot = key;
+    }
+    closedir(entries);
+    if (ok && keys.empty()) {
+        error = "no <username>.pub keys in " + dir;
+        ok = false;
+    }
+    return ok;
+}
+
+bool TrustStore::add(const string& user, const SigningKey& key) {
+    unsigned char raw[32];
+    size_t raw_length = sizeof(raw);
+    if (key.pkey == NULL || EVP_PKEY_get_raw_public_key((EVP_PKEY*)key.pkey, raw, &raw_length) != 1) {
+        return false;
+    }
+    EVP_PKEY* public_key = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, NULL, raw, raw_length);
+    if (public_key == NULL) {
+        return false;
+    }
+    void*& slot = keys[user];
+    EVP_PKEY_free((EVP_PKEY*)slot);
+    slot = public_key;
+    return true;
+}
+
+const void* TrustStore::find(const string& user) const {
+    auto it = keys.find(user);
+    return it == keys.end() ? NULL : it->second;
+}
+
+// One digest context per thread, reset between signatures
+struct VerifyContext {
+    EVP_MD_CTX* ctx;
+
+    VerifyContext() : ctx(EVP_MD_CTX_new()) {}
+    ~VerifyContext() { EVP_MD_CTX_free(ctx); }
+};
+
+bool verify_signature(const void* public_key, const char* data, size_t length, const unsigned char* signature) {
+    static thread_local VerifyContext context;
+    if (context.ctx == NULL) {
+        return false;
+    }
+    bool valid = EVP_DigestVerifyInit(context.ctx, NULL, NULL, NULL, (EVP_PKEY*)public_key) == 1 &&
+                 EVP_DigestVerify(context.ctx, signature, SIGNATURE_SIZE, (const unsigned char*)data, length) == 1;
+    EVP_MD_CTX_reset(context.ctx);
+    return valid;
+}
+
+#endif
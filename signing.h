@@ -0,0 +1,109 @@
+/*
+ * P2P Micropayment System - Signed Transfer Frames
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Every client may sign the transfers it sends with its own Ed25519 key
+ * (--signing-key), and a receiver with a trust store (--trusted-keys) only
+ * accepts transfers whose signature matches the public key on file for the
+ * sender. The signature covers the frame exactly as sent, up to the '#'
+ * before it:
+ *
+ *   <sender>#<amount>#<recipient>#<transfer id>#<signature: 128 hex>\r\n
+ *
+ * Keys are ordinary PEM files:
+ *   openssl genpkey -algorithm ed25519 -out alice.key
+ *   openssl pkey -in alice.key -pubout -out keys/alice.pub
+ *
+ * Verification is the expensive half (~2-3x a signature), so a burst of
+ * frames is checked as a batch spread over a WorkerPool. OpenSSL has no
+ * batch Ed25519 verification; each signature is still checked on its own.
+ * Build with NO_CRYPTO=1 to leave out OpenSSL; loading keys then fails.
+ */
+
+#ifndef SIGNING_H
+#define SIGNING_H
+
+#include <string>
+#include <unordered_map>
+
+#include "worker_pool.h"
+
+#define SIGNATURE_SIZE 64  // Ed25519 signature bytes (128 hex digits on the wire)
+
+// Our Ed25519 private key
+class SigningKey {
+public:
+    SigningKey();
+    ~SigningKey();
+
+    // Reads a PEM private key (openssl genpkey -algorithm ed25519).
+    // Returns: false (and sets error) if it cannot be read or is not Ed25519
+    bool load_file(const std::string& path, std::string& error);
+
+    // Creates a new random key (benchmarks and tests)
+    bool generate();
+
+    bool loaded() const { return pkey != NULL; }
+
+    // Signs data[0, length); signature gets 128 hex digits.
+    // Returns: false if signing failed. Safe to call from several threads.
+    bool sign(const char* data, size_t length, std::string& signature) const;
+
+private:
+    SigningKey(const SigningKey&);
+    SigningKey& operator=(const SigningKey&);
+
+    friend class TrustStore;
+    void* pkey;  // EVP_PKEY
+};
+
+/*
+ * TrustStore
+ * Public keys of the users we accept transfers from: <dir>/<username>.pub.
+ * Read-only after loading, so listener threads look keys up without locks.
+ */
+class TrustStore {
+public:
+    TrustStore();
+    ~TrustStore();
+
+    // Loads every <username>.pub in dir.
+    // Returns: false (and sets error) if dir cannot be read, a key is not an
+    //          Ed25519 public key, or there are no keys at all
+    bool load_dir(const std::string& dir, std::string& error);
+
+    // Trusts the public half of key for user (benchmarks and tests)
+    bool add(const std::string& user, const SigningKey& key);
+
+    bool loaded() const { return !keys.empty(); }
+    size_t size() const { return keys.size(); }
+
+    // Returns: user's public key (for SignatureCheck), NULL if unknown
+    const void* find(const std::string& user) const;
+
+private:
+    TrustStore(const TrustStore&);
+    TrustStore& operator=(const TrustStore&);
+
+    std::unordered_map<std::string, void*> keys;  // username -> EVP_PKEY
+};
+
+// One signature to check
+struct SignatureCheck {
+    const void* public_key;                   // From TrustStore::find()
+    const char* data;                         // Signed bytes
+    size_t length;
+    unsigned char signature[SIGNATURE_SIZE];
+    bool valid;                               // Result
+};
+
+// Returns: false if hex is not a 128-digit signature
+bool decode_signature(const std::string& hex, unsigned char* signature);
+
+// Returns: true if signature is valid for data[0, length) under public_key
+bool verify_signature(const void* public_key, const char* data, size_t length, const unsigned char* signature);
+
+// Checks checks[0, count), spread over pool; sets valid on each
+void verify_signatures(SignatureCheck* checks, size_t count, WorkerPool& pool);
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * P2P Micropayment System - Slab Pool
+ * Course: Computer Networks (Fall 2025)
+ *
+ * Fixed-size object pool for short-lived per-connection state. Objects are
+ * carved out of blocks of SLAB_BLOCK_OBJECTS and recycled through a free list,
+ * so after warm-up accepting and closing connections never calls malloc.
+ * Blocks are only returned to the system when the pool is destroyed.
+ *
+ * A pool is owned by one worker (e.g. one listener shard) and is not
+ * thread-safe. acquire() returns default-constructed objects; release()
+ * destroys them.
+ */
+
+#ifndef SLAB_POOL_H
+#define SLAB_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#define SLAB_BLOCK_OBJECTS 64  // Objects allocated at once when the free list is empty
+
+template <class T>
+class SlabPool {
+public:
+    SlabPool() : free_list(NULL), used(0) {}
+
+    ~SlabPool() {
+        for (Slot* block : blocks) {
+            ::operator delete(block);
+        }
+    }
+
+    T* acquire() {
+        if (free_list == NULL) {
+            grow();
+        }
+        Slot* slot = free_list;
+        free_list = slot->next;
+        used++;
+        return new (slot->storage) T();
+    }
+
+    void release(T* object) {
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = free_list;
+        free_list = slot;
+        used--;
+    }
+
+    size_t in_use() const { return used; }
+    size_t capacity() const { return blocks.size() * SLAB_BLOCK_OBJECTS; }
+    size_t bytes() const { return capacity() * sizeof(Slot); }
+
+private:
+    SlabPool(const SlabPool&);
+    SlabPool& operator=(const SlabPool&);
+
+    union Slot {
+        Slot* next;                                  // While on the free list
+        alignas(T) unsigned char storage[sizeof(T)]; // While in use
+    };
+
+    void grow() {
+        Slot* block = static_cast<Slot*>(::operator new(sizeof(Slot) * SLAB_BLOCK_OBJECTS));
+        blocks.push_back(block);
+        for (int i = SLAB_BLOCK_OBJECTS - 1; i >= 0; i--) {
+            block[i].next = free_list;
+            free_list = &block[i];
+        }
+    }
+
+    std::vector<Slot*> blocks;
+    Slot* free_list;
+    size_t used;
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * P2P Micropayment System - Socket Tuning Profile
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "socket_profile.h"
+
+#include <iostream>
+#include <cstring>
+#include <atomic>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <errno.h>
+
+using namespace std;
+
+// Options that can fail; each one is reported at most once
+enum TunedOption {
+    OPTION_NODELAY,
+    OPTION_QUICKACK,
+    OPTION_RCVBUF,
+    OPTION_SNDBUF,
+    OPTION_BUSY_POLL,
+    OPTION_FASTOPEN
+};
+
+static SocketProfile active_profile = { DEFAULT_SOCKET_PROFILE, true, true, 0, 0, 0, false };
+static atomic<unsigned> warned_options(0);
+
+bool parse_socket_profile(const string& name, SocketProfile& profile) {
+    SocketProfile parsed = { name, true, true, 0, 0, 0, false };
+    if (name == "kernel") {
+        parsed.nodelay = false;
+        parsed.quickack = false;
+    } else if (name == "busy-poll") {
+        parsed.busy_poll_us = BUSY_POLL_US;
+    } else if (name == "fastopen") {
+        parsed.fastopen = true;
+    } else if (name != "low-latency") {
+        return false;
+    }
+    profile = parsed;
+    return true;
+}
+
+void set_socket_profile(const SocketProfile& profile) {
+    active_profile = profile;
+}
+
+const SocketProfile& socket_profile() {
+    return active_profile;
+}
+
+/*
+ * Set Option
+ * setsockopt() with a one-time warning, so a refused option (e.g.
+ * SO_BUSY_POLL without CAP_NET_ADMIN) does not flood the console.
+ */
+static void set_option(int sock, int level, int option, int value, TunedOption which, const char* name) {
+    if (setsockopt(sock, level, option, &value, sizeof(value)) == 0) {
+        return;
+    }
+    unsigned bit = 1u << which;
+    if (!(warned_options.fetch_or(bit) & bit)) {
+        cerr << "Warning: cannot set " << name << ": " << strerror(errno) << endl;
+    }
+}
+
+/*
+ * Tune Socket
+ * Peer sockets only send one frame, so they skip the receive-side options
+ * (busy polling). Listening sockets get everything that accepted sockets
+ * inherit, so the accept path does not pay an extra syscall per connection.
+ */
+void tune_socket(int sock, SocketRole role) {
+    const SocketProfile& profile = active_profile;
+    if (profile.nodelay) {
+        set_option(sock, IPPROTO_TCP, TCP_NODELAY, 1, OPTION_NODELAY, "TCP_NODELAY");
+    }
+    if (profile.rcvbuf > 0) {
+        set_option(sock, SOL_SOCKET, SO_RCVBUF, profile.rcvbuf, OPTION_RCVBUF, "SO_RCVBUF");
+    }
+    if (profile.sndbuf > 0) {
+        set_option(sock, SOL_SOCKET, SO_SNDBUF, profile.sndbuf, OPTION_SNDBUF, "SO_SNDBUF");
+    }
+#ifdef TCP_QUICKACK
+    if (profile.quickack && role != SOCKET_LISTEN) {
+        set_option(sock, IPPROTO_TCP, TCP_QUICKACK, 1, OPTION_QUICKACK, "TCP_QUICKACK");
+    }
+#endif
+#ifdef SO_BUSY_POLL
+    if (profile.busy_poll_us > 0 && role != SOCKET_PEER) {
+        set_option(sock, SOL_SOCKET, SO_BUSY_POLL, profile.busy_poll_us, OPTION_BUSY_POLL, "SO_BUSY_POLL");
+    }
+#endif
+    if (profile.fastopen) {
+#if defined(TCP_FASTOPEN_CONNECT) && defined(TCP_FASTOPEN)
+        if (role == SOCKET_PEER) {
+            // connect() returns at once and the first send() goes out with the SYN
+            set_option(sock, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, 1, OPTION_FASTOPEN, "TCP_FASTOPEN_CONNECT");
+        } else if (role == SOCKET_LISTEN) {
+            set_option(sock, IPPROTO_TCP, TCP_FASTOPEN, FASTOPEN_QUEUE, OPTION_FASTOPEN, "TCP_FASTOPEN");
+        }
+#endif
+    }
+    (void)role;
+}
+
+void rearm_quickack(int sock) {
+#ifdef TCP_QUICKACK
+    if (active_profile.quickack) {
+        set_option(sock, IPPROTO_TCP, TCP_QUICKACK, 1, OPTION_QUICKACK, "TCP_QUICKACK");
+    }
+#else
+    (void)sock;
+#endif
+}
@@ -0,0 +1,67 @@
+/*
+ * P2P Micropayment System - Socket Tuning Profile
+ * Course: Computer Networks (Fall 2025)
+ *
+ * One set of socket options applied to every socket the client opens: the
+ * server session, outgoing transfer connections and the P2P listening
+ * sockets (accepted connections inherit the listener's options). Frames are
+ * tiny, so the options are about latency rather than throughput:
+ * - TCP_NODELAY:  no Nagle delay for a small write while data is unacknowledged
+ * - TCP_QUICKACK: acknowledge right away instead of after the delayed-ACK
+ *                 timer; re-armed after every server exchange (Linux)
+ * - SO_RCVBUF / SO_SNDBUF: fixed buffer sizes instead of autotuning
+ * - SO_BUSY_POLL: spin on the device queue for a few microseconds before
+ *                 sleeping in recv()/epoll (Linux, may need CAP_NET_ADMIN)
+ * - TCP Fast Open: the transfer frame rides in the SYN of a repeat
+ *                 connection (Linux, needs net.ipv4.tcp_fastopen = 3)
+ *
+ * Profiles by name:
+ *   kernel       leave every option at the kernel default
+ *   low-latency  TCP_NODELAY + TCP_QUICKACK (default)
+ *   busy-poll    low-latency + SO_BUSY_POLL 50 us
+ *   fastopen     low-latency + TCP Fast Open
+ *
+ * The profile is process-wide: set it before the first connection.
+ */
+
+#ifndef SOCKET_PROFILE_H
+#define SOCKET_PROFILE_H
+
+#include <string>
+
+#define DEFAULT_SOCKET_PROFILE "low-latency"
+#define BUSY_POLL_US 50        // SO_BUSY_POLL of the busy-poll profile
+#define FASTOPEN_QUEUE 256     // Pending Fast Open requests per listening socket
+
+struct SocketProfile {
+    std::string name;
+    bool nodelay;
+    bool quickack;
+    int rcvbuf;        // bytes, 0 = kernel default
+    int sndbuf;        // bytes, 0 = kernel default
+    int busy_poll_us;  // 0 = off
+    bool fastopen;
+};
+
+// What a socket is used for; decides which options apply
+enum SocketRole {
+    SOCKET_SERVER,  // persistent server session
+    SOCKET_PEER,    // outgoing transfer connection
+    SOCKET_LISTEN   // P2P listening socket (and, by inheritance, what it accepts)
+};
+
+// Returns: false if name is not a known profile
+bool parse_socket_profile(const std::string& name, SocketProfile& profile);
+
+void set_socket_profile(const SocketProfile& profile);
+const SocketProfile& socket_profile();
+
+// Applies the profile to a new socket; call before connect() or listen().
+// An option the kernel refuses is reported once and then skipped.
+void tune_socket(int sock, SocketRole role);
+
+// Re-arms TCP_QUICKACK after a receive (the kernel clears it by itself).
+// No-op unless the profile asks for it.
+void rearm_quickack(int sock);
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * P2P Micropayment System - Worker Pool
+ * Course: Computer Networks (Fall 2025)
+ */
+
+#include "worker_pool.h"
+
+using namespace std;
+
+WorkerPool::WorkerPool() : running(false) {}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+void WorkerPool::start(int workers) {
+    stop();
+    running = true;
+    for (int i = 0; i < workers; i++) {
+        threads.push_back(thread(&WorkerPool::worker_loop, this));
+    }
+}
+
+void WorkerPool::stop() {
+    {
+        lock_guard<mutex> lock(pool_mutex);
+        running = false;
+    }
+    work_cv.notify_all();
+    for (thread& t : threads) {
+        t.join();
+    }
+    threads.clear();
+}
+
+/*
+ * Run Job
+ * Pops the oldest job and runs it with the lock released.
+ * Called with pool_mutex held and jobs not empty; returns with it held.
+ */
+void WorkerPool::run_job(unique_lock<mutex>& lock) {
+    Job job = jobs.front();
+    jobs.pop_front();
+    lock.unlock();
+    (*job.task)(job.begin, job.end);
+    lock.lock();
+    if (--*job.remaining == 0) {
+        done_cv.notify_all();
+    }
+}
+
+void WorkerPool::worker_loop() {
+    unique_lock<mutex> lock(pool_mutex);
+    while (true) {
+        work_cv.wait(lock, [this] { return !jobs.empty() || !running; });
+        if (jobs.empty()) {
+            return;  // Stopped; callers never leave jobs behind
+        }
+        run_job(lock);
+    }
+}
+
+/*
+ * Parallel For
+ * Queues all chunks but the first, runs the first one on the calling thread,
+ * then helps with queued jobs (its own or another caller's) until its own
+ * chunks are done, so callers never sit idle while work is waiting.
+ */
+void WorkerPool::parallel_for(size_t count, size_t grain, const RangeTask& task) {
+    size_t chunks = threads.size() + 1;
+    if (grain == 0) {
+        grain = 1;
+    }
+    if (count / grain < chunks) {
+        chunks = count / grain;
+    }
+    if (chunks <= 1) {
+        if (count > 0) {
+            task(0, count);
+        }
+        return;
+    }
+
+    size_t chunk_size = (count + chunks - 1) / chunks;
+    size_t remaining = 0;
+    {
+        lock_guard<mutex> lock(pool_mutex);
+        for (size_t begin = chunk_size; begin < count; begin += chunk_size) {
+            Job job = {&task, begin, begin + chunk_size < count ? begin + chunk_size : count, &remaining};
+            jobs.push_back(job);
+            remaining++;
+        }
+    }
+    work_cv.notify_all();
+
+    task(0, chunk_size);
+
+    unique_lock<mutex> lock(pool_mutex);
+    while (remaining > 0) {
+        if (!jobs.empty()) {
+            run_job(lock);
+        } else {
+            done_cv.wait(lock);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * P2P Micropayment System - Worker Pool
+ * Course: Computer Networks (Fall 2025)
+ *
+ * A fixed set of worker threads for splitting one batch of independent work
+ * (e.g. the signature checks of a burst of transfers) across cores.
+ * parallel_for() blocks until the whole range is done. The calling thread
+ * works on the range too, so a pool with no workers runs everything inline,
+ * and several threads (listener shards) may call parallel_for() at once.
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class WorkerPool {
+public:
+    // Processes items [begin, end)
+    typedef std::function<void(size_t begin, size_t end)> RangeTask;
+
+    WorkerPool();
+    ~WorkerPool();
+
+    // Starts workers threads (0 = run inline). Stops any previous workers first.
+    void start(int workers);
+    void stop();
+    int workers() const { return (int)threads.size(); }
+
+    // Runs task over [0, count), split into at most workers() + 1 chunks of
+    // at least grain items each
+    void parallel_for(size_t count, size_t grain, const RangeTask& task);
+
+private:
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+
+    struct Job {
+        const RangeTask* task;
+        size_t begin;
+        size_t end;
+        size_t* remaining;  // Chunks of the caller's batch still running
+    };
+
+    void worker_loop();
+    void run_job(std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread> threads;
+    std::deque<Job> jobs;            // Chunks waiting for a thread
+    std::mutex pool_mutex;           // Protects jobs, every remaining count and running
+    std::condition_variable work_cv; // Signals workers: new jobs or stop
+    std::condition_variable done_cv; // Signals callers: a chunk finished
+    bool running;
+};
+
+#endif